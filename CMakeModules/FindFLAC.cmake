@@ -0,0 +1,56 @@
+# Locate FLAC
+# This module defines XXX_FOUND, XXX_INCLUDE_DIRS and XXX_LIBRARIES standard variables
+#
+# $FLACDIR is an environment variable that would
+# correspond to the ./configure --prefix=$FLACDIR
+# used in building FLAC.
+
+SET(FLAC_SEARCH_PATHS
+	~/Library/Frameworks
+	/Library/Frameworks
+	/usr/local
+	/usr
+	/sw # Fink
+	/opt/local # DarwinPorts
+	/opt/csw # Blastwave
+	/opt
+)
+
+FIND_PATH(FLAC_INCLUDE_DIR
+	NAMES FLAC/stream_decoder.h
+	HINTS
+	$ENV{FLACDIR}
+	$ENV{FLAC_PATH}
+	PATH_SUFFIXES include
+	PATHS ${FLAC_SEARCH_PATHS}
+)
+
+FIND_LIBRARY(FLAC_LIBRARY 
+	NAMES FLAC libFLAC libFLAC_dynamic
+	HINTS
+	$ENV{FLACDIR}
+	$ENV{FLAC_PATH}
+	PATH_SUFFIXES lib lib64
+	PATHS ${FLAC_SEARCH_PATHS}
+)
+
+FIND_LIBRARY(FLAC_LIBRARY_DEBUG 
+	NAMES FLACd FLAC_d libFLACd libFLAC_d libFLAC_dynamicd
+	HINTS
+	$ENV{FLACDIR}
+	$ENV{FLAC_PATH}
+	PATH_SUFFIXES lib lib64
+	PATHS ${FLAC_SEARCH_PATHS}
+)
+
+IF(FLAC_LIBRARY)
+	IF(FLAC_LIBRARY_DEBUG)
+		SET(FLAC_LIBRARIES optimized "${FLAC_LIBRARY}" debug "${FLAC_LIBRARY_DEBUG}")
+	ELSE()
+		SET(FLAC_LIBRARIES "${FLAC_LIBRARY}")		# Could add "general" keyword, but it is optional
+	ENDIF()
+ENDIF()
+
+# handle the QUIETLY and REQUIRED arguments and set XXX_FOUND to TRUE if all listed variables are TRUE
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(FLAC DEFAULT_MSG FLAC_LIBRARIES FLAC_INCLUDE_DIR)
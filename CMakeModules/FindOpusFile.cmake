@@ -0,0 +1,57 @@
+# Locate OpusFile (and the Opus codec library it needs)
+# This module defines XXX_FOUND, XXX_INCLUDE_DIRS and XXX_LIBRARIES standard variables
+#
+# $OPUSDIR is an environment variable that would
+# correspond to the ./configure --prefix=$OPUSDIR
+# used in building Opus and OpusFile.
+
+SET(OPUSFILE_SEARCH_PATHS
+	~/Library/Frameworks
+	/Library/Frameworks
+	/usr/local
+	/usr
+	/sw # Fink
+	/opt/local # DarwinPorts
+	/opt/csw # Blastwave
+	/opt
+)
+
+# opusfile.h includes the Opus headers without the opus/ prefix
+FIND_PATH(OPUSFILE_INCLUDE_DIR
+	NAMES opusfile.h
+	HINTS
+	$ENV{OPUSFILEDIR}
+	$ENV{OPUSFILE_PATH}
+	$ENV{OPUSDIR}
+	$ENV{OPUS_PATH}
+	PATH_SUFFIXES include/opus include
+	PATHS ${OPUSFILE_SEARCH_PATHS}
+)
+
+FIND_LIBRARY(OPUSFILE_LIBRARY 
+	NAMES opusfile libopusfile
+	HINTS
+	$ENV{OPUSFILEDIR}
+	$ENV{OPUSFILE_PATH}
+	$ENV{OPUSDIR}
+	$ENV{OPUS_PATH}
+	PATH_SUFFIXES lib lib64
+	PATHS ${OPUSFILE_SEARCH_PATHS}
+)
+
+FIND_LIBRARY(OPUS_LIBRARY 
+	NAMES opus libopus
+	HINTS
+	$ENV{OPUSDIR}
+	$ENV{OPUS_PATH}
+	PATH_SUFFIXES lib lib64
+	PATHS ${OPUSFILE_SEARCH_PATHS}
+)
+
+IF(OPUSFILE_LIBRARY AND OPUS_LIBRARY)
+	SET(OPUSFILE_LIBRARIES "${OPUSFILE_LIBRARY}" "${OPUS_LIBRARY}")
+ENDIF()
+
+# handle the QUIETLY and REQUIRED arguments and set XXX_FOUND to TRUE if all listed variables are TRUE
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(OPUSFILE DEFAULT_MSG OPUSFILE_LIBRARIES OPUSFILE_INCLUDE_DIR)
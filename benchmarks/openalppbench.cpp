@@ -0,0 +1,875 @@
+/* -*-c++-*- $Id: openalppbench.cpp */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 byKenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Throughput benchmarks of the openalpp decoders, converters and mixer, for
+// regression tracking. Prints one JSON object per benchmark and line.
+
+#define _USE_MATH_DEFINES
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <osg/ArgumentParser>
+#include <osg/Timer>
+#include <osg/ref_ptr>
+#include <osgDB/FileUtils>
+#include <osgDB/FileNameUtils>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
+#include <openalpp/AudioConvert.h>
+#include <openalpp/AudioEnvironment.h>
+#include <openalpp/GroupSource.h>
+#include <openalpp/MappedFile.h>
+#include <openalpp/Resampler.h>
+#include <openalpp/Sample.h>
+#include <openalpp/Source.h>
+#include <openalpp/StreamDecoder.h>
+
+#ifndef OSGAUDIO_DATA_DIR
+#define OSGAUDIO_DATA_DIR "data"
+#endif
+
+
+/// Allocations with operator new, counted while a benchmark runs.
+/// The malloc() of the C conversion code isn't seen.
+static OpenThreads::Mutex *s_allocation_mutex = NULL;
+static unsigned long s_allocations = 0;
+static unsigned long s_allocated_bytes = 0;
+
+void *operator new(size_t size) throw (std::bad_alloc)
+{
+    if (s_allocation_mutex) {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(*s_allocation_mutex);
+        s_allocations++;
+        s_allocated_bytes += (unsigned long)size;
+    }
+
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) throw ()
+{
+    free(p);
+}
+
+
+/// A kernel to measure, run over the same input every time
+class Benchmark {
+public:
+    Benchmark(const std::string& name, unsigned int channels, unsigned int frequency)
+        : m_name(name), m_channels(channels), m_frequency(frequency), m_frames(0) {}
+    virtual ~Benchmark() {}
+
+    /// Process all of the input once
+    virtual void run() = 0;
+
+    const std::string& getName() const { return m_name; }
+    unsigned int getChannels() const { return m_channels; }
+    unsigned int getFrequency() const { return m_frequency; }
+
+    /// @return the sample frames processed by run()
+    unsigned long getFrames() const { return m_frames; }
+
+protected:
+    std::string m_name;
+    unsigned int m_channels, m_frequency;
+    unsigned long m_frames;
+};
+
+
+/// Opens and decodes a whole file, the way streams and samples are decoded
+class DecodeBenchmark : public Benchmark {
+public:
+    DecodeBenchmark(const std::string& name, const openalpp::DataBlock *file,
+                    unsigned int channels, unsigned int frequency)
+        : Benchmark(name, channels, frequency), m_file(file), m_buffer(4096) {}
+
+    void run()
+    {
+        osg::ref_ptr<openalpp::StreamDecoder> decoder =
+            openalpp::StreamDecoderRegistry::instance()->open(m_file.get());
+        if (!decoder.valid())
+            throw openalpp::FileError("Couldn't decode file");
+
+        const unsigned int frame = decoder->getChannels()*2;
+        const unsigned int length = (unsigned int)m_buffer.size() / frame * frame;
+        unsigned long frames = 0;
+        long got;
+        while ((got = decoder->read(&m_buffer[0], length)) > 0)
+            frames += got / frame;
+        m_frames = frames;
+    }
+
+protected:
+    osg::ref_ptr<const openalpp::DataBlock> m_file;
+    std::vector<char> m_buffer;
+};
+
+
+/// AudioConvert::apply() of a whole buffer, as done when loading samples
+class ConvertBenchmark : public Benchmark {
+public:
+    ConvertBenchmark(const std::string& name, const std::vector<char>& input,
+                     ALenum format, unsigned int frequency, ALenum target, unsigned int rate)
+        : Benchmark(name, format==AL_FORMAT_MONO8 || format==AL_FORMAT_MONO16 ? 1 : 2, frequency),
+        m_input(input), m_format(format), m_converter(target, rate)
+    {
+        const unsigned int bytes = format==AL_FORMAT_MONO8 || format==AL_FORMAT_STEREO8 ? 1 : 2;
+        m_frames = (unsigned long)input.size() / (bytes*m_channels);
+    }
+
+    void run()
+    {
+        unsigned int size = (unsigned int)m_input.size();
+        void *output = m_converter.apply(&m_input[0], m_format, m_frequency, size);
+        if (!output)
+            throw openalpp::FatalError("Conversion failed");
+        free(output);
+    }
+
+protected:
+    std::vector<char> m_input;
+    ALenum m_format;
+    openalpp::AudioConvert m_converter;
+};
+
+
+/// AudioConvert::convert() in FileStream sized chunks, as done when streaming
+class StreamConvertBenchmark : public ConvertBenchmark {
+public:
+    StreamConvertBenchmark(const std::string& name, const std::vector<char>& input,
+                           ALenum format, unsigned int frequency, ALenum target, unsigned int rate)
+        : ConvertBenchmark(name, input, format, frequency, target, rate)
+    {
+        m_converter.setSource(format, frequency);
+        m_output.resize(m_converter.getMaxOutput(4096));
+    }
+
+    void run()
+    {
+        const unsigned int size = (unsigned int)m_input.size();
+        const unsigned int outsize = (unsigned int)m_output.size();
+        m_converter.reset();
+
+        unsigned int position = 0;
+        while (position < size) {
+            unsigned int consumed = 0;
+            const unsigned int chunk = size-position < 4096 ? size-position : 4096;
+            m_converter.convert(&m_input[position], chunk, &m_output[0], outsize, &consumed);
+            position += consumed;
+        }
+        while (m_converter.flush(&m_output[0], outsize)) {}
+    }
+
+protected:
+    std::vector<char> m_output;
+};
+
+
+/// The polyphase resampler on its own, stereo 44100 to 48000 Hz
+class ResampleBenchmark : public Benchmark {
+public:
+    ResampleBenchmark(const std::string& name, const std::vector<short>& input,
+                      openalpp::Resampler::Quality quality)
+        : Benchmark(name, 2, 44100), m_input(input), m_quality(quality)
+    {
+        m_frames = (unsigned long)input.size() / m_channels;
+    }
+
+    void run()
+    {
+        openalpp::Resampler::resample(&m_input[0], m_frames, m_channels,
+            44100.0/48000.0, m_output, m_quality);
+    }
+
+protected:
+    std::vector<short> m_input, m_output;
+    openalpp::Resampler::Quality m_quality;
+};
+
+
+/// GroupSource::mixSources() of all the WAV effects, needs an OpenAL device
+class MixBenchmark : public Benchmark {
+public:
+    MixBenchmark(const std::string& name, openalpp::GroupSource *group,
+                 unsigned int frequency, unsigned long frames)
+        : Benchmark(name, 2, frequency), m_group(group)
+    {
+        m_frames = frames;
+    }
+
+    void run()
+    {
+        m_group->mixSources(m_frequency);
+    }
+
+protected:
+    osg::ref_ptr<openalpp::GroupSource> m_group;
+};
+
+
+static std::string quote(const std::string& s)
+{
+    std::string quoted = "\"";
+    for (unsigned int i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\')
+            quoted += '\\';
+        quoted += s[i];
+    }
+    return quoted + "\"";
+}
+
+static std::string formatName(ALenum format, unsigned int frequency)
+{
+    std::ostringstream name;
+    switch (format) {
+    case AL_FORMAT_MONO8: name << "mono8"; break;
+    case AL_FORMAT_STEREO8: name << "stereo8"; break;
+    case AL_FORMAT_MONO16: name << "mono16"; break;
+    default: name << "stereo16"; break;
+    }
+    name << "-" << frequency;
+    return name.str();
+}
+
+
+/// Run a benchmark once to warm up, then time it and print the fastest run.
+/// samples_per_second counts the samples of all channels, realtime is the
+/// duration of the sound divided by the time it took.
+static void measure(Benchmark& benchmark, unsigned int iterations)
+{
+    try {
+        benchmark.run();
+
+        double fastest = DBL_MAX;
+        unsigned long allocations = 0, allocated_bytes = 0;
+        osg::Timer timer;
+        OpenThreads::Mutex mutex;
+
+        for (unsigned int i = 0; i < iterations; i++) {
+            s_allocations = s_allocated_bytes = 0;
+            s_allocation_mutex = &mutex;
+            const osg::Timer_t start = timer.tick();
+            benchmark.run();
+            const osg::Timer_t end = timer.tick();
+            s_allocation_mutex = NULL;
+
+            fastest = std::min(fastest, timer.delta_s(start, end));
+            allocations = s_allocations;
+            allocated_bytes = s_allocated_bytes;
+        }
+        if (fastest <= 0.0)
+            fastest = DBL_MIN;
+
+        const double samples = (double)benchmark.getFrames() * benchmark.getChannels();
+        const double duration = (double)benchmark.getFrames() / benchmark.getFrequency();
+
+        std::cout << "{\"name\":" << quote(benchmark.getName())
+            << ",\"channels\":" << benchmark.getChannels()
+            << ",\"frequency\":" << benchmark.getFrequency()
+            << ",\"frames\":" << benchmark.getFrames()
+            << ",\"iterations\":" << iterations
+            << ",\"seconds\":" << fastest
+            << ",\"samples_per_second\":" << samples / fastest
+            << ",\"realtime\":" << duration / fastest
+            << ",\"allocations\":" << allocations
+            << ",\"allocated_bytes\":" << allocated_bytes
+            << "}" << std::endl;
+    }
+    catch (openalpp::Error& error) {
+        s_allocation_mutex = NULL;
+        std::cout << "{\"name\":" << quote(benchmark.getName())
+            << ",\"error\":" << quote(error.what()) << "}" << std::endl;
+    }
+}
+
+
+/// Decode a whole file to 16 bit PCM
+static bool decodeFile(const openalpp::DataBlock *file, std::vector<char>& pcm,
+                       unsigned int& channels, unsigned int& frequency)
+{
+    osg::ref_ptr<openalpp::StreamDecoder> decoder =
+        openalpp::StreamDecoderRegistry::instance()->open(file);
+    if (!decoder.valid() || !decoder->getFormat())
+        return false;
+
+    channels = decoder->getChannels();
+    frequency = decoder->getFrequency();
+
+    std::vector<char> buffer(4096*channels);
+    long got;
+    while ((got = decoder->read(&buffer[0], (unsigned int)buffer.size())) > 0)
+        pcm.insert(pcm.end(), buffer.begin(), buffer.begin()+got);
+    return got == 0 && !pcm.empty();
+}
+
+
+static void writeLE(std::vector<unsigned char>& v, unsigned int value, unsigned int bytes)
+{
+    for (unsigned int i = 0; i < bytes; i++)
+        v.push_back((unsigned char)(value >> (8*i)));
+}
+
+/// A RIFF WAV file of ADPCM blocks of 512 bytes per channel
+static void writeADPCMFile(std::vector<char>& wav, unsigned int encoding, unsigned int channels,
+                           unsigned int frequency, const std::vector<unsigned char>& data)
+{
+    const unsigned int blockalign = 512*channels;
+    const bool ms = encoding == MS_ADPCM_CODE;
+    const unsigned int header = (ms ? 7 : 4)*channels;
+    const unsigned int samples = ms ? (blockalign-header)*2/channels + 2 : (blockalign-header)*2/channels + 1;
+
+    std::vector<unsigned char> fmt;
+    writeLE(fmt, encoding, 2);
+    writeLE(fmt, channels, 2);
+    writeLE(fmt, frequency, 4);
+    writeLE(fmt, frequency*blockalign/samples, 4);
+    writeLE(fmt, blockalign, 2);
+    writeLE(fmt, 4, 2);
+    if (ms) {
+        static const short coefficients[7][2] = {
+            {256, 0}, {512, -256}, {0, 0}, {192, 64}, {240, 0}, {460, -208}, {392, -232} };
+        writeLE(fmt, 32, 2);
+        writeLE(fmt, samples, 2);
+        writeLE(fmt, 7, 2);
+        for (unsigned int i = 0; i < 7; i++) {
+            writeLE(fmt, (unsigned short)coefficients[i][0], 2);
+            writeLE(fmt, (unsigned short)coefficients[i][1], 2);
+        }
+    }
+    else {
+        writeLE(fmt, 2, 2);
+        writeLE(fmt, samples, 2);
+    }
+
+    std::vector<unsigned char> file;
+    writeLE(file, RIFF, 4);
+    writeLE(file, (unsigned int)(4 + 8+fmt.size() + 8+data.size()), 4);
+    writeLE(file, WAVE, 4);
+    writeLE(file, FMT, 4);
+    writeLE(file, (unsigned int)fmt.size(), 4);
+    file.insert(file.end(), fmt.begin(), fmt.end());
+    writeLE(file, DATA, 4);
+    writeLE(file, (unsigned int)data.size(), 4);
+    file.insert(file.end(), data.begin(), data.end());
+
+    wav.assign(file.begin(), file.end());
+}
+
+/// A RIFF WAV file of ADPCM blocks. Decoding speed doesn't depend on the
+/// sound, so the blocks are noise with valid headers.
+static void makeADPCMFile(std::vector<char>& wav, unsigned int encoding,
+                          unsigned int channels, unsigned int frequency, unsigned int blocks)
+{
+    const unsigned int blockalign = 512*channels;
+    const bool ms = encoding == MS_ADPCM_CODE;
+    const unsigned int header = (ms ? 7 : 4)*channels;
+
+    std::vector<unsigned char> data;
+    unsigned int noise = 12345;
+    for (unsigned int b = 0; b < blocks; b++) {
+        if (ms) {
+            for (unsigned int c = 0; c < channels; c++)
+                data.push_back((unsigned char)(c % 7));        // Predictor
+            for (unsigned int c = 0; c < channels; c++)
+                writeLE(data, 64, 2);                       // Delta
+            for (unsigned int c = 0; c < 2*channels; c++)
+                writeLE(data, 0, 2);                        // First samples
+        }
+        else {
+            for (unsigned int c = 0; c < channels; c++) {
+                writeLE(data, 0, 2);                        // First sample
+                data.push_back(0);                             // Step index
+                data.push_back(0);
+            }
+        }
+        for (unsigned int i = header; i < blockalign; i++) {
+            noise = noise*1103515245 + 12345;
+            data.push_back((unsigned char)(noise >> 16));
+        }
+    }
+
+    writeADPCMFile(wav, encoding, channels, frequency, data);
+}
+
+
+/// AudioConvert::apply() of an ADPCM WAV file, decoding it to 16 bit PCM
+class ADPCMBenchmark : public ConvertBenchmark {
+public:
+    ADPCMBenchmark(const std::string& name, unsigned int encoding,
+                   unsigned int channels, unsigned int frequency, unsigned int blocks)
+        : ConvertBenchmark(name, std::vector<char>(), AL_FORMAT_WAVE_EXT, frequency,
+            channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16, frequency)
+    {
+        makeADPCMFile(m_input, encoding, channels, frequency, blocks);
+        m_channels = channels;
+        m_frames = (unsigned long)blocks *
+            (encoding == MS_ADPCM_CODE ? (512-7)*2 + 2 : (512-4)*2 + 1);
+    }
+};
+
+
+static std::string s_filter;
+static unsigned int s_iterations = 5;
+
+static bool wanted(const std::string& name)
+{
+    return s_filter.empty() || name.find(s_filter) != std::string::npos;
+}
+
+static void runBenchmark(Benchmark *benchmark)
+{
+    if (wanted(benchmark->getName()))
+        measure(*benchmark, s_iterations);
+    delete benchmark;
+}
+
+
+struct SoundFile {
+    std::string name, path;
+    osg::ref_ptr<openalpp::DataBlock> file;
+    std::vector<char> pcm;
+    unsigned int channels, frequency;
+};
+
+/// Decoding and conversion of the sound files of the data directory
+static void runFileBenchmarks(const std::vector<SoundFile>& files)
+{
+    for (unsigned int i = 0; i < files.size(); i++) {
+        const SoundFile& sound = files[i];
+        const ALenum format = sound.channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+
+        runBenchmark(new DecodeBenchmark("decode/" + sound.name, sound.file.get(),
+            sound.channels, sound.frequency));
+
+        const ALenum targets[] = { AL_FORMAT_STEREO16, AL_FORMAT_MONO8, AL_FORMAT_STEREO16 };
+        const unsigned int rates[] = { sound.frequency, sound.frequency, 44100 };
+        for (unsigned int t = 0; t < 3; t++) {
+            if (t == 2 && sound.frequency == 44100)
+                continue;
+            runBenchmark(new ConvertBenchmark("convert/" + sound.name + "/" + formatName(targets[t], rates[t]),
+                sound.pcm, format, sound.frequency, targets[t], rates[t]));
+        }
+
+        runBenchmark(new StreamConvertBenchmark("stream/" + sound.name + "/" + formatName(AL_FORMAT_STEREO16, 48000),
+            sound.pcm, format, sound.frequency, AL_FORMAT_STEREO16, 48000));
+    }
+}
+
+/// Conversion, resampling and ADPCM decoding of generated sounds
+static void runSyntheticBenchmarks(unsigned int seconds)
+{
+    std::vector<short> stereo(44100*2*seconds);
+    for (unsigned int i = 0; i < stereo.size()/2; i++) {
+        stereo[2*i] = (short)(16000.0*sin(i*2.0*M_PI*440.0/44100.0));
+        stereo[2*i+1] = (short)(16000.0*sin(i*2.0*M_PI*660.0/44100.0));
+    }
+    std::vector<char> s16((char *)&stereo[0], (char *)&stereo[0] + stereo.size()*2);
+
+    std::vector<char> u8(22050*seconds);
+    for (unsigned int i = 0; i < u8.size(); i++)
+        u8[i] = (char)(128 + 100.0*sin(i*2.0*M_PI*440.0/22050.0));
+
+    const std::string sine = "synthetic/stereo16-44100";
+    runBenchmark(new ConvertBenchmark("convert/" + sine + "/mono16-44100",
+        s16, AL_FORMAT_STEREO16, 44100, AL_FORMAT_MONO16, 44100));
+    runBenchmark(new ConvertBenchmark("convert/" + sine + "/mono8-44100",
+        s16, AL_FORMAT_STEREO16, 44100, AL_FORMAT_MONO8, 44100));
+    runBenchmark(new ConvertBenchmark("convert/" + sine + "/stereo16-48000",
+        s16, AL_FORMAT_STEREO16, 44100, AL_FORMAT_STEREO16, 48000));
+    runBenchmark(new ConvertBenchmark("convert/synthetic/mono8-22050/stereo16-22050",
+        u8, AL_FORMAT_MONO8, 22050, AL_FORMAT_STEREO16, 22050));
+    runBenchmark(new ConvertBenchmark("convert/synthetic/mono8-22050/stereo16-44100",
+        u8, AL_FORMAT_MONO8, 22050, AL_FORMAT_STEREO16, 44100));
+    runBenchmark(new StreamConvertBenchmark("stream/" + sine + "/stereo16-48000",
+        s16, AL_FORMAT_STEREO16, 44100, AL_FORMAT_STEREO16, 48000));
+
+    runBenchmark(new ResampleBenchmark("resample/fast", stereo, openalpp::Resampler::Fast));
+    runBenchmark(new ResampleBenchmark("resample/medium", stereo, openalpp::Resampler::Medium));
+    runBenchmark(new ResampleBenchmark("resample/best", stereo, openalpp::Resampler::Best));
+
+    // About as long as the sine, 1012 or 1017 frames per block
+    const unsigned int blocks = 44100*seconds/1012;
+    runBenchmark(new ADPCMBenchmark("adpcm/ima/mono16-44100", IMA_ADPCM_CODE, 1, 44100, blocks));
+    runBenchmark(new ADPCMBenchmark("adpcm/ima/stereo16-44100", IMA_ADPCM_CODE, 2, 44100, blocks));
+    runBenchmark(new ADPCMBenchmark("adpcm/ms/mono16-44100", MS_ADPCM_CODE, 1, 44100, blocks));
+    runBenchmark(new ADPCMBenchmark("adpcm/ms/stereo16-44100", MS_ADPCM_CODE, 2, 44100, blocks));
+}
+
+/// Mixing the WAV files of the data directory into one group source
+static void runMixBenchmarks(const std::vector<SoundFile>& files)
+{
+    std::vector<const SoundFile *> wavs;
+    double duration = 0.0;
+    for (unsigned int i = 0; i < files.size(); i++) {
+        if (osgDB::getLowerCaseFileExtension(files[i].name) != "wav")
+            continue;
+        wavs.push_back(&files[i]);
+        duration = std::max(duration, (double)files[i].pcm.size() /
+            (2*files[i].channels*files[i].frequency));
+    }
+
+    const unsigned int rates[] = { 22050, 44100 };
+    std::vector<std::string> names;
+    for (unsigned int r = 0; r < 2; r++) {
+        std::ostringstream name;
+        name << "mix/wav/" << wavs.size() << "-sources/" << formatName(AL_FORMAT_STEREO16, rates[r]);
+        names.push_back(name.str());
+    }
+    if (wavs.empty() || (!wanted(names[0]) && !wanted(names[1])))
+        return;
+
+    // Skipped rather than failed without a device, e.g. on build servers
+    osg::ref_ptr<openalpp::AudioEnvironment> environment;
+    try {
+        environment = new openalpp::AudioEnvironment();
+    }
+    catch (openalpp::Error& error) {
+        std::cout << "{\"name\":\"mix\",\"skipped\":" << quote(error.what()) << "}" << std::endl;
+        return;
+    }
+
+    try {
+        osg::ref_ptr<openalpp::GroupSource> group = new openalpp::GroupSource();
+        std::vector<osg::ref_ptr<openalpp::Source> > sources;
+        for (unsigned int i = 0; i < wavs.size(); i++) {
+            sources.push_back(new openalpp::Source(wavs[i]->path));
+            group->includeSource(sources.back().get());
+        }
+
+        for (unsigned int r = 0; r < 2; r++)
+            runBenchmark(new MixBenchmark(names[r], group.get(), rates[r],
+                (unsigned long)(duration*rates[r])));
+    }
+    catch (openalpp::Error& error) {
+        std::cout << "{\"name\":\"mix\",\"error\":" << quote(error.what()) << "}" << std::endl;
+    }
+}
+
+
+/// IMA ADPCM step sizes and step index changes, for the reference coder
+static const int s_imaSteps[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130,
+    143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408,
+    449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282,
+    1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630,
+    9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+    22385, 24623, 27086, 29794, 32767
+};
+static const int s_imaIndex[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+/// Add the difference a nibble codes to the predictor, and step the index
+static void imaStep(int nibble, int& predictor, int& index)
+{
+    const int step = s_imaSteps[index];
+    int diff = step >> 3;
+    if (nibble & 4) diff += step;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 1) diff += step >> 2;
+    predictor = std::min(32767, std::max(-32768, nibble & 8 ? predictor-diff : predictor+diff));
+    index = std::min(88, std::max(0, index + s_imaIndex[nibble & 7]));
+}
+
+/// Encode 16 bit PCM to IMA ADPCM blocks of 512 bytes per channel, repeating
+/// the sound until there are enough blocks
+static void encodeIMAADPCM(const std::vector<char>& pcm, unsigned int channels,
+                           unsigned int blocks, std::vector<unsigned char>& data)
+{
+    const short *input = (const short *)&pcm[0];
+    const unsigned long frames = (unsigned long)pcm.size() / (2*channels);
+    std::vector<int> index(channels, 0);
+    unsigned long frame = 0;
+
+    for (unsigned int b = 0; b < blocks; b++) {
+        std::vector<int> predictor(channels);
+        for (unsigned int c = 0; c < channels; c++) {
+            predictor[c] = input[(frame % frames)*channels + c];
+            writeLE(data, (unsigned short)predictor[c], 2);
+            data.push_back((unsigned char)index[c]);
+            data.push_back(0);
+        }
+        frame++;
+
+        // Groups of 8 samples of each channel, the low nibble first
+        for (unsigned int group = 0; group < 127; group++) {
+            for (unsigned int c = 0; c < channels; c++) {
+                for (unsigned int i = 0; i < 8; i++) {
+                    const int sample = input[((frame + group*8 + i) % frames)*channels + c];
+                    int diff = sample - predictor[c];
+                    int nibble = 0;
+                    if (diff < 0) {
+                        nibble = 8;
+                        diff = -diff;
+                    }
+                    int step = s_imaSteps[index[c]];
+                    if (diff >= step) { nibble |= 4; diff -= step; }
+                    step >>= 1;
+                    if (diff >= step) { nibble |= 2; diff -= step; }
+                    step >>= 1;
+                    if (diff >= step) nibble |= 1;
+                    imaStep(nibble, predictor[c], index[c]);
+
+                    if (i & 1)
+                        data.back() |= (unsigned char)(nibble << 4);
+                    else
+                        data.push_back((unsigned char)nibble);
+                }
+            }
+        }
+        frame += 127*8;
+    }
+}
+
+/// Decode IMA ADPCM blocks of 512 bytes per channel one nibble at a time,
+/// stepping the index the way the specification describes it
+static void decodeIMAADPCM(const std::vector<unsigned char>& data, unsigned int channels,
+                           std::vector<short>& pcm)
+{
+    const unsigned int blockalign = 512*channels;
+    for (size_t block = 0; block + blockalign <= data.size(); block += blockalign) {
+        const unsigned char *p = &data[block];
+        const size_t first = pcm.size();
+        pcm.resize(first + (127*8 + 1)*channels);
+        short *out = &pcm[first];
+
+        for (unsigned int c = 0; c < channels; c++) {
+            int predictor = (short)(p[4*c] | (p[4*c+1] << 8));
+            int index = std::min(88, (int)p[4*c+2]);
+            out[c] = (short)predictor;
+            for (unsigned int group = 0; group < 127; group++) {
+                for (unsigned int i = 0; i < 8; i++) {
+                    const unsigned char byte = p[4*channels + (group*channels + c)*4 + i/2];
+                    imaStep(i & 1 ? byte >> 4 : byte & 0x0F, predictor, index);
+                    out[(1 + group*8 + i)*channels + c] = (short)predictor;
+                }
+            }
+        }
+    }
+}
+
+
+static void printCheck(const std::string& name, bool ok)
+{
+    std::cout << "{\"name\":" << quote(name) << ",\"ok\":" << (ok ? "true" : "false") << "}" << std::endl;
+}
+
+/// AudioConvert's IMA ADPCM decoder against the reference decoder, over the
+/// first file of the data directory encoded to IMA ADPCM. 600 blocks, so
+/// that it's decoded by several threads.
+static bool checkIMADecoder(const std::vector<SoundFile>& files)
+{
+    const SoundFile *sound = NULL;
+    for (unsigned int i = 0; i < files.size() && !sound; i++)
+        if (files[i].channels <= 2)
+            sound = &files[i];
+    if (!sound)
+        return true;
+
+    const std::string name = "check/adpcm/ima/" + sound->name;
+    if (!wanted(name))
+        return true;
+
+    try {
+        std::vector<unsigned char> data;
+        encodeIMAADPCM(sound->pcm, sound->channels, 600, data);
+        std::vector<short> reference;
+        decodeIMAADPCM(data, sound->channels, reference);
+
+        std::vector<char> wav;
+        writeADPCMFile(wav, IMA_ADPCM_CODE, sound->channels, sound->frequency, data);
+        openalpp::AudioConvert converter(sound->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16,
+            sound->frequency);
+        unsigned int size = (unsigned int)wav.size();
+        void *output = converter.apply(&wav[0], AL_FORMAT_WAVE_EXT, sound->frequency, size);
+        if (!output)
+            throw openalpp::FatalError("Conversion failed");
+
+        const bool ok = size == reference.size()*2 && !memcmp(output, &reference[0], size);
+        free(output);
+        printCheck(name, ok);
+        return ok;
+    }
+    catch (openalpp::Error& error) {
+        std::cout << "{\"name\":" << quote(name) << ",\"error\":" << quote(error.what()) << "}" << std::endl;
+        return false;
+    }
+}
+
+/// AudioConvert::apply() of a whole buffer against convert() of it in 4k
+/// chunks, which must give the same samples
+static bool checkChunkedConvert(const std::string& name, const std::vector<char>& input,
+                                ALenum format, unsigned int frequency, ALenum target, unsigned int rate)
+{
+    if (!wanted(name))
+        return true;
+
+    try {
+        openalpp::AudioConvert converter(target, rate);
+        std::vector<char> copy(input);
+        unsigned int size = (unsigned int)copy.size();
+        void *whole = converter.apply(&copy[0], format, frequency, size);
+        if (!whole)
+            throw openalpp::FatalError("Conversion failed");
+        const std::vector<char> applied((char *)whole, (char *)whole + size);
+        free(whole);
+
+        converter.setSource(format, frequency);
+        std::vector<char> output(converter.getMaxOutput(4096)), chunked;
+        const unsigned int outsize = (unsigned int)output.size();
+        unsigned int position = 0, written;
+        while (position < input.size()) {
+            unsigned int consumed = 0;
+            const unsigned int chunk = std::min((unsigned int)input.size()-position, 4096u);
+            written = converter.convert(&input[position], chunk, &output[0], outsize, &consumed);
+            chunked.insert(chunked.end(), output.begin(), output.begin()+written);
+            position += consumed;
+        }
+        while ((written = converter.flush(&output[0], outsize)) > 0)
+            chunked.insert(chunked.end(), output.begin(), output.begin()+written);
+
+        const bool ok = applied == chunked;
+        printCheck(name, ok);
+        return ok;
+    }
+    catch (openalpp::Error& error) {
+        std::cout << "{\"name\":" << quote(name) << ",\"error\":" << quote(error.what()) << "}" << std::endl;
+        return false;
+    }
+}
+
+/// Checks of the kernels against simpler implementations of them, so that the
+/// optimized code paths can't silently change the sound
+static bool runChecks(const std::vector<SoundFile>& files, unsigned int seconds)
+{
+    bool ok = checkIMADecoder(files);
+
+    // 8 bit targets are where quantizing before resampling would show
+    std::vector<char> s16(44100*seconds*4);
+    short *stereo = (short *)&s16[0];
+    for (unsigned int i = 0; i < s16.size()/4; i++) {
+        stereo[2*i] = (short)(16000.0*sin(i*2.0*M_PI*440.0/44100.0));
+        stereo[2*i+1] = (short)(16000.0*sin(i*2.0*M_PI*660.0/44100.0));
+    }
+    const std::string sine = "check/chunked/synthetic/stereo16-44100";
+    ok = checkChunkedConvert(sine + "/mono8-22050", s16, AL_FORMAT_STEREO16, 44100, AL_FORMAT_MONO8, 22050) && ok;
+    ok = checkChunkedConvert(sine + "/stereo8-48000", s16, AL_FORMAT_STEREO16, 44100, AL_FORMAT_STEREO8, 48000) && ok;
+    ok = checkChunkedConvert(sine + "/stereo16-48000", s16, AL_FORMAT_STEREO16, 44100, AL_FORMAT_STEREO16, 48000) && ok;
+
+    for (unsigned int i = 0; i < files.size(); i++) {
+        const SoundFile& sound = files[i];
+        if (sound.channels > 2)
+            continue;
+        const ALenum format = sound.channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+        ok = checkChunkedConvert("check/chunked/" + sound.name + "/mono8-44100",
+            sound.pcm, format, sound.frequency, AL_FORMAT_MONO8, 44100) && ok;
+    }
+    return ok;
+}
+
+
+int main( int argc, char **argv )
+{
+    osg::ArgumentParser arguments(&argc, argv);
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" measures the throughput of the openalpp decoders, converters and mixer, and prints the results as JSON lines.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options]");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help", "Display this information");
+    arguments.getApplicationUsage()->addCommandLineOption("--data <directory>", "Directory of the sound files, default " OSGAUDIO_DATA_DIR);
+    arguments.getApplicationUsage()->addCommandLineOption("--iterations <n>", "Timed runs of each benchmark, the fastest is reported. Default 5.");
+    arguments.getApplicationUsage()->addCommandLineOption("--filter <text>", "Only run the benchmarks and checks with text in their name, e.g. decode/, adpcm/ or check/.");
+    arguments.getApplicationUsage()->addCommandLineOption("--seconds <n>", "Length of the generated sounds, default 10.");
+
+    if (arguments.read("-h") || arguments.read("--help")) {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 0;
+    }
+
+    std::string directory = OSGAUDIO_DATA_DIR;
+    while (arguments.read("--data", directory)) {}
+    while (arguments.read("--iterations", s_iterations)) {}
+    while (arguments.read("--filter", s_filter)) {}
+    unsigned int seconds = 10;
+    while (arguments.read("--seconds", seconds)) {}
+
+    arguments.reportRemainingOptionsAsUnrecognized();
+    if (arguments.errors()) {
+        arguments.writeErrorMessages(std::cerr);
+        return 1;
+    }
+    if (s_iterations < 1)
+        s_iterations = 1;
+    if (seconds < 1)
+        seconds = 1;
+
+    // All sound files of the data directory, decoded up front
+    std::vector<SoundFile> files;
+    osgDB::DirectoryContents contents = osgDB::getDirectoryContents(directory);
+    std::sort(contents.begin(), contents.end());
+    for (unsigned int i = 0; i < contents.size(); i++) {
+        const std::string path = osgDB::concatPaths(directory, contents[i]);
+        if (osgDB::fileType(path) != osgDB::REGULAR_FILE)
+            continue;
+
+        try {
+            SoundFile sound;
+            sound.name = contents[i];
+            sound.path = path;
+            sound.file = new openalpp::MappedFile(path);
+            const size_t probe = sound.file->size() < 4096 ? sound.file->size() : 4096;
+            if (!openalpp::StreamDecoderRegistry::instance()->canDecode(sound.file->data(), probe))
+                continue;
+            if (decodeFile(sound.file.get(), sound.pcm, sound.channels, sound.frequency))
+                files.push_back(sound);
+            else
+                std::cerr << "Skipping " << path << ", couldn't decode it" << std::endl;
+        }
+        catch (openalpp::Error& error) {
+            std::cerr << "Skipping " << path << ": " << error.what() << std::endl;
+        }
+    }
+    if (files.empty())
+        std::cerr << "No sound files in " << directory << ", see --data" << std::endl;
+
+    runFileBenchmarks(files);
+    runSyntheticBenchmarks(seconds);
+    runMixBenchmarks(files);
+    const bool ok = runChecks(files, seconds);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,497 @@
+/* -*-c++-*- $Id: osgaudiobench.cpp */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 byKenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Microbenchmarks of the osgAudio control plane: source allocation, sound
+// events, SoundState::apply(), scene graph traversal and cache lookups.
+// Prints one JSON object per benchmark and line, with the time per operation
+// in nanoseconds.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <osg/ArgumentParser>
+#include <osg/FrameStamp>
+#include <osg/Group>
+#include <osg/MatrixTransform>
+#include <osg/NodeVisitor>
+#include <osg/Notify>
+#include <osg/Timer>
+#include <osg/ref_ptr>
+#include <osgDB/FileUtils>
+#include <osgDB/FileNameUtils>
+
+#include <osgAudio/SoundManager.h>
+#include <osgAudio/SoundNode.h>
+#include <osgAudio/SoundState.h>
+#include <osgAudio/SoundUpdateCB.h>
+
+#ifndef OSGAUDIO_DATA_DIR
+#define OSGAUDIO_DATA_DIR "data"
+#endif
+
+
+/// An operation to measure. Batches of it are timed, so that operations
+/// much shorter than the timer resolution can be measured.
+class Benchmark {
+public:
+    Benchmark(const std::string& name, unsigned int batch) : m_name(name), m_batch(batch) {}
+    virtual ~Benchmark() {}
+
+    /// Do the operation m_batch times
+    virtual void run() = 0;
+
+    /// Undo what run() did, e.g. release what it allocated. Not timed.
+    virtual void reset() {}
+
+    const std::string& getName() const { return m_name; }
+    unsigned int getBatch() const { return m_batch; }
+
+protected:
+    std::string m_name;
+    unsigned int m_batch;
+};
+
+
+/// allocateSource() and releaseSource() of one source
+class SourceChurnBenchmark : public Benchmark {
+public:
+    SourceChurnBenchmark(unsigned int batch) : Benchmark("source/allocate-release", batch) {}
+
+    void run()
+    {
+        osgAudio::SoundManager *manager = osgAudio::SoundManager::instance();
+        for (unsigned int i = 0; i < m_batch; i++) {
+            osgAudio::Source *source = manager->allocateSource(i % 4);
+            if (source)
+                manager->releaseSource(source);
+        }
+    }
+};
+
+
+/// pushSoundEvent() of depth events, and processQueuedSoundStates() of them
+class SoundEventBenchmark : public Benchmark {
+public:
+    SoundEventBenchmark(const std::string& name, osgAudio::SoundState *event, unsigned int depth)
+        : Benchmark(name, depth), m_event(event) {}
+
+    void run()
+    {
+        osgAudio::SoundManager *manager = osgAudio::SoundManager::instance();
+        for (unsigned int i = 0; i < m_batch; i++)
+            manager->pushSoundEvent(m_event.get(), i % 4);
+        manager->processQueuedSoundStates();
+    }
+
+    void reset()
+    {
+        // Stopped events give their sources and states back
+        osgAudio::SoundManager::instance()->stopAllSources();
+        osgAudio::SoundManager::instance()->update();
+    }
+
+protected:
+    osg::ref_ptr<osgAudio::SoundState> m_event;
+};
+
+
+/// SoundState::apply() of some changed fields, on a state with a source
+class ApplyBenchmark : public Benchmark {
+public:
+    enum Fields { Gain, Pitch, Position, Velocity, Direction, Distances, Cone, Flags, Occluded, Motion, All };
+
+    ApplyBenchmark(const std::string& name, osgAudio::SoundState *state, Fields fields,
+                   unsigned int batch, osgAudio::SoundState *all)
+        : Benchmark(name, batch), m_state(state), m_fields(fields), m_all(all) {}
+
+    void run()
+    {
+        osgAudio::SoundState *state = m_state.get();
+        for (unsigned int i = 0; i < m_batch; i++) {
+            // Alternate the values, so that nothing can skip an unchanged one
+            const float f = (i & 1) ? 0.5f : 1.0f;
+            const osg::Vec3 v(f, 1.0f, -f);
+
+            switch (m_fields) {
+            case Gain: state->setGain(f); break;
+            case Pitch: state->setPitch(f); break;
+            case Position: state->setPosition(v); break;
+            case Velocity: state->setVelocity(v); break;
+            case Direction: state->setDirection(v); break;
+            case Distances:
+                state->setReferenceDistance(f);
+                state->setMaxDistance(100.0f*f);
+                state->setRolloffFactor(f);
+                break;
+            case Cone: state->setSoundCone(90.0f*f, 180.0f, f); break;
+            case Flags:
+                state->setAmbient((i & 1) != 0);
+                state->setRelative((i & 1) != 0);
+                break;
+            case Occluded: state->setOccluded((i & 1) != 0); break;
+            case Motion:
+                // What SoundUpdateCB sets every update
+                state->setPosition(v);
+                state->setVelocity(v);
+                state->setDirection(v);
+                break;
+            case All:
+                *state = *m_all;
+                state->apply();
+                break;
+            }
+        }
+    }
+
+protected:
+    osg::ref_ptr<osgAudio::SoundState> m_state;
+    Fields m_fields;
+    osg::ref_ptr<osgAudio::SoundState> m_all;
+};
+
+
+/// One frame of a scene graph with an emitter per transform. The first
+/// emitters have sources, as many as the SoundManager has.
+class TraversalBenchmark : public Benchmark {
+public:
+    TraversalBenchmark(const std::string& name, osg::Node *scene, osg::NodeVisitor::VisitorType type)
+        : Benchmark(name, 1), m_scene(scene), m_visitor(type, osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+        m_frame_stamp(new osg::FrameStamp), m_frame(0)
+    {
+        m_visitor.setFrameStamp(m_frame_stamp.get());
+    }
+
+    void run()
+    {
+        // Far enough apart that every emitter updates every frame
+        m_frame++;
+        m_frame_stamp->setFrameNumber(m_frame);
+        m_frame_stamp->setReferenceTime(m_frame * 0.1);
+        m_visitor.setTraversalNumber(m_frame);
+        m_scene->accept(m_visitor);
+    }
+
+protected:
+    osg::ref_ptr<osg::Node> m_scene;
+    osg::NodeVisitor m_visitor;
+    osg::ref_ptr<osg::FrameStamp> m_frame_stamp;
+    unsigned int m_frame;
+};
+
+
+/// SoundManager::getSample() of cached files, or findSoundState() of named states
+class LookupBenchmark : public Benchmark {
+public:
+    LookupBenchmark(const std::string& name, const std::vector<std::string>& keys, bool states)
+        : Benchmark(name, (unsigned int)keys.size()), m_keys(keys), m_states(states) {}
+
+    void run()
+    {
+        osgAudio::SoundManager *manager = osgAudio::SoundManager::instance();
+        for (unsigned int i = 0; i < m_batch; i++) {
+            if (m_states)
+                manager->findSoundState(m_keys[i]);
+            else
+                manager->getSample(m_keys[i]);
+        }
+    }
+
+protected:
+    std::vector<std::string> m_keys;
+    bool m_states;
+};
+
+
+static std::string quote(const std::string& s)
+{
+    std::string quoted = "\"";
+    for (unsigned int i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\')
+            quoted += '\\';
+        quoted += s[i];
+    }
+    return quoted + "\"";
+}
+
+
+static std::string s_filter;
+static unsigned int s_samples = 1000;
+
+/// Time s_samples batches after a warm up batch, and print the nanoseconds
+/// per operation. The percentiles are of the batch averages.
+static void measure(Benchmark *benchmark)
+{
+    if (!s_filter.empty() && benchmark->getName().find(s_filter) == std::string::npos) {
+        delete benchmark;
+        return;
+    }
+
+    try {
+        benchmark->run();
+        benchmark->reset();
+
+        osg::Timer timer;
+        std::vector<double> ns(s_samples);
+        for (unsigned int i = 0; i < s_samples; i++) {
+            const osg::Timer_t start = timer.tick();
+            benchmark->run();
+            const osg::Timer_t end = timer.tick();
+            benchmark->reset();
+            ns[i] = timer.delta_n(start, end) / benchmark->getBatch();
+        }
+
+        double sum = 0.0;
+        for (unsigned int i = 0; i < ns.size(); i++)
+            sum += ns[i];
+        std::sort(ns.begin(), ns.end());
+        const unsigned int last = (unsigned int)ns.size() - 1;
+
+        std::cout << "{\"name\":" << quote(benchmark->getName())
+            << ",\"operations\":" << (unsigned long)s_samples * benchmark->getBatch()
+            << ",\"batch\":" << benchmark->getBatch()
+            << ",\"mean_ns\":" << sum / ns.size()
+            << ",\"min_ns\":" << ns[0]
+            << ",\"p50_ns\":" << ns[last/2]
+            << ",\"p90_ns\":" << ns[last*9/10]
+            << ",\"p99_ns\":" << ns[last*99/100]
+            << ",\"max_ns\":" << ns[last]
+            << "}" << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cout << "{\"name\":" << quote(benchmark->getName())
+            << ",\"error\":" << quote(e.what()) << "}" << std::endl;
+    }
+
+    delete benchmark;
+}
+
+
+/// A group of count transforms, each with a SoundNode or a SoundUpdateCB
+static osg::Node *createEmitters(osgAudio::Sample *sample, unsigned int count, bool callbacks)
+{
+    osg::Group *root = new osg::Group;
+    osgAudio::SoundManager *manager = osgAudio::SoundManager::instance();
+
+    for (unsigned int i = 0; i < count; i++) {
+        std::ostringstream name;
+        name << "emitter" << i;
+        osgAudio::SoundState *state = new osgAudio::SoundState(name.str());
+        state->setSample(sample);
+        state->setLooping(true);
+        state->setPlay(true);
+        if (manager->getNumAvailableSources())
+            state->allocateSource(10);
+
+        osg::MatrixTransform *transform = new osg::MatrixTransform(
+            osg::Matrix::translate((float)(i % 100), (float)(i / 100 % 100), (float)(i / 10000)));
+        if (callbacks) {
+            transform->setUpdateCallback(new osgAudio::SoundUpdateCB(state));
+        }
+        else {
+            osgAudio::SoundNode *node = new osgAudio::SoundNode(state);
+            transform->addChild(node);
+        }
+        root->addChild(transform);
+    }
+
+    return root;
+}
+
+/// Sound nodes and update callbacks of 1k to 100k emitters
+static void runTraversalBenchmarks(osgAudio::Sample *sample)
+{
+    const unsigned int counts[] = { 1000, 10000, 100000 };
+    for (unsigned int c = 0; c < 3; c++) {
+        for (unsigned int callbacks = 0; callbacks < 2; callbacks++) {
+            std::ostringstream name;
+            name << (callbacks ? "callback" : "node") << "/traverse/" << counts[c];
+            if (!s_filter.empty() && name.str().find(s_filter) == std::string::npos)
+                continue;
+
+            // Few samples, the large scenes take a while per frame
+            const unsigned int samples = s_samples;
+            s_samples = std::max(10u, std::min(s_samples, 10000000u / counts[c]));
+
+            osg::ref_ptr<osg::Node> scene = createEmitters(sample, counts[c], callbacks != 0);
+            measure(new TraversalBenchmark(name.str(), scene.get(),
+                callbacks ? osg::NodeVisitor::UPDATE_VISITOR : osg::NodeVisitor::CULL_VISITOR));
+            s_samples = samples;
+        }
+    }
+}
+
+
+int main( int argc, char **argv )
+{
+    osg::ArgumentParser arguments(&argc, argv);
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" measures the time of osgAudio control operations, and prints the results as JSON lines.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options]");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help", "Display this information");
+    arguments.getApplicationUsage()->addCommandLineOption("--data <directory>", "Directory of the sound files, default " OSGAUDIO_DATA_DIR);
+    arguments.getApplicationUsage()->addCommandLineOption("--samples <n>", "Timed batches of each benchmark, default 1000.");
+    arguments.getApplicationUsage()->addCommandLineOption("--filter <text>", "Only run the benchmarks with text in their name, e.g. apply/.");
+    arguments.getApplicationUsage()->addCommandLineOption("--sources <n>", "Sources of the SoundManager, default 128.");
+    arguments.getApplicationUsage()->addCommandLineOption("--hardware", "Use the default output device. Otherwise a loopback device is used, or OpenAL Soft's null device when loopback isn't available. Both work without sound hardware.");
+
+    if (arguments.read("-h") || arguments.read("--help")) {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 0;
+    }
+
+    std::string directory = OSGAUDIO_DATA_DIR;
+    while (arguments.read("--data", directory)) {}
+    while (arguments.read("--samples", s_samples)) {}
+    while (arguments.read("--filter", s_filter)) {}
+    unsigned int num_sources = 128;
+    while (arguments.read("--sources", num_sources)) {}
+    const bool hardware = arguments.read("--hardware");
+
+    arguments.reportRemainingOptionsAsUnrecognized();
+    if (arguments.errors()) {
+        arguments.writeErrorMessages(std::cerr);
+        return 1;
+    }
+    if (s_samples < 1)
+        s_samples = 1;
+
+    if (!hardware) {
+        try {
+            osgAudio::AudioEnvironment::instance()->initLoopback();
+        }
+        catch (std::exception&) {
+            // ALSOFT_DRIVERS picks the OpenAL Soft backend, unless it is set already
+            if (!getenv("ALSOFT_DRIVERS")) {
+#ifdef WIN32
+                _putenv("ALSOFT_DRIVERS=null");
+#else
+                setenv("ALSOFT_DRIVERS", "null", 0);
+#endif
+            }
+        }
+    }
+
+    // Running out of sources is expected, don't time the warnings
+    osg::setNotifyLevel(osg::FATAL);
+
+    osgAudio::SoundManager *manager = osgAudio::SoundManager::instance();
+    try {
+        manager->init(num_sources);
+    }
+    catch (std::exception& e) {
+        std::cerr << "Couldn't initialize the sound system: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // The WAV effects, for the states and the sample cache
+    std::vector<std::string> files;
+    osgDB::DirectoryContents contents = osgDB::getDirectoryContents(directory);
+    std::sort(contents.begin(), contents.end());
+    for (unsigned int i = 0; i < contents.size(); i++) {
+        if (osgDB::getLowerCaseFileExtension(contents[i]) == "wav")
+            files.push_back(osgDB::concatPaths(directory, contents[i]));
+    }
+
+    osg::ref_ptr<osgAudio::Sample> sample;
+    for (unsigned int i = 0; i < files.size() && !sample.valid(); i++) {
+        try {
+            sample = manager->getSample(files[i]);
+        }
+        catch (std::exception& e) {
+            std::cerr << "Skipping " << files[i] << ": " << e.what() << std::endl;
+        }
+    }
+    if (!sample.valid()) {
+        std::cerr << "No WAV files in " << directory << ", see --data" << std::endl;
+        manager->shutdown();
+        return 1;
+    }
+
+    measure(new SourceChurnBenchmark(64));
+
+    // The fly weight of SoundManager holds 100 events
+    osg::ref_ptr<osgAudio::SoundState> event = new osgAudio::SoundState("event");
+    event->setSample(sample.get());
+    event->setPlay(true);
+    const unsigned int depths[] = { 1, 8, 32, 100 };
+    for (unsigned int d = 0; d < 4; d++) {
+        const unsigned int depth = std::min(depths[d], num_sources);
+        std::ostringstream name;
+        name << "event/push-process/" << depth;
+        measure(new SoundEventBenchmark(name.str(), event.get(), depth));
+    }
+
+    // Assigning the state without a source marks all fields of the other
+    osg::ref_ptr<osgAudio::SoundState> all = new osgAudio::SoundState("all");
+    all->setSample(sample.get());
+    all->setLooping(true);
+    osg::ref_ptr<osgAudio::SoundState> state = new osgAudio::SoundState(*all);
+    state->setName("apply");
+    if (state->allocateSource(10)) {
+        static const char *fields[] = { "gain", "pitch", "position", "velocity", "direction",
+            "distances", "cone", "flags", "occluded", "motion", "all" };
+        for (unsigned int f = 0; f <= ApplyBenchmark::All; f++)
+            measure(new ApplyBenchmark(std::string("apply/") + fields[f], state.get(),
+                (ApplyBenchmark::Fields)f, 64, all.get()));
+        state->releaseSource();
+    }
+    state = 0;
+
+    std::vector<std::string> keys;
+    for (unsigned int i = 0; i < files.size(); i++) {
+        try {
+            manager->getSample(files[i]);
+            keys.push_back(files[i]);
+        }
+        catch (std::exception&) {}
+    }
+    measure(new LookupBenchmark("cache/sample", keys, false));
+
+    keys.clear();
+    std::vector<osg::ref_ptr<osgAudio::SoundState> > named;
+    for (unsigned int i = 0; i < 1000; i++) {
+        std::ostringstream name;
+        name << "state" << i;
+        named.push_back(new osgAudio::SoundState(name.str()));
+        manager->addSoundState(named.back().get());
+        if (i % 10 == 0)
+            keys.push_back(name.str());
+    }
+    measure(new LookupBenchmark("cache/sound-state/1000", keys, true));
+    for (unsigned int i = 0; i < named.size(); i++)
+        manager->removeSoundState(named[i].get());
+    named.clear();
+
+    runTraversalBenchmarks(sample.get());
+
+    sample = 0;
+    event = 0;
+    manager->shutdown();
+    return 0;
+}
@@ -0,0 +1,132 @@
+/* -*-c++-*- $Id: osgaudiobank.cpp */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 byKenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+// Builds a sound bank from directories of sound files, for
+// osgAudio::SoundManager::mountSoundBank().
+
+#include <iostream>
+
+#include <osg/ArgumentParser>
+#include <osg/ref_ptr>
+#include <osgDB/FileUtils>
+#include <osgDB/FileNameUtils>
+
+#include <openalpp/SoundBank.h>
+#include <openalpp/MappedFile.h>
+
+
+/// Add all sound files below a directory, named by their path relative to the root
+unsigned int addDirectory(openalpp::SoundBankWriter& writer, const std::string& root,
+                          const std::string& relative, bool decode)
+{
+    unsigned int added = 0;
+    const std::string dir = relative.empty() ? root : osgDB::concatPaths(root, relative);
+    osgDB::DirectoryContents contents = osgDB::getDirectoryContents(dir);
+
+    for (unsigned int i = 0; i < contents.size(); i++) {
+        const std::string& name = contents[i];
+        if (name == "." || name == "..")
+            continue;
+
+        const std::string entry = relative.empty() ? name : relative + "/" + name;
+        const std::string path = osgDB::concatPaths(root, entry);
+
+        if (osgDB::fileType(path) == osgDB::DIRECTORY) {
+            added += addDirectory(writer, root, entry, decode);
+            continue;
+        }
+
+        try {
+            osg::ref_ptr<openalpp::DataBlock> file = new openalpp::MappedFile(path);
+            if (writer.add(entry, file.get(), decode)) {
+                std::cout << "  " << entry << std::endl;
+                added++;
+            }
+            else
+                std::cout << "  skipping " << entry << ", not a sound file" << std::endl;
+        }
+        catch (openalpp::Error& error) {
+            std::cerr << "  skipping " << entry << ": " << error.what() << std::endl;
+        }
+    }
+
+    return added;
+}
+
+
+int main( int argc, char **argv )
+{
+    osg::ArgumentParser arguments(&argc, argv);
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" builds an osgAudio sound bank from directories of sound files.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options] bankfile directory...");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help", "Display this information");
+    arguments.getApplicationUsage()->addCommandLineOption("--decode", "Store the sounds decoded to 16 bit PCM, rather than as the files are. Loads faster, takes more room.");
+    arguments.getApplicationUsage()->addCommandLineOption("--align <bytes>", "Alignment of the sounds in the bank, default 16.");
+    arguments.getApplicationUsage()->addCommandLineOption("--rate <hz>", "Resample decoded sounds to this frequency, e.g. the one of the device.");
+
+    if (arguments.read("-h") || arguments.read("--help") || arguments.argc() < 3) {
+        arguments.getApplicationUsage()->write(std::cout);
+        return arguments.argc() < 3 ? 1 : 0;
+    }
+
+    bool decode = arguments.read("--decode");
+    unsigned int alignment = 16;
+    while (arguments.read("--align", alignment)) {}
+    unsigned int frequency = 0;
+    while (arguments.read("--rate", frequency)) {}
+
+    arguments.reportRemainingOptionsAsUnrecognized();
+    if (arguments.errors()) {
+        arguments.writeErrorMessages(std::cerr);
+        return 1;
+    }
+
+    const std::string bankfile = arguments[1];
+    openalpp::SoundBankWriter writer(alignment);
+    writer.setFrequency(frequency);
+
+    for (int i = 2; i < arguments.argc(); i++) {
+        std::cout << "Adding " << arguments[i] << std::endl;
+        addDirectory(writer, arguments[i], std::string(), decode);
+    }
+
+    if (!writer.getNumSounds()) {
+        std::cerr << "No sound files found" << std::endl;
+        return 1;
+    }
+
+    try {
+        writer.write(bankfile);
+    }
+    catch (openalpp::Error& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << writer.getNumSounds() << " sounds to " << bankfile << std::endl;
+    return 0;
+}
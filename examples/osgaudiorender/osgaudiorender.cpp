@@ -0,0 +1,415 @@
+/* -*-c++-*- $Id: osgaudiorender.cpp */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 byKenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Renders the sound of a scene along a recorded camera path to a WAV file,
+// stepping the frames at a fixed time step on a loopback device instead of
+// playing in realtime.
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <osg/ArgumentParser>
+#include <osg/AnimationPath>
+#include <osg/Camera>
+#include <osg/DeleteHandler>
+#include <osg/FrameStamp>
+#include <osg/Group>
+#include <osg/NodeVisitor>
+#include <osg/Notify>
+#include <osg/Timer>
+#include <osgDB/ReadFile>
+#include <osgGA/AnimationPathManipulator>
+#include <osgUtil/UpdateVisitor>
+
+#include <osgAudio/SoundManager.h>
+#include <osgAudio/SoundRoot.h>
+
+#define OSGAUDIO_DEFAULT_MAX_SOUNDSOURCES_ALLOWED 16
+#define OSGAUDIO_DEFAULT_GAIN 1.0
+#define OSGAUDIO_DEFAULT_DOPPLER_FACTOR 1.0
+#define OSGAUDIO_DEFAULT_DISTANCE_MODEL osgAudio::InverseDistance
+
+/// Removes the SoundRoot nodes of the loaded scene, which have no camera to follow
+class RemoveSoundRootNodesVisitor : public osg::NodeVisitor {
+
+public :
+    RemoveSoundRootNodesVisitor() : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN) {}
+
+    virtual void apply(osg::Group &group ) {
+        for (unsigned int i = 0; i<group.getNumChildren(); ) {
+            if( dynamic_cast<osgAudio::SoundRoot*>(group.getChild(i)) ) {
+                group.removeChild(i);
+            } else {
+                group.getChild(i)->accept(*this);
+                i++;
+            }
+        }
+    }
+};
+
+
+/// Writes a PCM or float WAV file, WAVE_FORMAT_EXTENSIBLE for more than two channels
+class WavWriter {
+
+public :
+    WavWriter(const std::string& filename, unsigned int frequency, unsigned int channels, bool floating)
+        : m_file(filename.c_str(), std::ios::out | std::ios::binary),
+        m_frequency(frequency), m_channels(channels), m_floating(floating), m_frames(0)
+    {
+        writeHeader();
+    }
+
+    ~WavWriter() { close(); }
+
+    bool good() const { return m_file.good(); }
+
+    /// Write frames of native endian samples, as rendered
+    void write(const void *data, unsigned int frames)
+    {
+        const unsigned int count = frames * m_channels;
+        m_bytes.resize(count * getSampleSize());
+
+        unsigned char *out = m_bytes.empty() ? 0 : &m_bytes[0];
+        if (m_floating) {
+            const float *in = static_cast<const float *>(data);
+            for (unsigned int i = 0; i < count; i++, out += 4) {
+                unsigned int v;
+                memcpy(&v, &in[i], 4);
+                put32(out, v);
+            }
+        }
+        else {
+            const short *in = static_cast<const short *>(data);
+            for (unsigned int i = 0; i < count; i++, out += 2)
+                put16(out, (unsigned short)in[i]);
+        }
+
+        m_file.write(reinterpret_cast<const char *>(m_bytes.empty() ? 0 : &m_bytes[0]), m_bytes.size());
+        m_frames += frames;
+    }
+
+    /// Patch the sizes in the header and close the file
+    void close()
+    {
+        if (!m_file.is_open())
+            return;
+        m_file.seekp(0);
+        writeHeader();
+        m_file.close();
+    }
+
+private :
+    unsigned int getSampleSize() const { return m_floating ? 4 : 2; }
+
+    static void put16(unsigned char *p, unsigned short v) { p[0] = v & 0xff; p[1] = v >> 8; }
+    static void put32(unsigned char *p, unsigned int v) { put16(p, v & 0xffff); put16(p + 2, v >> 16); }
+
+    /// The speakers of the OpenAL channel layouts, as a WAVEFORMATEXTENSIBLE dwChannelMask
+    unsigned int getChannelMask() const
+    {
+        switch (m_channels) {
+            case 1: return 0x4;   // FC
+            case 2: return 0x3;   // FL FR
+            case 4: return 0x33;  // FL FR BL BR
+            case 6: return 0x60f; // FL FR FC LFE SL SR
+            case 7: return 0x70f; // FL FR FC LFE BC SL SR
+            case 8: return 0x63f; // FL FR FC LFE BL BR SL SR
+            default: return 0;
+        }
+    }
+
+    void writeHeader()
+    {
+        const bool extensible = m_channels > 2;
+        const unsigned int format_size = extensible ? 40 : 16;
+        const unsigned int data_size = m_frames * m_channels * getSampleSize();
+        const unsigned short format_tag = m_floating ? 3 : 1; // WAVE_FORMAT_IEEE_FLOAT, WAVE_FORMAT_PCM
+
+        unsigned char header[68];
+        unsigned char *p = header;
+        memcpy(p, "RIFF", 4); put32(p + 4, 4 + 8 + format_size + 8 + data_size); memcpy(p + 8, "WAVE", 4); p += 12;
+        memcpy(p, "fmt ", 4); put32(p + 4, format_size); p += 8;
+        put16(p, extensible ? 0xfffe : format_tag);
+        put16(p + 2, m_channels);
+        put32(p + 4, m_frequency);
+        put32(p + 8, m_frequency * m_channels * getSampleSize());
+        put16(p + 12, m_channels * getSampleSize());
+        put16(p + 14, 8 * getSampleSize());
+        p += 16;
+        if (extensible) {
+            put16(p, 22);
+            put16(p + 2, 8 * getSampleSize());
+            put32(p + 4, getChannelMask());
+            // KSDATAFORMAT_SUBTYPE_PCM or _IEEE_FLOAT
+            static const unsigned char guid[14] = {
+                0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+            put16(p + 8, format_tag);
+            memcpy(p + 10, guid, sizeof(guid));
+            p += 24;
+        }
+        memcpy(p, "data", 4); put32(p + 4, data_size); p += 8;
+
+        m_file.write(reinterpret_cast<const char *>(header), p - header);
+    }
+
+    std::ofstream m_file;
+    unsigned int m_frequency, m_channels;
+    bool m_floating;
+    unsigned int m_frames;
+    std::vector<unsigned char> m_bytes;
+};
+
+
+int main( int argc, char **argv )
+{
+    // use an ArgumentParser object to manage the program arguments.
+    osg::ArgumentParser arguments(&argc,argv);
+
+    // set up the usage document, in case we need to print out how to use this program.
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" renders the sounds of a scene heard along an animation path to a WAV file, faster than realtime.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options] filename ...");
+    arguments.getApplicationUsage()->addCommandLineOption("-h or --help","Display command line paramters");
+    arguments.getApplicationUsage()->addCommandLineOption("-p or --path <file>","The camera animation path, as recorded by osgviewer. Without one the listener stays at the origin.");
+    arguments.getApplicationUsage()->addCommandLineOption("-o or --output <file>","The WAV file to write, default render.wav");
+    arguments.getApplicationUsage()->addCommandLineOption("--duration <s>","Seconds to render, default the length of the path.");
+    arguments.getApplicationUsage()->addCommandLineOption("--fps <n>","Frames per simulated second, default 60.");
+    arguments.getApplicationUsage()->addCommandLineOption("--frequency <n>","Sample rate of the output, default 48000.");
+    arguments.getApplicationUsage()->addCommandLineOption("--channels <n>","Channels of the output: 1, 2, 4, 6 (5.1), 7 (6.1) or 8 (7.1), default 2.");
+    arguments.getApplicationUsage()->addCommandLineOption("--float","Write 32 bit float samples instead of 16 bit integers.");
+    arguments.getApplicationUsage()->addCommandLineOption("--maxsounds <n>","Sets the maximum number of sounds allowed.");
+    arguments.getApplicationUsage()->addCommandLineOption("--gain <n>","Sets the global gain (volume)");
+    arguments.getApplicationUsage()->addCommandLineOption("--dopplerfactor <n>","Sets the doppler factor");
+    arguments.getApplicationUsage()->addCommandLineOption("--distancemodel <mode>", "NONE | INVERSE_DISTANCE | INVERSE_DISTANCE_CLAMPED | LINEAR");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout, osg::ApplicationUsage::COMMAND_LINE_OPTION);
+        return 1;
+    }
+
+    std::string pathFile;
+    while (arguments.read("-p", pathFile) || arguments.read("--path", pathFile)) {}
+
+    std::string outputFile = "render.wav";
+    while (arguments.read("-o", outputFile) || arguments.read("--output", outputFile)) {}
+
+    double duration = 0.0;
+    arguments.read("--duration", duration);
+
+    double fps = 60.0;
+    arguments.read("--fps", fps);
+
+    unsigned int frequency = 48000;
+    arguments.read("--frequency", frequency);
+
+    unsigned int channels = 2;
+    arguments.read("--channels", channels);
+
+    const bool floating = arguments.read("--float");
+
+    unsigned int maxSounds = OSGAUDIO_DEFAULT_MAX_SOUNDSOURCES_ALLOWED;
+    arguments.read("--maxsounds", maxSounds);
+
+    float gain = OSGAUDIO_DEFAULT_GAIN;
+    arguments.read("--gain", gain);
+
+    float dopplerFactor = OSGAUDIO_DEFAULT_DOPPLER_FACTOR;
+    arguments.read("--dopplerfactor", dopplerFactor);
+
+    osgAudio::DistanceModel distanceModel = OSGAUDIO_DEFAULT_DISTANCE_MODEL;
+    std::string s_model;
+#undef None // Someone in Linux is defining it 8|
+    if (arguments.read("--distancemodel", s_model)) {
+        if (s_model == "NONE")
+            distanceModel = osgAudio::None;
+        else if (s_model == "INVERSE_DISTANCE")
+            distanceModel = osgAudio::InverseDistance;
+        else if (s_model == "INVERSE_DISTANCE_CLAMPED")
+            distanceModel = osgAudio::InverseDistanceClamped;    
+        else if (s_model == "LINEAR")
+            distanceModel = osgAudio::Linear;    
+        else
+            osg::notify(osg::WARN) << "WARNING: I do not understand that -distancemodel parameter" << std::endl;
+    }
+
+    // report any errors if they have occured when parsing the program aguments.
+    if (arguments.errors())
+    {
+        arguments.writeErrorMessages(std::cout);
+        return 1;
+    }
+
+    if (arguments.argc()<=1)
+    {
+        arguments.getApplicationUsage()->write(std::cout,osg::ApplicationUsage::COMMAND_LINE_OPTION);
+        return 1;
+    }
+
+    if (fps <= 0.0)
+    {
+        std::cout << arguments.getApplicationName() << ": --fps must be positive" << std::endl;
+        return 1;
+    }
+
+    // The camera path, in the format of osgGA::AnimationPathManipulator
+    osg::ref_ptr<osg::AnimationPath> animationPath;
+    if (!pathFile.empty())
+    {
+        osg::ref_ptr<osgGA::AnimationPathManipulator> apm = new osgGA::AnimationPathManipulator(pathFile);
+        if (!apm->valid())
+        {
+            std::cout << arguments.getApplicationName() << ": Couldn't read the animation path " << pathFile << std::endl;
+            return 1;
+        }
+        animationPath = apm->getAnimationPath();
+        if (duration <= 0.0)
+            duration = animationPath->getPeriod();
+    }
+
+    if (duration <= 0.0)
+    {
+        std::cout << arguments.getApplicationName() << ": Use --duration, or a --path to follow" << std::endl;
+        return 1;
+    }
+
+    int result = 0;
+
+    try {
+
+        // Mix on a loopback device, only when we ask for the samples
+        osgAudio::AudioEnvironment::instance()->initLoopback(frequency, channels, floating);
+
+        // here we init the SoundManager
+        osgAudio::SoundManager::instance()->init(maxSounds);
+        osgAudio::SoundManager::instance()->getEnvironment()->setGain(gain);
+        osgAudio::SoundManager::instance()->getEnvironment()->setDopplerFactor(dopplerFactor);
+        osgAudio::SoundManager::instance()->getEnvironment()->setDistanceModel(distanceModel);
+
+        // read the scene from the list of file specified commandline args.
+        osg::ref_ptr<osg::Node> loadedModel = osgDB::readNodeFiles(arguments);
+
+        // if no model has been successfully loaded report failure.
+        if (!loadedModel) 
+            throw std::runtime_error("No data loaded");
+
+        // any option left unread are converted into errors to write out later.
+        arguments.reportRemainingOptionsAsUnrecognized();
+
+        // report any errors if they have occured when parsing the program aguments.
+        if (arguments.errors())
+        {
+            arguments.writeErrorMessages(std::cout);
+        }
+
+        // The listener follows our camera, which is never drawn
+        osg::ref_ptr<osg::Camera> camera = new osg::Camera;
+
+        osg::ref_ptr<osg::Group> root = new osg::Group;
+        root->addChild(loadedModel.get());
+        RemoveSoundRootNodesVisitor rsrnv;
+        root->accept(rsrnv);
+        osg::ref_ptr<osgAudio::SoundRoot> soundRoot = new osgAudio::SoundRoot();
+        soundRoot->setCamera( camera.get() );
+        root->addChild(soundRoot.get());
+
+        WavWriter wav(outputFile, frequency, channels, floating);
+        if (!wav.good())
+            throw std::runtime_error("Couldn't open " + outputFile);
+
+        osgAudio::AudioEnvironment *environment = osgAudio::SoundManager::instance()->getEnvironment();
+        std::vector<unsigned char> buffer;
+
+        // SoundNodes pick up their positions during the cull traversal
+        osg::ref_ptr<osg::FrameStamp> frameStamp = new osg::FrameStamp;
+        osgUtil::UpdateVisitor updateVisitor;
+        updateVisitor.setFrameStamp(frameStamp.get());
+        osg::NodeVisitor cullVisitor(osg::NodeVisitor::CULL_VISITOR, osg::NodeVisitor::TRAVERSE_ACTIVE_CHILDREN);
+        cullVisitor.setFrameStamp(frameStamp.get());
+
+        const osg::Timer_t start_tick = osg::Timer::instance()->tick();
+
+        // Frame boundaries are rounded to whole samples from the start, so that they don't drift
+        const double totalFrames = floor(duration * frequency + 0.5);
+        double rendered = 0.0;
+        for (unsigned int frame = 0; rendered < totalFrames; frame++)
+        {
+            const double time = frame / fps;
+
+            frameStamp->setFrameNumber(frame);
+            frameStamp->setReferenceTime(time);
+            frameStamp->setSimulationTime(time);
+
+            if (animationPath.valid())
+            {
+                osg::AnimationPath::ControlPoint cp;
+                animationPath->getInterpolatedControlPoint(animationPath->getFirstTime() + time, cp);
+                osg::Matrixd view;
+                cp.getInverse(view);
+                camera->setViewMatrix(view);
+            }
+
+            updateVisitor.setTraversalNumber(frame);
+            root->accept(updateVisitor);
+            cullVisitor.setTraversalNumber(frame);
+            root->accept(cullVisitor);
+
+            double next = floor((frame + 1) / fps * frequency + 0.5);
+            if (next > totalFrames)
+                next = totalFrames;
+            const unsigned int samples = (unsigned int)(next - rendered);
+            if (!samples)
+                continue;
+
+            buffer.resize(samples * environment->getRenderFrameSize());
+            environment->render(&buffer[0], samples);
+            wav.write(&buffer[0], samples);
+            rendered = next;
+        }
+
+        wav.close();
+
+        const double seconds = osg::Timer::instance()->delta_s(start_tick, osg::Timer::instance()->tick());
+        std::cout << "Rendered " << duration << " s to " << outputFile << " in " << seconds << " s";
+        if (seconds > 0.0)
+            std::cout << " (" << duration / seconds << "x realtime)";
+        std::cout << std::endl;
+
+    } catch(std::exception& e) {
+        std::cerr << "Caught: " << e.what() << std::endl;
+        result = 1;
+    }
+
+    // Very important to call before end of main!
+    if (osg::Referenced::getDeleteHandler())
+        osg::Referenced::getDeleteHandler()->setNumFramesToRetainObjects(0);
+    osgAudio::SoundManager::instance()->shutdown();
+
+    return result;
+}
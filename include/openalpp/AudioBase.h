@@ -53,6 +53,29 @@ namespace openalpp {
     */
     enum SampleFormat {Mono8,Stereo8,Mono16,Stereo16};
 
+    /**
+    * Format of the sound rendered by a loopback device, which mixes for the
+    * application instead of playing. See AudioEnvironment::render().
+    */
+    struct OPENALPP_API RenderFormat {
+        /**
+        * Constructor.
+        * @param freq is the frequency in Hz.
+        * @param chans is the number of channels: 1, 2, 4, 6 (5.1), 7 (6.1) or 8 (7.1).
+        * @param isfloat is true for 32 bit float samples, false for 16 bit signed ones.
+        */
+        RenderFormat(unsigned int freq=44100,unsigned int chans=2,bool isfloat=false)
+            : frequency(freq),channels(chans),floating(isfloat) {}
+
+        /**
+        * @return the size of a sample frame, in bytes.
+        */
+        unsigned int getFrameSize() const { return channels*(floating ? 4 : 2); }
+
+        unsigned int frequency,channels;
+        bool floating;
+    };
+
     /** 
     * Base class for environment, listener and source classes.
     * Takes care of initialisation/shutdown of anything necessary (e.g. ALut)
@@ -81,6 +104,25 @@ namespace openalpp {
 #else
         static struct ALCcontext_struct *context_;
 #endif
+
+        /**
+        * True if device_ is a loopback device, rendering in renderFormat_.
+        */
+        static bool loopback_;
+        static RenderFormat renderFormat_;
+
+        /**
+        * Create the context on device_ and make it current.
+        * @param attributes are the context attributes, 0 terminated.
+        */
+        static void createContext(const int *attributes,bool displayInitMsgs) throw (InitError);
+    public:
+        /**
+        * @return true if the device is a loopback device. Streams are then
+        * serviced by AudioEnvironment::render(), not by the StreamScheduler threads.
+        */
+        static bool isLoopback() { return loopback_; }
+
     protected:
         /**
         * Constructor.
@@ -92,6 +134,27 @@ namespace openalpp {
         AudioBase(int frequency=-1,int refresh=-1,int synchronous=-1, bool displayInitMsgs=false )
             throw (InitError);
 
+        /**
+        * Constructor for a loopback device, which renders the mixed sound on
+        * demand rather than playing it. Needs the ALC_SOFT_loopback extension.
+        * The format is ignored if this isn't the first object to be
+        * instantiated of the AudioBase descendants.
+        * @param format is the format to render.
+        */
+        AudioBase(const RenderFormat &format,bool displayInitMsgs=false) throw (InitError);
+
+        /**
+        * @return the format of a loopback device.
+        */
+        static const RenderFormat &getRenderFormat() { return renderFormat_; }
+
+        /**
+        * Mix sample frames on a loopback device.
+        * @param buffer gets the samples, in the format of getRenderFormat().
+        * @param frames is the number of sample frames to mix.
+        */
+        static void renderSamples(void *buffer,unsigned int frames) throw (FatalError);
+
         /**
         * Destructor.
         */
@@ -29,9 +29,11 @@
 #include <al.h>
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
 
 #include <openalpp/Export.h>
 #include <openalpp/Error.h>
+#include <openalpp/Resampler.h>
 
 namespace openalpp {
 
@@ -42,22 +44,90 @@ namespace openalpp {
         unsigned short channels_,bits_;
         unsigned int frequency_;
         ALenum format_;
+        Resampler::Quality quality_;
     public:
         /**
         * Constructor.
         * @param format is the (OpenAL) format that data will be converted to.
         * @param frequency is the frequency the data will be converted to.
+        * @param quality is the quality of the rate conversion.
         */
-        AudioConvert(ALenum format,unsigned int frequency);
+        AudioConvert(ALenum format,unsigned int frequency,
+                     Resampler::Quality quality=Resampler::Medium);
 
         /**
-        * Apply the conversion to data.
+        * Apply the conversion to data. The data goes through the same stages
+        * as with convert(), so a sound comes out the same converted whole or
+        * chunk by chunk.
         * @param data is the data to convert.
         * @param format is the (OpenAL) format of the data.
         * @param frequency is the frequency of the data.
         * @param size is the size of the data. It will be updated to the new size.
         */
         void *apply(void *data,ALenum format,unsigned int frequency,unsigned int &size);
+
+        /**
+        * Start converting a stream chunk by chunk, e.g. from a FileStream
+        * or a Capture, with convert(). Rate and channel state is carried
+        * between the chunks, and memory use doesn't grow with the stream.
+        * A FatalError is thrown if format isn't 8 or 16 bit mono or stereo.
+        * @param format is the (OpenAL) format of the stream.
+        * @param frequency is the frequency of the stream.
+        */
+        void setSource(ALenum format,unsigned int frequency);
+
+        /**
+        * Convert the next chunk of the stream. Input of any size is accepted,
+        * a partial sample frame is kept for the next call.
+        * When out is too small, the input that doesn't fit is not consumed,
+        * or, when resampling, is held back and output by the next call.
+        * Convert a chunk of size 0 to get held back output.
+        * @param data is the input.
+        * @param size is the size of the input in bytes.
+        * @param out gets the output.
+        * @param outsize is the size of out in bytes.
+        * @param consumed gets the number of input bytes used, if not NULL.
+        * @return the number of bytes written to out.
+        */
+        unsigned int convert(const void *data,unsigned int size,
+                             void *out,unsigned int outsize,unsigned int *consumed=NULL);
+
+        /**
+        * Get the rest of the output at the end of the stream, and start over.
+        * @return the number of bytes written to out.
+        */
+        unsigned int flush(void *out,unsigned int outsize);
+
+        /**
+        * @return the largest output that converting size more bytes can give,
+        * including what is held back.
+        */
+        unsigned int getMaxOutput(unsigned int size) const;
+
+        /**
+        * Forget the stream, but keep its format.
+        */
+        void reset();
+
+    protected:
+        typedef void (*FrameConverter)(const void *src,void *dst,size_t frames);
+
+        unsigned int drain(char *out,unsigned int outsize);
+        unsigned int convertFrames(const char *in,unsigned long frames,char *out,unsigned int outsize);
+
+        /**
+        * Convert all of a sound in a raw format, as one stream.
+        * @return the converted sound, to be free()d.
+        */
+        void *convertAll(const void *data,ALenum format,unsigned int frequency,unsigned int &size);
+
+        ALenum sourceFormat_;
+        unsigned int sourceFrequency_,sourceFrameSize_;
+        bool resampling_;
+        Resampler resampler_;
+        FrameConverter toTarget_,fromResampler_;
+        std::vector<char> pending_;
+        std::vector<short> scratch_,resampled_;
     };
 
     typedef struct _acAudioCVT {
@@ -65,6 +135,10 @@ namespace openalpp {
         ALushort src_format;            /* Source audio format */
         ALushort dst_format;            /* Target audio format */
         double rate_incr;               /* Rate conversion increment */
+        ALuint src_rate;                /* Source rate */
+        ALuint dst_rate;                /* Target rate */
+        ALubyte dst_channels;           /* Target channels, for the resampler */
+        int rate_quality;               /* Resampler::Quality */
         void   *buf;                    /* Buffer to hold entire audio data */
         int    len;                     /* Length of original audio buffer */
         int    len_cvt;                 /* Length of converted audio buffer */
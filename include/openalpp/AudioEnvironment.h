@@ -98,6 +98,38 @@ namespace openalpp {
         AudioEnvironment(int frequency,int refresh=-1)
             throw (InitError);
 
+        /**
+        * Constructor for a loopback environment. Nothing is played on a sound
+        * device, instead the application pulls the mixed sound with render(),
+        * as fast as the CPU allows. Needs the ALC_SOFT_loopback extension of
+        * OpenAL Soft.
+        * The format is ignored if this isn't the first object to be
+        * instantiated of the AudioBase descendants, see isLoopback().
+        * @param format is the format to render.
+        * @param displayInitMsgs When true, writes init messages to console.
+        */
+        AudioEnvironment(const RenderFormat &format,bool displayInitMsgs=false)
+            throw (InitError);
+
+        /**
+        * @return true if the sound is rendered with render(), rather than played.
+        */
+        bool isLoopback() const { return AudioBase::isLoopback(); }
+
+        /**
+        * @return the format that render() mixes to.
+        */
+        const RenderFormat &getRenderFormat() const { return AudioBase::getRenderFormat(); }
+
+        /**
+        * Mix the next sample frames of a loopback environment. Sources play
+        * by the rendered time rather than the wall clock: streams are refilled
+        * between chunks of the rendering, so they keep up however fast it goes.
+        * @param buffer gets frames*getRenderFormat().getFrameSize() bytes.
+        * @param frames is the number of sample frames to render.
+        */
+        void render(void *buffer,unsigned int frames) throw (FatalError);
+
         /**
         * Sets the speed of sound in the environment.
         * This is used in Doppler calculations.
@@ -0,0 +1,134 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_DATABLOCK_H
+#define OPENALPP_DATABLOCK_H 1
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#ifdef WIN32
+// Ignore the dll interface warning using std::vector members
+#pragma warning(disable : 4251)
+#endif
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+
+#include <openalpp/Export.h>
+#include <openalpp/Error.h>
+
+namespace openalpp {
+
+    /**
+    * A read-only block of (encoded) sound data in memory, e.g. the contents
+    * of a sound file. Streams hold a reference to the block while they
+    * decode from it.
+    */
+    class OPENALPP_API DataBlock : public osg::Referenced {
+    public:
+        /**
+        * @return the start of the data.
+        */
+        const char *data() const { return data_; }
+
+        /**
+        * @return the size of the data in bytes.
+        */
+        size_t size() const { return size_; }
+
+        /**
+        * Hint that a range of the data will soon be read, e.g. after a seek.
+        * @param offset is the start of the range, in bytes.
+        * @param length is the length of the range, in bytes.
+        */
+        virtual void willNeed(size_t offset,size_t length) const {}
+
+    protected:
+        DataBlock() : data_(0L), size_(0) {}
+        virtual ~DataBlock() {}
+
+        const char *data_;
+        size_t size_;
+    };
+
+    /**
+    * A DataBlock holding a copy of the data in memory.
+    */
+    class OPENALPP_API MemoryBlock : public DataBlock {
+    public:
+        /**
+        * Constructor. Copies the data.
+        * @param data is the data to copy.
+        * @param size is the size of the data in bytes.
+        */
+        MemoryBlock(const void *data,size_t size);
+
+        /**
+        * Constructor. Reads a stream until its end, e.g. a file in an archive.
+        * A FileError is thrown if the stream can't be read.
+        * @param stream is the stream to read.
+        */
+        MemoryBlock(std::istream &stream) throw (FileError);
+
+        /**
+        * Constructor. Takes over the contents of a vector, leaving it empty.
+        * @param data is the vector to take the data from.
+        */
+        MemoryBlock(std::vector<char> &data);
+
+    protected:
+        virtual ~MemoryBlock() {}
+
+        std::vector<char> memory_;
+    };
+
+    /**
+    * A part of another DataBlock, e.g. one sound in a SoundBank. Keeps the
+    * other block alive, without copying the data.
+    */
+    class OPENALPP_API SubBlock : public DataBlock {
+    public:
+        /**
+        * Constructor. The range is clamped to the parent block.
+        * @param parent is the block to take a part of.
+        * @param offset is the start of the part, in bytes.
+        * @param size is the size of the part in bytes.
+        */
+        SubBlock(const DataBlock *parent,size_t offset,size_t size);
+
+        virtual void willNeed(size_t offset,size_t length) const;
+
+    protected:
+        virtual ~SubBlock() {}
+
+        osg::ref_ptr<const DataBlock> parent_;
+        size_t offset_;
+    };
+
+}
+
+#endif /* OPENALPP_DATABLOCK_H */
@@ -26,7 +26,11 @@
 #ifndef OPENALPP_FILESTREAM_H
 #define OPENALPP_FILESTREAM_H 1
 
+#include <iosfwd>
+
 #include <openalpp/Stream.h>
+#include <openalpp/DataBlock.h>
+#include <openalpp/StreamDecoder.h>
 #include <openalpp/Export.h>
 
 #if 0        // #ifdef _DEBUG
@@ -37,16 +41,15 @@
 #define DEBUG_NEW new
 #endif
 
-#include <vorbis/vorbisfile.h>
-
-
-struct OggVorbis_File;
-
 namespace openalpp {
 
+    class FileStreamUpdater;
+
     /**
-    * Class for streaming audio data from a file. Presently it supports Ogg
-    * Vorbis files (http://www.vorbis.com/).
+    * Class for streaming audio data from a file. The file is decoded by
+    * a decoder from the StreamDecoderRegistry: WAV, Ogg Vorbis
+    * (http://www.vorbis.com/) and, if available, FLAC and Opus.
+    * The file can also be in memory, e.g. read from an archive.
     */
     class OPENALPP_API  FileStream : public Stream {
     public:
@@ -56,12 +59,42 @@ namespace openalpp {
         * @param filename is the name of the file to try to open.
         * @param buffersize is an optional parameter specifying how large the
         * buffer should be (in samples per second).
+        * @param numbuffers is the number of buffers queued on the sources. More
+        * buffers survive longer hiccups in the streaming thread.
+        * @param bufferduration is the length of each buffer, in seconds.
+        * @param decodeahead is the number of buffers decoded in advance of
+        * being queued.
+        */
+        FileStream(const std::string& filename,const int buffersize=4096,
+            unsigned int numbuffers=4,float bufferduration=0.25f,
+            unsigned int decodeahead=2) 
+            throw (NameError,InitError,FileError);
+
+        /**
+        * Constructor. Streams from a file in memory, which is referenced and
+        * not copied. A FileError will be thrown if the data isn't recognized.
+        * @param block is the contents of the file.
+        * The other parameters are the same as for the constructor taking a filename.
         */
-        FileStream(const std::string& filename,const int buffersize=4096) 
+        FileStream(DataBlock *block,const int buffersize=4096,
+            unsigned int numbuffers=4,float bufferduration=0.25f,
+            unsigned int decodeahead=2) 
             throw (NameError,InitError,FileError);
 
         /**
-        * Copy constructor.
+        * Constructor. Reads all of a stream into memory with one large read,
+        * e.g. a file in an osgDB::Archive, and streams from there.
+        * A FileError will be thrown if the data isn't recognized.
+        * @param stream is the stream to read the file from.
+        * The other parameters are the same as for the constructor taking a filename.
+        */
+        FileStream(std::istream &stream,const int buffersize=4096,
+            unsigned int numbuffers=4,float bufferduration=0.25f,
+            unsigned int decodeahead=2) 
+            throw (NameError,InitError,FileError);
+
+        /**
+        * Copy constructor. The copy shares the file data, but decodes on its own.
         */
         FileStream(const FileStream &stream);
 
@@ -69,11 +102,24 @@ namespace openalpp {
         FileStream &operator=(const FileStream &stream);
 
         /**
-        * Turn on/off looping.
+        * Turn on/off looping, for all sources.
         * @param loop is true if the stream should loop, false otherwise.
         */
         void setLooping(bool loop = true);
 
+        /**
+        * Set the part of the file to loop, when looping. The loop is sample
+        * accurate and gapless.
+        * Loop points are also read from LOOPSTART and LOOPEND (or LOOPLENGTH)
+        * tags in the file.
+        * @param start is the first sample frame of the loop.
+        * @param end is the sample frame after the loop, 0 for the end of the file.
+        */
+        void setLoopPoints(unsigned int start,unsigned int end = 0);
+
+        unsigned int getLoopStart() const;
+        unsigned int getLoopEnd() const;
+
         std::string getFileName() const { return filename_; }
 
     protected:
@@ -82,12 +128,43 @@ namespace openalpp {
         */
         virtual ~FileStream();
 
-        ov_callbacks    _vorbisCallbacks;    // callbacks used to read the file from memory
+        /**
+        * Open the file in a block of memory, and create the updater.
+        */
+        void open(DataBlock *block,const int buffersize,
+            unsigned int numbuffers,float bufferduration,
+            unsigned int decodeahead)
+            throw (NameError,InitError,FileError);
 
-        std::string filename_;
+        /**
+        * Open (another) decoder of the file.
+        */
+        StreamDecoder *openDecoder() throw (FileError);
+
+        /**
+        * Create an updater with a decoder.
+        * The loop settings are copied from like, if given.
+        */
+        FileStreamUpdater *createUpdater(StreamDecoder *decoder,
+            const std::vector<ALuint> &buffers,const FileStreamUpdater *like=0L)
+            throw (FatalError,FileError);
+
+        /**
+        * Create a decoder of its own for one more source, on the same data.
+        */
+        bool createCursor(Cursor &cursor);
 
+        /**
+        * Start decoding on its own after being copied.
+        */
+        void reopen();
+
+        std::string filename_;
 
-        OggVorbis_File* oggfile_;
+        osg::ref_ptr<DataBlock> block_;     // The file
+        unsigned int numBuffers_;
+        float bufferDuration_;
+        unsigned int decodeAhead_;
 
     };
 
@@ -26,11 +26,9 @@
 #ifndef OPENALPP_FILESTREAMUPDATER_H
 #define OPENALPP_FILESTREAMUPDATER_H 1
 
-#include <vorbis/codec.h>
-#include <vorbis/vorbisfile.h>
-
 #include <openalpp/Export.h>
 #include <openalpp/StreamUpdater.h>
+#include <openalpp/StreamDecoder.h>
 
 
 
@@ -41,57 +39,69 @@ namespace openalpp {
     */
     class OPENALPP_API FileStreamUpdater : public StreamUpdater 
     {
-        OggVorbis_File *oggfile_; // The file structure
+        osg::ref_ptr<StreamDecoder> decoder_; // Decoder of the file
         const unsigned int buffersize_; // Size of the buffer in bytes
         ALshort *buffer_;
-        bool seekPending_; // true if seek is waiting to be performed in update
-        float seekTime_; // time in seconds to seek to
-        bool looping_;            // Are we looping or not?
+        OpenThreads::Atomic looping_;   // Are we looping or not?
+        OpenThreads::Atomic loopStart_,loopEnd_;  // Loop points in sample frames, 0 end for the end of file
+        unsigned int frameSize_;    // Bytes per sample frame
+        unsigned long position_;    // Sample frame that is decoded next
 
         /**
-        * Perform seek on stream
+        * Seek to a sample frame.
         * @return true if seek was performed with no errors
         */
-        bool seekNow(float time_s);
+        bool seekFrame(unsigned long frame);
 
     public:
         /**
         * Constructor.
-        * @param oggfile is the structure created by ov_open
-        * @param buffer1 and...
-        * @param buffer2 are the sound buffers to use.
-        * @param format is the (OpenAL) format of the sound data.
-        * @param frequency is the frequency of the sound data.
-        * @param buffersize is the size of the buffer (in bytes)
+        * @param decoder is the decoder of the file.
+        * @param buffers are the sound buffers to queue.
+        * @param buffersize is the size of each buffer (in bytes)
         */
-        FileStreamUpdater(OggVorbis_File *oggfile,
-            const ALuint buffer1,ALuint buffer2,
-            ALenum format,unsigned int frequency,
+        FileStreamUpdater(StreamDecoder *decoder,
+            const std::vector<ALuint> &buffers,
             unsigned int buffersize);
 
 
         /**
-        * Inherited from Thread.
-        * This will be called when the updater is Start():ed..
+        * Turn on/off looping.
+        * @param loop is true if the stream should loop, false otherwise.
         */
-        void run();
+        void setLooping(bool loop = true);
 
-        /**
-        * Seeks to specified time
-        */
-        void seek(float time_s);
+        bool getLooping() const { return (unsigned int)looping_!=0; }
 
         /**
-        * Turn on/off looping.
-        * @param loop is true if the stream should loop, false otherwise.
+        * Set the part of the file to loop, when looping.
+        * The loop end is followed by the loop start within the same buffer,
+        * without a gap.
+        * @param start is the first sample frame of the loop.
+        * @param end is the sample frame after the loop, 0 for the end of the file.
         */
-        void setLooping(bool loop = true);
+        void setLoopPoints(unsigned int start,unsigned int end);
+
+        unsigned int getLoopStart() const { return loopStart_; }
+        unsigned int getLoopEnd() const { return loopEnd_; }
 
     protected:
         /**
         * Destructor.
         */
         virtual ~FileStreamUpdater();
+
+        /**
+        * Perform seek on stream. Called from the decoder stage.
+        * @return true if seek was performed with no errors
+        */
+        bool seekNow(float time_s);
+
+        /**
+        * Decode the next buffer of sound data from the file.
+        * Called from the decoder stage of the StreamScheduler.
+        */
+        void *readBlock(unsigned int &length);
     };
 
 }
@@ -35,6 +35,7 @@
 #include <openalpp/Export.h>
 #include <openalpp/Source.h>
 #include <openalpp/AudioConvert.h>
+#include <openalpp/Resampler.h>
 
 namespace openalpp {
 
@@ -60,6 +61,44 @@ namespace openalpp {
         */
         ALuint buffer_;
 
+        /**
+        * The sound of included sources, as decoded when they were included
+        * and converted to the mixing format.
+        */
+        struct MixData {
+            osg::ref_ptr<const SoundData> sound;
+            std::vector<char> decoded;
+            ALenum format;
+            unsigned int rate;
+            unsigned int frequency;     // Of pcm, 0 until mixed
+            std::vector<ALshort> pcm;
+        };
+
+        /**
+        * Sounds of the included sources, so that mixing again after their
+        * parameters changed doesn't decode them again. Sources that share a
+        * sample share the entry.
+        */
+        std::vector<MixData> mixdata_;
+
+        /**
+        * Decode the sound of a source into mixdata_, unless it is there already.
+        * @param source is the source.
+        * @param file is the file its sample was loaded from, or NULL to
+        * decode it with Sample::getPCM().
+        */
+        void capture(Source *source,const DataBlock *file) throw (FileError);
+
+        /**
+        * Get the sound of a source converted to the mixing format, decoding it
+        * if it hasn't been yet.
+        * @param source is (a pointer to) the source.
+        * @param frequency is the mixing frequency.
+        * @return the interleaved stereo samples.
+        */
+        const std::vector<ALshort> &getMixData(Source *source,unsigned int frequency)
+            throw (FileError,FatalError);
+
         enum Speaker {Left,Right};
 
         /**
@@ -70,26 +109,47 @@ namespace openalpp {
         ALfloat filterDistance(ALuint source,Speaker speaker);
 
         /**
-        * Reverb filter.
-        * @param source is (a pointer to) the source.
-        * @param buffer is (a pointer to) the buffer (=memory area).
-        * @param size is the size of the buffer.
-        * @param frequency is the frequency of the sound.
-        * @return new pointer to buffer.
+        * The sound of an included source, filtered and ready to be mixed.
         */
-        ALshort *filterReverb(Source *source,ALshort *buffer,
-            ALsizei &size,unsigned int frequency);
+        struct MixInput {
+            const ALshort *pcm;
+            unsigned long frames;
+            ALfloat lgain,rgain;
+            unsigned long delay;    // Reverb delay in samples, 0 for none
+            ALfloat scale;          // Reverb scale
+        };
 
         /**
-        * Apply filters.
-        * @param source is (a pointer to) the source.
-        * @param buffer is the buffer containing the sound.
-        * @param size is the size of the buffer.
-        * @param frequency is the frequency of the sound.
-        * @return (new) pointer to buffer.
+        * Apply filters: pitch, distance attenuation, cone, min/max gain and reverb.
+        * @param source is the index of the source in sources_.
+        * @param frequency is the mixing frequency.
+        * @return the sound and gains to mix.
         */
-        ALshort *applyFilters(Source *source,ALshort *buffer,ALsizei &size,
-            unsigned int frequency);
+        MixInput applyFilters(unsigned int source,unsigned int frequency)
+            throw (FileError,FatalError);
+
+        /**
+        * Add a source with reverb to the bus, out[i]=in[i]+scale*out[i-delay].
+        * @param input is the filtered source.
+        */
+        void mixReverb(const MixInput &input);
+
+        /**
+        * Pitch shifting of the sources.
+        */
+        Resampler resampler_;
+
+        /**
+        * Memory of the mixer, kept so that mixing again allocates nothing:
+        * the pitch shifted sound of each source, the filtered sources, the
+        * float bus they are added up on, the reverb of one source and the
+        * mixed sound.
+        */
+        std::vector<std::vector<ALshort> > pitched_;
+        std::vector<MixInput> inputs_;
+        std::vector<float> bus_;
+        std::vector<float> reverb_;
+        std::vector<ALshort> output_;
     public:
         /**
         * Constructor.
@@ -112,6 +172,8 @@ namespace openalpp {
         * was called, so if you want the source to start playing as fast as
         * possible after the Play()-call, MixSources() should be called
         * separately
+        * The sources are added up in floating point, and saturated to 16 bits
+        * once at the end.
         * @param frequency is the frequency that will be used when mixing.
         */
         void mixSources(unsigned int frequency=22050) 
@@ -121,10 +183,22 @@ namespace openalpp {
         * Includes a source in the group.
         * Returns an identifier that can be used as an argument to ExcludeSource(). 
         * This identifier is also the OpenAL name for the included source.
+        * The sound of the source is decoded right away, which takes a sample
+        * loaded from a file or kept Compressed. See the other overload for
+        * samples loaded from memory.
+        * @param source is (a pointer to) the source to include.
+        * @return identifier for the source.
+        */
+        ALuint includeSource(Source *source) throw (ValueError,FileError);
+
+        /**
+        * Includes a source playing a sample that was loaded from memory.
         * @param source is (a pointer to) the source to include.
+        * @param file is the file the sample was loaded from. The group keeps
+        * the decoded sound, not the file.
         * @return identifier for the source.
         */
-        ALuint includeSource(Source *source) throw (ValueError);
+        ALuint includeSource(Source *source,const DataBlock *file) throw (ValueError,FileError);
 
         /**
         * Removes a source from the group.
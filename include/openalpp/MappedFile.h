@@ -0,0 +1,74 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_MAPPEDFILE_H
+#define OPENALPP_MAPPEDFILE_H 1
+
+#include <string>
+
+#include <openalpp/Export.h>
+#include <openalpp/Error.h>
+#include <openalpp/DataBlock.h>
+
+namespace openalpp {
+
+    /**
+    * A file mapped read-only into memory.
+    * Reading from the mapping goes straight to the page cache, without copying
+    * through a stdio buffer, and every mapping of the same file shares the
+    * same physical pages.
+    */
+    class OPENALPP_API MappedFile : public DataBlock {
+    public:
+        /**
+        * Constructor. Maps the whole file and hints the system that it will
+        * be read sequentially.
+        * A FileError is thrown if the file can't be opened or mapped.
+        * @param filename is the name of the file to map.
+        */
+        MappedFile(const std::string &filename) throw (FileError);
+
+        /**
+        * Hint the system that a range of the file will soon be read, e.g.
+        * after a seek, so that it is read ahead from disk.
+        * @param offset is the start of the range, in bytes.
+        * @param length is the length of the range, in bytes.
+        */
+        virtual void willNeed(size_t offset,size_t length) const;
+
+    protected:
+        /**
+        * Destructor. Unmaps the file.
+        */
+        virtual ~MappedFile();
+
+#ifdef _WIN32
+        void *file_,*mapping_;
+#endif
+    };
+
+}
+
+#endif /* OPENALPP_MAPPEDFILE_H */
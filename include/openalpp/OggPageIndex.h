@@ -0,0 +1,105 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_OGGPAGEINDEX_H
+#define OPENALPP_OGGPAGEINDEX_H 1
+
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+// Ignore the dll interface warning using std::vector members
+#pragma warning(disable : 4251)
+#endif
+
+#include <osg/Referenced>
+
+#include <vorbis/codec.h>
+
+#include <openalpp/Export.h>
+#include <openalpp/DataBlock.h>
+
+namespace openalpp {
+
+    /**
+    * Index of the pages of an Ogg file in memory, mapping sample positions
+    * (granule positions) to byte offsets.
+    * With the index, a seek goes straight to the page holding the wanted
+    * sample, instead of bisecting through the file.
+    * Indexes are built once per file and shared, see get().
+    */
+    class OPENALPP_API OggPageIndex : public osg::Referenced {
+    public:
+        /**
+        * Scan the pages of the first logical stream in an Ogg file.
+        * @param block is the contents of the file.
+        */
+        OggPageIndex(const DataBlock *block);
+
+        /**
+        * Get the index of a file, building it if no other stream of the same
+        * file holds it.
+        * @param filename identifies the file.
+        * @param block is the contents of the file.
+        */
+        static OggPageIndex *get(const std::string &filename,const DataBlock *block);
+
+        /**
+        * @return true if any pages were found.
+        */
+        bool valid() const { return !pages_.empty(); }
+
+        /**
+        * Get the page to start decoding from to reach a sample.
+        * @param sample is the sample (frame) to seek to.
+        * @return the byte offset of the last page that ends before the
+        * sample, or 0 if the sample is on the first page.
+        */
+        ogg_int64_t findPage(ogg_int64_t sample) const;
+
+        /**
+        * @return the number of indexed pages.
+        */
+        unsigned int getNumPages() const { return pages_.size(); }
+
+    protected:
+        virtual ~OggPageIndex() {}
+
+        struct Page {
+            ogg_int64_t granule;    // Last sample finished on the page
+            ogg_int64_t offset;     // Byte offset of the page in the file
+        };
+
+        std::vector<Page> pages_;
+
+        /**
+        * Size of the indexed file, to tell changed files apart in get().
+        */
+        size_t size_;
+    };
+
+}
+
+#endif /* OPENALPP_OGGPAGEINDEX_H */
@@ -0,0 +1,48 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_OPUSDECODER_H
+#define OPENALPP_OPUSDECODER_H 1
+
+#include <openalpp/StreamDecoder.h>
+
+namespace openalpp {
+
+    /**
+    * Creates decoders for Ogg Opus files (http://opus-codec.org/), through opusfile.
+    * Opus is always decoded at 48 kHz.
+    * Only available if openalpp was built with Opus support.
+    */
+    class OPENALPP_API OpusDecoderFactory : public StreamDecoderFactory {
+    public:
+        const char *getName() const { return "Opus"; }
+        bool probe(const char *data,size_t size) const;
+        float getCost() const { return 0.6f; }
+        StreamDecoder *open(const DataBlock *block,const std::string &filename);
+    };
+
+}
+
+#endif /* OPENALPP_OPUSDECODER_H */
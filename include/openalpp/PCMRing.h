@@ -0,0 +1,129 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_PCMRING_H
+#define OPENALPP_PCMRING_H 1
+
+#include <vector>
+
+#ifdef WIN32
+// Ignore the dll interface warning using std::vector members
+#pragma warning(disable : 4251)
+#endif
+
+#include <openalpp/Export.h>
+
+#include <OpenThreads/Atomic>
+
+namespace openalpp {
+
+    /**
+    * Lock-free ring of decoded sound blocks, for exactly one producer thread
+    * and one consumer thread.
+    * The producer fills back() and publishes it with push(), the consumer
+    * reads front() and releases it with pop(). Neither of them ever waits
+    * for the other.
+    */
+    class OPENALPP_API PCMRing {
+    public:
+        /**
+        * A block of decoded sound data.
+        */
+        struct Block {
+            Block() : generation(0) {}
+
+            /**
+            * The sound data, empty at the end of the stream.
+            */
+            std::vector<char> data;
+
+            /**
+            * Tag set by the producer, e.g. to tell blocks decoded before and
+            * after a seek apart.
+            */
+            unsigned int generation;
+        };
+
+        /**
+        * Constructor.
+        * @param blocks is the number of blocks the ring can hold. It is
+        * rounded up to a power of two.
+        */
+        PCMRing(unsigned int blocks=0);
+
+        /**
+        * Change the number of blocks, throwing away any blocks in the ring.
+        * Must not be called while the producer or consumer use the ring.
+        */
+        void resize(unsigned int blocks);
+
+        /**
+        * @return the number of blocks the ring can hold.
+        */
+        unsigned int capacity() const { return blocks_.size(); }
+
+        /**
+        * @return the number of blocks ready for the consumer.
+        */
+        unsigned int size() const { return (unsigned int)write_-(unsigned int)read_; }
+
+        bool empty() const { return size()==0; }
+        bool full() const { return size()==capacity(); }
+
+        /**
+        * Producer: the block to fill next, or NULL if the ring is full.
+        */
+        Block *back();
+
+        /**
+        * Producer: hand the block returned by back() over to the consumer.
+        */
+        void push();
+
+        /**
+        * Consumer: the oldest block, or NULL if the ring is empty.
+        * It stays valid until pop() is called.
+        */
+        const Block *front() const;
+
+        /**
+        * Consumer: give the block returned by front() back to the producer.
+        */
+        void pop();
+
+    protected:
+        std::vector<Block> blocks_;
+        unsigned int mask_;
+
+        /**
+        * Total number of blocks pushed and popped. Each is only written by one
+        * side, and the difference is the number of blocks in the ring.
+        */
+        OpenThreads::Atomic write_,read_;
+    };
+
+}
+
+#endif /* OPENALPP_PCMRING_H */
@@ -0,0 +1,166 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_RESAMPLER_H
+#define OPENALPP_RESAMPLER_H 1
+
+#include <vector>
+
+#ifdef WIN32
+// Ignore the dll interface warning using std::vector members
+#pragma warning(disable : 4251)
+#endif
+
+#include <openalpp/Export.h>
+
+namespace openalpp {
+
+    /**
+    * Sample rate converter for interleaved 16 bit samples.
+    * A polyphase windowed-sinc (Kaiser) filter, interpolated between phases,
+    * so that any ratio can be used and changed on the fly, e.g. for pitch.
+    * When the rate is lowered, the cutoff follows the new Nyquist frequency
+    * to avoid aliasing.
+    * The filter kernel uses SSE2 (AVX when the compiler targets it) or NEON
+    * where available.
+    */
+    class OPENALPP_API Resampler {
+    public:
+        /**
+        * Length of the filter, trading speed for stopband attenuation.
+        */
+        enum Quality {
+            /**
+            * 8 taps, for pitch shifting of many sources in real time.
+            */
+            Fast,
+            /**
+            * 16 taps, the default.
+            */
+            Medium,
+            /**
+            * 32 taps, for conversion at load time.
+            */
+            Best
+        };
+
+        /**
+        * Constructor.
+        * @param channels is the number of interleaved channels.
+        * @param ratio is the number of input frames per output frame, i.e.
+        * the input rate divided by the output rate, or the pitch.
+        * @param quality is the length of the filter.
+        */
+        Resampler(unsigned int channels,double ratio,Quality quality=Medium);
+
+        /**
+        * Change the ratio, e.g. when the pitch changes. The next output frame
+        * continues smoothly from the last one.
+        */
+        void setRatio(double ratio);
+
+        double getRatio() const { return ratio_; }
+
+        Quality getQuality() const { return quality_; }
+
+        /**
+        * @return the most output frames that process() can give for a number
+        * of input frames.
+        */
+        unsigned long getMaxOutput(unsigned long frames) const;
+
+        /**
+        * Convert a part of a stream.
+        * Input that isn't needed for the output yet is kept for the next call.
+        * @param in is the input samples.
+        * @param frames is the number of input frames.
+        * @param out gets the output samples.
+        * @param maxframes is the room in out, in frames. Make it at least
+        * getMaxOutput(frames) to not lose output.
+        * @return the number of frames written to out.
+        */
+        unsigned long process(const short *in,unsigned long frames,short *out,unsigned long maxframes);
+
+        /**
+        * Get the rest of the output at the end of the stream.
+        * @return the number of frames written to out.
+        */
+        unsigned long flush(short *out,unsigned long maxframes);
+
+        /**
+        * Forget the stream, to start on a new one.
+        */
+        void reset();
+
+        /**
+        * Convert a whole buffer, reusing the memory of this resampler and of
+        * out, e.g. for one source after another.
+        * @param in is the input samples.
+        * @param frames is the number of input frames.
+        * @param out gets the output samples.
+        */
+        void convert(const short *in,unsigned long frames,std::vector<short> &out);
+
+        /**
+        * Convert a whole buffer.
+        * @param in is the input samples.
+        * @param frames is the number of input frames.
+        * @param channels is the number of interleaved channels.
+        * @param ratio is the input rate divided by the output rate.
+        * @param out gets the output samples.
+        * @param quality is the length of the filter.
+        */
+        static void resample(const short *in,unsigned long frames,unsigned int channels,
+            double ratio,std::vector<short> &out,Quality quality=Medium);
+
+    protected:
+        void buildTable();
+        unsigned long produce(short *out,unsigned long maxframes,double end);
+
+        unsigned int channels_,taps_,phases_;
+        Quality quality_;
+        double ratio_,cutoff_;
+
+        /**
+        * The coefficients of each phase, followed by the difference to the
+        * next phase, taps_ each.
+        */
+        std::vector<float> table_;
+
+        /**
+        * The input that is still needed, for each channel.
+        */
+        std::vector<std::vector<float> > history_;
+
+        /**
+        * Position of the next output frame, in input frames from the start
+        * of history_.
+        */
+        double position_;
+    };
+
+}
+
+#endif /* OPENALPP_RESAMPLER_H */
@@ -28,23 +28,76 @@
 
 #include <openalpp/windowsstuff.h>
 #include <openalpp/SoundData.h>
+#include <openalpp/DataBlock.h>
+#include <openalpp/SampleCache.h>
 #include <openalpp/Error.h>
 
 #include <string>
+#include <vector>
+#include <iosfwd>
 
 namespace openalpp {
 
     /**
-    * Class for loading sampled files.
+    * Class for loading sampled files. WAV files are loaded natively, directly
+    * from the mapped file when OpenAL can take the samples as they are. Other
+    * files are decoded completely by a decoder from the StreamDecoderRegistry.
+    * Rarely played sounds can be kept Compressed instead, see Residency.
     */
     class OPENALPP_API Sample : public SoundData {
     public:
+        /**
+        * How the sound of a sample is kept in memory.
+        */
+        enum Residency {
+            /**
+            * Decoded into the buffer when loaded.
+            */
+            Decoded,
+            /**
+            * The file is kept in memory, and decoded into the buffer when
+            * played. The decoded sound is dropped again when the SampleCache
+            * needs the room. Costs decoding time on play, in exchange for the
+            * memory of rarely played sounds, e.g. Ogg Vorbis or ADPCM effects.
+            */
+            Compressed
+        };
+
         /**
         * Constructor.
         * @param filename is name of file to load.
         */
         Sample(const std::string& filename ) throw (FileError);
 
+        /**
+        * Constructor.
+        * @param filename is name of file to load.
+        * @param residency is how to keep the sound in memory. Compressed
+        * samples must be WAV files or files with a StreamDecoder.
+        */
+        Sample(const std::string& filename,Residency residency) throw (FileError);
+
+        /**
+        * Constructor. Loads a sound file (e.g. a WAV file) that is in memory.
+        * @param block is the contents of the file.
+        */
+        Sample(const DataBlock *block) throw (FileError);
+
+        /**
+        * Constructor. Loads a sound file that is in memory.
+        * @param block is the contents of the file, which a Compressed sample
+        * keeps a reference to.
+        * @param residency is how to keep the sound in memory.
+        */
+        Sample(const DataBlock *block,Residency residency) throw (FileError);
+
+        /**
+        * Constructor. Loads a sound file from a stream, e.g. a file in an
+        * osgDB::Archive.
+        * @param stream is the stream to read the file from.
+        */
+        Sample(std::istream &stream) throw (FileError);
+
         /**
         * Copy constructor.
         */
@@ -66,6 +119,54 @@ namespace openalpp {
         */
         std::string getFileName() const;
 
+        Residency getResidency() const { return entry_.valid() ? Compressed : Decoded; }
+
+        /**
+        * Decode the sound again, from the file of a Compressed sample or
+        * from the named file. Used by GroupSource to mix the sound. Samples
+        * loaded from memory keep nothing to decode, see decodeFile().
+        * @param pcm is set to the samples.
+        * @param format is set to the format of the samples.
+        * @param frequency is set to the sample rate.
+        */
+        void getPCM(std::vector<char> &pcm,ALenum &format,unsigned int &frequency) const
+            throw (FileError);
+
+        /**
+        * Decode a sound file in memory, the way samples are loaded.
+        * @param block is the contents of the file.
+        * @param pcm is set to the samples.
+        * @param format is set to the format of the samples.
+        * @param frequency is set to the sample rate.
+        */
+        static void decodeFile(const DataBlock *block,std::vector<char> &pcm,
+                               ALenum &format,unsigned int &frequency) throw (FileError);
+
+        /**
+        * Make sure the sound is decoded into the buffer, for a Compressed
+        * sample. Called by Source before playing, the sound is kept until
+        * release() is called.
+        */
+        void acquire() throw (FileError);
+
+        /**
+        * Allow a Compressed sample to be emptied again, once it is playing.
+        * Called by Source.
+        */
+        void release();
+
+        /**
+        * Register a source that the buffer is attached to, so that a
+        * Compressed sample can be emptied while it isn't played.
+        * Called by Source.
+        */
+        void attach(ALuint sourcename);
+
+        /**
+        * Unregister a source, after the buffer is detached from it.
+        */
+        void detach(ALuint sourcename);
+
         /**
         * Assignment operator.
         */
@@ -78,11 +179,38 @@ namespace openalpp {
         virtual ~Sample();
 
     private:
+        friend class SampleCache;
+
+        /**
+        * Keep a file in memory to be decoded when played.
+        */
+        void keepCompressed(const DataBlock *block) throw (FileError);
+
+        /**
+        * Load a sound file in memory into the buffer.
+        */
+        void loadFromMemory(const DataBlock *block) throw (FileError);
+
+        /**
+        * Load a WAV file in memory into the buffer.
+        */
+        void loadWave(const DataBlock *block) throw (FileError);
+
+        /**
+        * Decode a file in memory into the buffer, e.g. an Ogg Vorbis file.
+        */
+        void decode(const DataBlock *block) throw (FileError);
+
         /**
         * File name.
         */
         std::string filename_;
 
+        /**
+        * The file of a Compressed sample.
+        */
+        osg::ref_ptr<SampleCache::Entry> entry_;
+
     };
 
     /**
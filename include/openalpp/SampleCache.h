@@ -0,0 +1,170 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_SAMPLECACHE_H
+#define OPENALPP_SAMPLECACHE_H 1
+
+#include <list>
+#include <vector>
+
+#ifdef WIN32
+// Ignore the dll interface warning using std::vector members
+#pragma warning(disable : 4251)
+#endif
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <OpenThreads/Mutex>
+
+#include <openalpp/Export.h>
+#include <openalpp/DataBlock.h>
+#include <openalpp/Error.h>
+#include <openalpp/windowsstuff.h>
+#include <al.h>
+
+namespace openalpp {
+
+    class Sample;
+
+    /**
+    * Budget for the decoded sound of Compressed samples (see Sample::Residency).
+    * A Compressed sample keeps its file in memory, and is decoded into its
+    * buffer when it is played. When the decoded sound of all such samples
+    * takes more than the budget, the least recently played samples that no
+    * source is playing are emptied again.
+    */
+    class OPENALPP_API SampleCache : public osg::Referenced {
+    public:
+        /**
+        * The file and state of one Compressed sample, shared by its copies.
+        */
+        class OPENALPP_API Entry : public osg::Referenced {
+        public:
+            Entry(const DataBlock *block,ALuint buffer);
+
+            const DataBlock *getBlock() const { return block_.get(); }
+            ALuint getBuffer() const { return buffer_; }
+
+            /**
+            * @return the size of the decoded sound in the buffer, 0 if it isn't decoded.
+            */
+            unsigned long getSize() const { return size_; }
+
+        protected:
+            virtual ~Entry();
+
+            friend class SampleCache;
+
+            osg::ref_ptr<const DataBlock> block_;
+            ALuint buffer_;
+            unsigned long size_;
+            unsigned int pins_;             // Plays in progress, guarded by SampleCache::mutex_
+            std::vector<ALuint> sources_;   // Sources the buffer is attached to
+            OpenThreads::Mutex mutex_;      // Held while decoding, and for sources_
+        };
+
+        static SampleCache *instance();
+
+        /**
+        * Set the budget for decoded sound.
+        * @param bytes is the budget, the default is 64 MB.
+        */
+        void setMaxSize(unsigned long bytes);
+        unsigned long getMaxSize() const { return maxSize_; }
+
+        /**
+        * @return the size of the decoded sound of all Compressed samples.
+        */
+        unsigned long getSize() const { return size_; }
+
+        /**
+        * Empty samples until the decoded sound is within the budget, as far
+        * as possible: samples that are playing are kept.
+        */
+        void trim();
+
+        /**
+        * Make sure the sound of an entry is decoded. Called by Sample::acquire().
+        * The entry isn't emptied until it is released again, so that it can
+        * be played.
+        * @param entry is the entry.
+        * @param sample is a sample of the entry, that decodes the file.
+        */
+        void acquire(Entry *entry,Sample *sample) throw (FileError);
+
+        /**
+        * Release an entry after playing it. Called by Sample::release().
+        */
+        void release(Entry *entry);
+
+        /**
+        * Register a source that the buffer of an entry is attached to.
+        */
+        void attach(Entry *entry,ALuint sourcename);
+
+        /**
+        * Unregister a source, after detaching the buffer from it.
+        */
+        void detach(Entry *entry,ALuint sourcename);
+
+    protected:
+        SampleCache();
+        virtual ~SampleCache() {}
+
+        /**
+        * Set the buffer of all sources of an entry.
+        */
+        void setSources(Entry *entry,ALuint buffer);
+
+        /**
+        * Add a decoded entry to the cache, and trim it.
+        */
+        void loaded(Entry *entry);
+
+        /**
+        * Make an entry the most recently used one.
+        */
+        void touch(Entry *entry);
+
+        /**
+        * Remove an entry that is destroyed.
+        */
+        void remove(Entry *entry);
+
+        /**
+        * Empty the buffer of an entry, unless it is acquired or playing.
+        * Called with mutex_ held.
+        * @return true if the entry was emptied.
+        */
+        bool evict(Entry *entry);
+
+        std::list<Entry *> entries_;    // Decoded entries, most recently used first
+        unsigned long maxSize_,size_;
+        OpenThreads::Mutex mutex_;
+    };
+
+}
+
+#endif /* OPENALPP_SAMPLECACHE_H */
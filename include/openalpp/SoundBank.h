@@ -0,0 +1,218 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_SOUNDBANK_H
+#define OPENALPP_SOUNDBANK_H 1
+
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+// Ignore the dll interface warning using std::vector members
+#pragma warning(disable : 4251)
+#endif
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+
+#include <openalpp/Export.h>
+#include <openalpp/Error.h>
+#include <openalpp/DataBlock.h>
+#include <openalpp/Sample.h>
+
+namespace openalpp {
+
+    /**
+    * A packed file of many sounds, mapped into memory as a whole so that
+    * loading a sound from it needs no file I/O of its own.
+    *
+    * The file starts with a header, followed by an index sorted by the hash
+    * of the sound names, the names, and the sounds, each aligned for the
+    * mapping. All numbers are little endian 32 bit words:
+    * - Header: "OABK", version, number of sounds, offset of the index, offset
+    *   and size of the names, alignment of the sounds, and a reserved word.
+    * - Index entry: name hash, name offset and length, encoding, channels,
+    *   frequency, loop start and end frames, offset (low, high) and size
+    *   (low, high) of the sound, and four reserved words.
+    *
+    * Sounds are either raw 16 bit PCM, decoded when the bank was built, or
+    * copies of the original files (e.g. Ogg Vorbis), which are decoded when
+    * loaded or kept compressed.
+    */
+    class OPENALPP_API SoundBank : public osg::Referenced {
+    public:
+        /**
+        * How a sound is stored in the bank.
+        */
+        enum Encoding {
+            /**
+            * Interleaved little endian 16 bit samples.
+            */
+            PCM16=0,
+            /**
+            * A sound file, as it was on disk.
+            */
+            File=1
+        };
+
+        /**
+        * A sound in the bank.
+        */
+        struct Entry {
+            unsigned int hash;
+            std::string name;
+            Encoding encoding;
+            unsigned int channels,frequency;
+            unsigned long loopStart,loopEnd;
+            size_t offset,size;
+        };
+
+        /**
+        * Constructor. Maps a bank file, and reads its index.
+        * A FileError is thrown if the file can't be mapped or isn't a bank.
+        * @param filename is the name of the bank file.
+        */
+        SoundBank(const std::string &filename) throw (FileError);
+
+        /**
+        * Constructor. Reads the index of a bank that is in memory.
+        * @param block is the bank.
+        */
+        SoundBank(const DataBlock *block) throw (FileError);
+
+        /**
+        * Hash a sound name the way the index does. Names are case insensitive,
+        * and both '/' and '\' separate directories.
+        */
+        static unsigned int hash(const std::string &name);
+
+        /**
+        * Find a sound.
+        * @param name is the name of the sound, relative to the directory the
+        * bank was built from, e.g. "effects/door.wav".
+        * @return the sound, or NULL if it isn't in the bank.
+        */
+        const Entry *find(const std::string &name) const;
+
+        /**
+        * @return the sounds, in the order of the index.
+        */
+        const std::vector<Entry> &getEntries() const { return entries_; }
+
+        /**
+        * Get the data of a sound. The block keeps the bank mapped.
+        */
+        DataBlock *getData(const Entry *entry) const;
+
+        /**
+        * Create a sample from a sound. The loop points of the sound are set
+        * on decoded samples, if the AL_SOFT_loop_points extension is present.
+        * A NameError is thrown if the sound isn't in the bank.
+        * @param name is the name of the sound.
+        * @param residency is how to keep the sample in memory. Only sounds
+        * stored as files can be Compressed, PCM sounds are always Decoded.
+        */
+        Sample *createSample(const std::string &name,
+            Sample::Residency residency=Sample::Decoded) const throw (NameError,FileError);
+
+    protected:
+        virtual ~SoundBank() {}
+
+        void readIndex() throw (FileError);
+
+        osg::ref_ptr<const DataBlock> block_;
+        std::vector<Entry> entries_;
+    };
+
+    /**
+    * Builds a SoundBank file.
+    */
+    class OPENALPP_API SoundBankWriter {
+    public:
+        /**
+        * Constructor.
+        * @param alignment is the alignment of the sounds in the file, in bytes.
+        * Use the page size to map sounds independently of each other.
+        */
+        SoundBankWriter(unsigned int alignment=16);
+
+        /**
+        * Resample decoded sounds to a frequency, e.g. the one of the device,
+        * so that it isn't done when playing. 0, the default, keeps the
+        * frequency of each sound.
+        */
+        void setFrequency(unsigned int frequency) { frequency_=frequency; }
+        unsigned int getFrequency() const { return frequency_; }
+
+        /**
+        * Add a sound file.
+        * @param name is the name to find the sound by.
+        * @param file is the contents of the file.
+        * @param decode decodes the file to PCM, if a StreamDecoder can decode
+        * it. Otherwise the file is stored as it is.
+        * @return false if the file is neither a WAV file nor in a format with
+        * a StreamDecoder.
+        */
+        bool add(const std::string &name,const DataBlock *file,bool decode);
+
+        /**
+        * Add decoded sound.
+        * @param name is the name to find the sound by.
+        * @param data is interleaved 16 bit samples, in the byte order of the
+        * machine.
+        * @param frames is the number of sample frames in data.
+        * @param loopStart is the first frame of the loop.
+        * @param loopEnd is the frame after the loop, 0 for no loop.
+        */
+        void addPCM(const std::string &name,const short *data,unsigned long frames,
+            unsigned int channels,unsigned int frequency,
+            unsigned long loopStart=0,unsigned long loopEnd=0);
+
+        /**
+        * @return the number of sounds added.
+        */
+        unsigned int getNumSounds() const { return sounds_.size(); }
+
+        /**
+        * Write the bank.
+        * A FileError is thrown if the file can't be written, or if two sounds
+        * have the same name.
+        */
+        void write(const std::string &filename) throw (FileError);
+
+    protected:
+        struct Sound {
+            SoundBank::Entry entry;
+            osg::ref_ptr<const DataBlock> data;
+            bool operator<(const Sound &other) const;
+        };
+
+        unsigned int alignment_,frequency_;
+        std::vector<Sound> sounds_;
+    };
+
+}
+
+#endif /* OPENALPP_SOUNDBANK_H */
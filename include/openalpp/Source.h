@@ -143,6 +143,22 @@ namespace openalpp {
         */
         void play();
 
+        /**
+        * Get a stream ready to play on the source, by decoding and queueing
+        * its first buffers. A following play() starts it instantly.
+        * This will change the source's buffer.
+        * @param stream is the stream to preroll.
+        * @param timeout is the longest time to wait for the decoder, in seconds.
+        * @return false if the stream couldn't be prerolled, it then starts
+        * with the usual delay.
+        */
+        bool preroll( Stream *stream, float timeout=1.0f);
+
+        /**
+        * Preroll the stream already associated with the source.
+        */
+        bool preroll(float timeout=1.0f);
+
         /**
         * Stop this source.
         * This is needed here for streaming sources...
@@ -26,7 +26,10 @@
 #ifndef OPENALPP_STREAM_H
 #define OPENALPP_STREAM_H 1
 
+#include <map>
+
 #include <osg/ref_ptr>
+#include <OpenThreads/Mutex>
 
 #include <openalpp/Export.h>
 #include <openalpp/SoundData.h>
@@ -52,7 +55,70 @@ namespace openalpp {
         */
         osg::ref_ptr<SoundData> buffer2_;
 
+        /**
+        * Any buffers beyond the first two, for streams queueing more buffers.
+        */
+        std::vector<osg::ref_ptr<SoundBuffer> > morebuffers_;
+
         osg::ref_ptr<StreamUpdater> updater_;
+
+        /**
+        * The updater streaming to a source, and the buffers it queues if they
+        * are its own.
+        */
+        struct Cursor {
+            std::vector<osg::ref_ptr<SoundBuffer> > buffers;
+            osg::ref_ptr<StreamUpdater> updater;
+        };
+
+        /**
+        * The updater of each source that plays the stream. The first source
+        * uses updater_, others get cursors of their own if the stream can
+        * create them.
+        */
+        std::map<ALuint,Cursor> cursors_;
+        mutable OpenThreads::Mutex cursorMutex_;
+
+        /**
+        * Get the names of nbuffers buffers to stream with, generating any
+        * needed beyond buffer_ and buffer2_.
+        * @param nbuffers is the number of buffers, at least two.
+        */
+        std::vector<ALuint> createBuffers(unsigned int nbuffers) throw (NameError);
+
+        /**
+        * Generate nbuffers new buffers.
+        * @param buffers holds on to the buffers.
+        * @return the names of the buffers.
+        */
+        std::vector<ALuint> generateBuffers(unsigned int nbuffers,
+            std::vector<osg::ref_ptr<SoundBuffer> > &buffers) throw (NameError);
+
+        /**
+        * Create an updater for one more source, streaming the same data as
+        * updater_ from a position of its own.
+        * @param cursor gets the updater and its buffers.
+        * @return false if not supported, the sources then share updater_ and
+        * play in lock-step.
+        */
+        virtual bool createCursor(Cursor &cursor) { return false; }
+
+        /**
+        * Get the updater for a source, creating a cursor for it if needed.
+        * @param added is set to true if the source is new to the stream.
+        */
+        osg::ref_ptr<StreamUpdater> attach(ALuint sourcename,bool &added);
+
+        /**
+        * @return the updater of a source, or updater_ if it isn't playing.
+        */
+        osg::ref_ptr<StreamUpdater> getUpdater(ALuint sourcename);
+
+        /**
+        * @return all updaters of the stream, updater_ first.
+        */
+        std::vector<osg::ref_ptr<StreamUpdater> > getUpdaters() const;
+
     public:
         /**
         * Default constructor.
@@ -80,16 +146,51 @@ namespace openalpp {
         void record(ALuint sourcename);
 
         /**
-        * Seeks to specified time
+        * Decode and queue the first buffers on a source ahead of time, so that
+        * it starts without delay when played.
+        * @param sourcename is the (OpenAL) name of the source.
+        * @param timeout is the longest time to wait for the decoder, in seconds.
+        * @return false if the stream can't be prerolled, e.g. because it is
+        * already playing on another source. It is then started as usual when
+        * played.
+        */
+        bool preroll(ALuint sourcename,float timeout=1.0f);
+
+        /**
+        * Seeks all sources to specified time
         */
         void seek(float time_s); 
 
+        /**
+        * Seeks one source to specified time, leaving any others alone if they
+        * have cursors of their own.
+        */
+        void seek(ALuint sourcename,float time_s);
+
         /**
         * Stop recording.
         * @param sourcename is the (OpenAL) name of the source.
         */
         void stop(ALuint sourcename);
 
+        /**
+        * Tell the stream that a source has been paused or resumed.
+        */
+        void wake();
+        void wake(ALuint sourcename);
+
+        /**
+        * @return how many times the stream has run out of queued data while
+        * playing, on any source.
+        */
+        unsigned int getUnderrunCount() const;
+
+        /**
+        * @return how many times the stream has resumed playing after running
+        * out, on any source.
+        */
+        unsigned int getRecoveryCount() const;
+
     protected:
         /**
         * Destructor.
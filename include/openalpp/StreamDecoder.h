@@ -0,0 +1,184 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_STREAMDECODER_H
+#define OPENALPP_STREAMDECODER_H 1
+
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+// Ignore the dll interface warning using std::vector members
+#pragma warning(disable : 4251)
+#endif
+
+#include <al.h>
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <OpenThreads/Mutex>
+
+#include <openalpp/Export.h>
+#include <openalpp/DataBlock.h>
+#include <openalpp/windowsstuff.h>
+
+namespace openalpp {
+
+    /**
+    * Decoder of one sound file, for streaming.
+    * Decoders read from a file in memory, and deliver interleaved 16 bit
+    * signed samples in the byte order of the machine.
+    */
+    class OPENALPP_API StreamDecoder : public osg::Referenced {
+    public:
+        StreamDecoder();
+
+        unsigned int getChannels() const { return channels_; }
+
+        /**
+        * @return the sample frames per second.
+        */
+        unsigned int getFrequency() const { return frequency_; }
+
+        /**
+        * @return the length in sample frames, 0 if unknown.
+        */
+        unsigned long getFrames() const { return frames_; }
+
+        /**
+        * @return the (OpenAL) format of the decoded data, or 0 if the
+        * number of channels isn't supported.
+        */
+        ALenum getFormat() const;
+
+        /**
+        * Decode the next samples.
+        * @param buffer gets the samples.
+        * @param length is the size of the buffer in bytes, a multiple of the
+        * frame size.
+        * @return the number of bytes decoded, 0 at the end of the file or
+        * negative on errors.
+        */
+        virtual long read(char *buffer,unsigned int length)=0;
+
+        /**
+        * Seek to a sample frame, so that it is the next one read.
+        * @return true if the seek succeeded.
+        */
+        virtual bool seek(unsigned long frame)=0;
+
+        /**
+        * Get a tag from the metadata of the file, e.g. LOOPSTART.
+        * @return the value, or an empty string if there is no such tag.
+        */
+        virtual std::string getTag(const std::string &name) { return std::string(); }
+
+    protected:
+        virtual ~StreamDecoder();
+
+        unsigned int channels_,frequency_;
+        unsigned long frames_;
+    };
+
+    /**
+    * Creates decoders for one file format.
+    */
+    class OPENALPP_API StreamDecoderFactory : public osg::Referenced {
+    public:
+        /**
+        * @return the name of the format, e.g. "Ogg Vorbis".
+        */
+        virtual const char *getName() const=0;
+
+        /**
+        * Check if data is in the format.
+        * @param data is the start of a file.
+        * @param size is the size of data, at least the first 4k of the file
+        * unless it is shorter.
+        */
+        virtual bool probe(const char *data,size_t size) const=0;
+
+        /**
+        * @return the relative CPU cost of decoding. When several decoders
+        * can decode a file, the cheapest one is used.
+        */
+        virtual float getCost() const=0;
+
+        /**
+        * Create a decoder.
+        * @param block is the file, which the decoder holds on to.
+        * @param filename is the name of the file, empty if it isn't from a
+        * file. Decoders can use it to share data between streams of a file.
+        * @return the decoder, or NULL if the file can't be decoded after all.
+        */
+        virtual StreamDecoder *open(const DataBlock *block,const std::string &filename)=0;
+
+    protected:
+        virtual ~StreamDecoderFactory() {}
+    };
+
+    /**
+    * The decoders available for streaming. WAV and Ogg Vorbis are always
+    * registered, FLAC and Opus if the libraries were found when building.
+    * Applications can add decoders for other formats.
+    */
+    class OPENALPP_API StreamDecoderRegistry : public osg::Referenced {
+    public:
+        static StreamDecoderRegistry *instance();
+
+        /**
+        * Add a decoder factory.
+        */
+        void add(StreamDecoderFactory *factory);
+
+        /**
+        * Remove a decoder factory.
+        */
+        void remove(StreamDecoderFactory *factory);
+
+        /**
+        * Create a decoder with the cheapest factory that can decode a file.
+        * @param block is the file.
+        * @param filename is the name of the file, if any.
+        * @return the decoder, or NULL if no decoder can decode the file.
+        */
+        StreamDecoder *open(const DataBlock *block,const std::string &filename=std::string());
+
+        /**
+        * @return true if some decoder can decode data (the start of a file).
+        */
+        bool canDecode(const char *data,size_t size);
+
+    protected:
+        StreamDecoderRegistry();
+        virtual ~StreamDecoderRegistry() {}
+
+        std::vector<osg::ref_ptr<StreamDecoderFactory> > factories_;
+        OpenThreads::Mutex mutex_;
+    };
+
+}
+
+#endif /* OPENALPP_STREAMDECODER_H */
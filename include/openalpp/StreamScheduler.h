@@ -0,0 +1,190 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_STREAMSCHEDULER_H
+#define OPENALPP_STREAMSCHEDULER_H 1
+
+#include <vector>
+
+#ifdef WIN32
+// Ignore the dll interface warning using std::vector members
+#pragma warning(disable : 4251)
+#endif
+
+#include <openalpp/Export.h>
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/Timer>
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+
+namespace openalpp {
+
+    class StreamUpdater;
+
+    /**
+    * Shared service threads for streams.
+    * Instead of running one thread per stream, updaters register with the
+    * scheduler, which calls StreamUpdater::service() on each of them shortly
+    * before its queued sound data runs out. The number of threads is fixed,
+    * regardless of how many streams are playing.
+    * Decoding runs on threads of its own, calling StreamUpdater::decode(), so
+    * that a slow decoder never delays refilling the queue of another stream.
+    * On a loopback device the threads are parked, and the updaters are only
+    * serviced by serviceNow(), so that rendering doesn't depend on timing.
+    */
+    class OPENALPP_API StreamScheduler : public osg::Referenced {
+    public:
+        /**
+        * The two stages of streaming, each serviced by threads of its own.
+        */
+        enum Stage {
+            FEED,    // StreamUpdater::service(), queues decoded data
+            DECODE   // StreamUpdater::decode(), decodes ahead of the queue
+        };
+
+        /**
+        * Get the scheduler, it is created (and its threads started) on first use.
+        */
+        static StreamScheduler *instance();
+
+        /**
+        * Set the number of service threads.
+        * Must be called before the first stream is created to have any effect.
+        * @param n is the number of threads, the default is one.
+        */
+        static void setNumThreads(unsigned int n);
+
+        /**
+        * Get the number of service threads.
+        */
+        static unsigned int getNumThreads();
+
+        /**
+        * Set the number of decoder threads.
+        * Must be called before the first stream is created to have any effect.
+        * @param n is the number of threads, the default is one.
+        */
+        static void setNumDecodeThreads(unsigned int n);
+
+        /**
+        * Get the number of decoder threads.
+        */
+        static unsigned int getNumDecodeThreads();
+
+        /**
+        * Register an updater. It stays idle until wake() is called for it.
+        * @param updater is the updater to service.
+        */
+        void add(StreamUpdater *updater);
+
+        /**
+        * Unregister an updater.
+        * Waits for any service() or decode() call in progress on the updater to return.
+        * @param updater is the updater to remove.
+        */
+        void remove(StreamUpdater *updater);
+
+        /**
+        * Have an updater serviced as soon as possible.
+        * @param updater is the updater to wake.
+        * @param stage is the stage to run.
+        */
+        void wake(StreamUpdater *updater,Stage stage=FEED);
+
+        /**
+        * Service all registered updaters on the calling thread, decoding
+        * first and then feeding, for playback that runs ahead of the wall
+        * clock, like AudioEnvironment::render() of a loopback device.
+        * Updaters that another thread is busy with are waited for.
+        */
+        void serviceNow();
+
+        /**
+        * Service one updater on the calling thread, after waiting for any
+        * other thread that is busy with it.
+        * @param updater is the updater to service.
+        * @param stage is the stage to run.
+        */
+        void serviceNow(StreamUpdater *updater,Stage stage);
+
+        /**
+        * Get the number of registered updaters.
+        */
+        unsigned int getNumStreams();
+
+    protected:
+        StreamScheduler(unsigned int nthreads,unsigned int ndecodethreads);
+
+        /**
+        * Destructor. Stops and joins the service threads.
+        */
+        virtual ~StreamScheduler();
+
+        class ServiceThread;
+        friend class ServiceThread;
+
+        /**
+        * Main loop of the service threads.
+        * @param stage is the stage the thread runs.
+        */
+        void serviceLoop(Stage stage);
+
+        struct Task {
+            StreamUpdater *updater;
+            Stage stage;
+            osg::Timer_t due;   // When to service the updater next
+            bool idle;          // Not to be serviced until woken
+            bool busy;          // A thread is servicing the updater
+            bool woken;         // wake() was called while busy
+        };
+
+        Task *find(StreamUpdater *updater,Stage stage);
+
+        /**
+        * Reschedule a task after service() or decode() returned.
+        * @param delay is what they returned.
+        */
+        void finish(Task *task,double delay);
+
+        /**
+        * Run a stage of an updater on the calling thread, with mutex_ locked.
+        */
+        void runNow(StreamUpdater *updater,Stage stage);
+
+        std::vector<Task> tasks_;
+        std::vector<ServiceThread *> threads_;
+        OpenThreads::Mutex mutex_;
+        OpenThreads::Condition condition_;
+        bool done_;
+
+        static unsigned int nthreads_,ndecodethreads_;
+    };
+
+}
+
+#endif /* OPENALPP_STREAMSCHEDULER_H */
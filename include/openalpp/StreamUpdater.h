@@ -42,12 +42,14 @@
 
 
 #include <openalpp/AudioBase.h>
+#include <openalpp/PCMRing.h>
 #include <openalpp/Error.h>
 #include <openalpp/windowsstuff.h>
 #include <OpenThreads/Thread>
 #include <OpenThreads/Mutex>
 #include <osg/Referenced>
 #include <OpenThreads/ReentrantMutex>
+#include <OpenThreads/Condition>
 #include <OpenThreads/Block>
 
 namespace openalpp {
@@ -68,6 +70,16 @@ namespace openalpp {
         StreamUpdater(ALuint buffer1,ALuint buffer2,
             ALenum format,unsigned int frequency);
 
+        /**
+        * Constructor.
+        * @param buffers are the buffers used as a queue for streaming. Only
+        * updaters serviced by the StreamScheduler use more than two buffers.
+        * @param format is the (OpenAL) format of the sound.
+        * @param frequency is the frequency of the sound.
+        */
+        StreamUpdater(const std::vector<ALuint> &buffers,
+            ALenum format,unsigned int frequency);
+
 
         /**
         * Add a source to the stream.
@@ -82,9 +94,36 @@ namespace openalpp {
         void removeSource(ALuint sourcename);
 
         /**
-        * Seeks to specified time
+        * Remove a source on the calling thread, and stop being serviced by
+        * the StreamScheduler. For an updater that is released with the
+        * source, so that it isn't destroyed with the source still queued.
+        * @param sourcename is the OpenAL name of the source.
+        */
+        void removeSourceNow(ALuint sourcename);
+
+        /**
+        * Seeks to specified time.
+        * Only posts the request to the decoder stage, it never waits for it.
+        */
+        virtual void seek(float time_s);
+
+        /**
+        * Decode the first blocks and queue them on a source that isn't
+        * playing, so that playing it later starts instantly. The source is
+        * added to the stream, and is started by alSourcePlay() (e.g. through
+        * Source::play()).
+        * Only updaters serviced by the StreamScheduler can be prerolled, and
+        * only while no other source plays the stream.
+        * @param sourcename is the OpenAL name of the source.
+        * @param timeout is the longest time to wait for the decoder, in seconds.
+        * @return true if at least one buffer has been queued.
+        */
+        bool preroll(ALuint sourcename,double timeout);
+
+        /**
+        * @return true if the source has been prerolled and not started yet.
         */
-        virtual void seek(float time_s) {};
+        bool isPrerolled(ALuint sourcename);
 
 
         /**
@@ -109,7 +148,14 @@ namespace openalpp {
         /**
         Tell the thread to stop executing, also release it if it is waiting to play.
         */
-        virtual void stop() { stoprunning_ = true; release(); }
+        virtual void stop();
+
+        /**
+        * Have the stream check its sources as soon as possible, e.g. when one
+        * of them has been resumed after a pause. Streams don't poll paused
+        * sources.
+        */
+        void wake();
 
         /**
         @return true if the stop method has been called
@@ -127,8 +173,128 @@ namespace openalpp {
         */
         void setSleepTime(int mseconds) { sleepTime_ = mseconds; }
 
+        /**
+        * Inherited from Thread.
+        * Updaters serviced by the StreamScheduler don't run a thread of their own,
+        * threaded updaters (like DeviceUpdater) override this.
+        */
+        virtual void run() {}
+
+        /**
+        * Non-blocking update (the feeder stage), called from the StreamScheduler.
+        * Handles added/removed sources, fills and queues the buffers that are
+        * free with data from the decoder stage and starts the sources if needed.
+        * It never decodes.
+        * @return the time (in seconds) until the stream needs service again,
+        * or a negative value if it doesn't until it is woken up.
+        */
+        double service();
+
+        /**
+        * The decoder stage, called from the decoder threads of the StreamScheduler.
+        * Carries out pending seeks and decodes blocks with readBlock() until
+        * the ring of decoded blocks is full.
+        * @return a negative value, the feeder wakes the decoder when it has
+        * used up a block.
+        */
+        double decode();
+
+        /**
+        * Set how many blocks of sound data to decode ahead of the buffer queue.
+        * Decoded blocks are kept in memory, so that a buffer that has been
+        * played can be refilled without waiting for the decoder.
+        * Must be called before the stream is played.
+        * @param blocks is the number of blocks, at least one. It is rounded up
+        * to a power of two.
+        */
+        void setDecodeAhead(unsigned int blocks);
+
+        /**
+        * @return the number of blocks decoded ahead of the buffer queue.
+        */
+        unsigned int getDecodeAhead() const { return ring_.capacity(); }
+
+        /**
+        * @return the number of buffers in the queue.
+        */
+        unsigned int getNumBuffers() const { return buffers_.size(); }
+
+        /**
+        * @return how many times the buffer queue has run dry while playing.
+        */
+        unsigned int getUnderrunCount() const { return underruns_; }
+
+        /**
+        * @return how many times playing has been resumed after an underrun.
+        */
+        unsigned int getRecoveryCount() const { return recoveries_; }
+
     protected:
 
+        /**
+        * Register with the StreamScheduler instead of running a thread.
+        * To be called from the constructor of derived updaters that implement
+        * readBlock().
+        */
+        void schedule();
+
+        /**
+        * Unregister from the StreamScheduler.
+        * Must be called from the destructor of the most derived class, before
+        * anything used by readBlock() is torn down.
+        */
+        void unschedule();
+
+        /**
+        * Have the decoder stage run as soon as possible.
+        */
+        void wakeDecoder();
+
+        /**
+        * Seek the decoder. Called from the decoder stage only.
+        * @return true if the seek succeeded.
+        */
+        virtual bool seekNow(float time_s) { return false; }
+
+        /**
+        * Decode the next block of sound data. Called from the decoder stage only.
+        * @param length is set to the length of the data (in bytes).
+        * @return a pointer to the data, valid until the next call, or NULL at
+        * the end of the stream.
+        */
+        virtual void *readBlock(unsigned int &length) { length=0; return NULL; }
+
+        /**
+        * Block the updater thread until wake() or stop() is called.
+        * @param seconds is the longest time to wait, negative to wait forever.
+        */
+        void waitForWake(double seconds);
+
+        /**
+        * Set bufferFrames_ from the size of the first buffer.
+        */
+        void updateBufferFrames();
+
+        /**
+        * Time until the buffer queue needs to be refilled, in seconds.
+        * That is when half of the queue has been played, but not before the
+        * buffer currently playing is done.
+        */
+        double timeToRefill();
+
+        /**
+        * Get the next decoded block to queue. Blocks decoded before the last
+        * seek are skipped, and eof_ is set at the end of the stream.
+        * @return the data, valid until doneBlock() is called, or NULL if the
+        * decoder hasn't caught up.
+        */
+        void *nextBlock(unsigned int &length);
+
+        /**
+        * Hand the block returned by nextBlock() back to the decoder.
+        */
+        void doneBlock();
+
         /**
         * Remove any sources that the user has scheduled for removal.
         */
@@ -152,7 +318,7 @@ namespace openalpp {
         /**
         * Names of the buffers to update.
         */
-        ALuint buffers_[2];
+        std::vector<ALuint> buffers_;
 
         /**
         * OpenAL format of the sound data.
@@ -191,6 +357,71 @@ namespace openalpp {
         *
         */
         OpenThreads::Block m_playEvent;
+
+        /**
+        * True if serviced by the StreamScheduler.
+        */
+        bool scheduled_;
+
+        /**
+        * True when readBlock() has reached the end of the stream.
+        */
+        bool eof_;
+
+        /**
+        * Number of sample frames in each queued buffer.
+        */
+        unsigned int bufferFrames_;
+
+        /**
+        * Blocks decoded ahead. Written by the decoder stage and read by the
+        * feeder stage, without locking.
+        */
+        PCMRing ring_;
+
+        /**
+        * Messages to the decoder stage. A seek stores the target time (in ms)
+        * and then bumps the generation; blocks are tagged with the generation
+        * they were decoded in.
+        */
+        OpenThreads::Atomic seekTarget_,generation_;
+
+        /**
+        * Set by the feeder when it runs out of decoded blocks, so that the
+        * decoder wakes it up with the next one.
+        */
+        OpenThreads::Atomic starving_;
+
+        /**
+        * Generation last seen by the feeder and the decoder, respectively.
+        */
+        unsigned int feedGeneration_,decodeGeneration_;
+
+        /**
+        * True when readBlock() has returned the last block. Decoder only.
+        */
+        bool decodeEof_;
+
+        unsigned int underruns_,recoveries_;
+
+        /**
+        * True while the buffers of the only source are queued by preroll(),
+        * waiting for it to be played.
+        */
+        bool prerolled_;
+
+        /**
+        * Set while preroll() waits for the decoder, which then signals
+        * wakeCondition_ as well.
+        */
+        OpenThreads::Atomic prerolling_;
+
+        /**
+        * Used by threaded updaters to sleep until they are needed.
+        */
+        OpenThreads::Mutex wakeMutex_;
+        OpenThreads::Condition wakeCondition_;
+        bool woken_;
     };
 
 }
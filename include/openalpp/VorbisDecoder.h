@@ -0,0 +1,83 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_VORBISDECODER_H
+#define OPENALPP_VORBISDECODER_H 1
+
+#include <vorbis/codec.h>
+#include <vorbis/vorbisfile.h>
+
+#include <openalpp/StreamDecoder.h>
+#include <openalpp/OggPageIndex.h>
+
+namespace openalpp {
+
+    /**
+    * Decoder for Ogg Vorbis files (http://www.vorbis.com/), through
+    * vorbisfile. Seeks through an OggPageIndex when there is one.
+    */
+    class OPENALPP_API VorbisDecoder : public StreamDecoder {
+    public:
+        /**
+        * Constructor. See valid().
+        * @param block is the file.
+        * @param index is an optional index of the pages of the file.
+        */
+        VorbisDecoder(const DataBlock *block,OggPageIndex *index=0L);
+
+        /**
+        * @return true if the file could be opened.
+        */
+        bool valid() const { return open_; }
+
+        long read(char *buffer,unsigned int length);
+        bool seek(unsigned long frame);
+        std::string getTag(const std::string &name);
+
+    protected:
+        virtual ~VorbisDecoder();
+
+        /**
+        * Decode and throw away sample frames.
+        * @return true if all of them could be decoded.
+        */
+        bool skipFrames(ogg_int64_t frames);
+
+        OggVorbis_File oggfile_;
+        bool open_;
+        osg::ref_ptr<OggPageIndex> index_;
+    };
+
+    class OPENALPP_API VorbisDecoderFactory : public StreamDecoderFactory {
+    public:
+        const char *getName() const { return "Ogg Vorbis"; }
+        bool probe(const char *data,size_t size) const;
+        float getCost() const { return 1.0f; }
+        StreamDecoder *open(const DataBlock *block,const std::string &filename);
+    };
+
+}
+
+#endif /* OPENALPP_VORBISDECODER_H */
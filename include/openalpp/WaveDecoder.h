@@ -0,0 +1,109 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENALPP_WAVEDECODER_H
+#define OPENALPP_WAVEDECODER_H 1
+
+#include <openalpp/StreamDecoder.h>
+
+namespace openalpp {
+
+    /**
+    * Decoder for uncompressed WAV files: 8, 16, 24 and 32 bit integer and
+    * 32 bit float samples. Decoding is a copy, or a conversion to 16 bits.
+    */
+    class OPENALPP_API WaveDecoder : public StreamDecoder {
+    public:
+        /**
+        * Constructor. Reads the header, see valid().
+        * @param block is the file.
+        */
+        WaveDecoder(const DataBlock *block);
+
+        /**
+        * @return true if the file is an uncompressed WAV file.
+        */
+        bool valid() const { return blockAlign_!=0; }
+
+        /**
+        * @return the byte offset of the samples in the file.
+        */
+        size_t getDataOffset() const { return dataOffset_; }
+
+        /**
+        * @return the size of the samples in bytes.
+        */
+        size_t getDataSize() const { return dataSize_; }
+
+        /**
+        * @return the bits per sample as stored in the file.
+        */
+        unsigned int getBits() const { return bits_; }
+
+        /**
+        * @return the bytes per sample frame as stored in the file.
+        */
+        unsigned int getBlockAlign() const { return blockAlign_; }
+
+        /**
+        * @return true if the samples are stored as floats.
+        */
+        bool isFloat() const { return float_; }
+
+        /**
+        * @return the format tag of the file, e.g. 1 for PCM or 2 for MS
+        * ADPCM, also for files that can't be decoded. 0 if it isn't a WAV file.
+        */
+        unsigned int getEncoding() const { return encoding_; }
+
+        /**
+        * @return true if the data chunk is cut short by the end of the file.
+        */
+        bool isTruncated() const { return truncated_; }
+
+        long read(char *buffer,unsigned int length);
+        bool seek(unsigned long frame);
+
+    protected:
+        osg::ref_ptr<const DataBlock> block_;
+        size_t dataOffset_,dataSize_;
+        size_t position_;           // Read position, in bytes from dataOffset_
+        unsigned int bits_;         // Significant bits per sample
+        unsigned int blockAlign_;   // Bytes per sample frame
+        unsigned int encoding_;
+        bool float_,truncated_;
+    };
+
+    class OPENALPP_API WaveDecoderFactory : public StreamDecoderFactory {
+    public:
+        const char *getName() const { return "WAV"; }
+        bool probe(const char *data,size_t size) const;
+        float getCost() const { return 0.1f; }
+        StreamDecoder *open(const DataBlock *block,const std::string &filename);
+    };
+
+}
+
+#endif /* OPENALPP_WAVEDECODER_H */
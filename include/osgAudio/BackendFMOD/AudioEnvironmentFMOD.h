@@ -79,6 +79,29 @@ namespace osgAudio
 		void init(int frequency,int refresh=-1, bool displayInitMsgs=false )
 			throw (InitError);
 
+		/**
+		 * Loopback rendering is only implemented by the OpenAL backend.
+		 * Always throws InitError.
+		 */
+		void initLoopback(unsigned int frequency=44100,unsigned int channels=2,
+			bool floating=false,bool displayInitMsgs=false) throw (InitError);
+
+		/**
+		 * Is the environment rendering to a loopback device? Never with FMOD.
+		 */
+		bool isLoopback() { return false; }
+
+		/**
+		 * Get the size in bytes of one rendered frame. Always 0 with FMOD.
+		 */
+		unsigned int getRenderFrameSize() { return 0; }
+
+		/**
+		 * Loopback rendering is only implemented by the OpenAL backend.
+		 * Always throws FatalError.
+		 */
+		void render(void *buffer,unsigned int frames) throw (FatalError);
+
 		/**
 		 * Sets the speed of sound in the environment.
 		 * This is used in Doppler calculations.
@@ -26,6 +26,9 @@
 #ifndef OSGAUDIO_SAMPLEFMOD_H
 #define OSGAUDIO_SAMPLEFMOD_H 1
 
+#include <vector>
+#include <iosfwd>
+
 #include <osg/ref_ptr>
 #include <osg/Referenced>
 
@@ -51,6 +54,20 @@ namespace osgAudio
 		*/
 		Sample(const std::string& filename ) throw (FileError,NameError);
 
+		/**
+		* Constructor.
+		* @param filename is name of file to load.
+		* @param compressed keeps the file in memory and decodes it when played,
+		* rather than decoding it now. Saves memory for rarely played sounds.
+		*/
+		Sample(const std::string& filename, bool compressed ) throw (FileError,NameError);
+
+		/**
+		* Constructor. Loads a sound file from a stream, e.g. from an osgDB::Archive.
+		* @param stream is the stream to read the file from.
+		*/
+		Sample(std::istream& stream ) throw (FileError,NameError);
+
 		/**
 		* Copy constructor.
 		*/
@@ -72,6 +89,11 @@ namespace osgAudio
 		*/
 		std::string getFilename() const;
 
+		/**
+		* @return true if the file is kept compressed in memory.
+		*/
+		bool isCompressed() const { return _compressed; }
+
 		/**
 		* Assignment operator.
 		*/
@@ -95,9 +117,17 @@ namespace osgAudio
 		// the actual FMOD datatype
 		FMOD::Sound *_FMODSound;
 		std::string _internalFullPath;
+		bool _compressed;
+
+		// the file contents, when not loaded from a file
+		std::vector<char> _memory;
 
 		// actual create implementation
 		void createSampleFromFilename(const std::string& filename ) throw (FileError,NameError);
+		void createSampleFromMemory() throw (FileError,NameError);
+
+		// recreate like another sample, for copies
+		void createSampleLike(const Sample &sample) throw (FileError,NameError);
 
 	};
 
@@ -140,6 +140,17 @@ namespace osgAudio
 		*/
 		void play( Stream *stream);
 
+		/**
+		* Get a stream ready to play on the source ahead of time, so that a
+		* following play() starts it without delay.
+		* This will change the source's buffer.
+		* @param stream is the stream to preroll.
+		* @param timeout is the longest time to wait for the decoder, in seconds.
+		* @return false if the stream couldn't be prerolled, it then starts
+		* with the usual delay when played.
+		*/
+		bool preroll( Stream *stream, float timeout=1.0f);
+
 		/**
 		* Seek this source to specified time
 		* (streaming sources)
@@ -26,6 +26,9 @@
 #ifndef OSGAUDIO_STREAMFMOD_H
 #define OSGAUDIO_STREAMFMOD_H 1
 
+#include <vector>
+#include <iosfwd>
+
 #include <osg/ref_ptr>
 #include <osg/Referenced>
 
@@ -113,8 +116,18 @@ namespace osgAudio
 		// actual create implementation
 		void createStreamFromFilename(const std::string& filename ) throw (FileError,NameError);
 
+		// read a whole file from a stream into _memory and create from there
+		void createStreamFromStream(std::istream& stream ) throw (FileError,NameError);
+		void createStreamFromMemory() throw (FileError,NameError);
+
+		// recreate like another stream, for copies
+		void createStreamLike(const Stream &stream) throw (FileError,NameError);
+
 		std::string _filename;
 
+		// the file contents, when not created from a file
+		std::vector<char> _memory;
+
 
 	}; // Stream
 
@@ -84,6 +84,38 @@ namespace osgAudio
         void init(int frequency,int refresh=-1)
             throw (InitError);
 
+        /**
+         * Initialize the OpenALpp environment on a loopback device, that mixes
+         * only when render() is called instead of playing to a sound card.
+         * Used for rendering to file faster than realtime, and for deterministic
+         * output on machines without audio hardware.
+         * @param frequency is the rendered sample rate (in Hz)
+         * @param channels is the number of rendered channels: 1, 2, 4, 6, 7 or 8
+         * @param floating selects 32 bit float samples instead of 16 bit integers
+         * @param displayInitMsgs When set to true, init messages are written to console.
+         */
+        void initLoopback(unsigned int frequency=44100,unsigned int channels=2,
+            bool floating=false,bool displayInitMsgs=false) throw (InitError);
+
+        /**
+         * Is the environment rendering to a loopback device?
+         */
+        bool isLoopback();
+
+        /**
+         * Get the size in bytes of one rendered frame, all channels.
+         * @return 0 unless initialized with initLoopback().
+         */
+        unsigned int getRenderFrameSize();
+
+        /**
+         * Render the next frames of the mix, after servicing the streams.
+         * The 3D state set since the last call is used for the whole block.
+         * @param buffer receives frames*getRenderFrameSize() bytes of interleaved samples.
+         * @param frames is the number of frames to render.
+         */
+        void render(void *buffer,unsigned int frames) throw (FatalError);
+
         /**
          * Sets the speed of sound in the environment.
          * This is used in Doppler calculations.
@@ -55,6 +55,16 @@ namespace osgAudio
         FileStream(const std::string& filename,const int buffersize=4096) 
             throw (NameError,InitError,FileError);
 
+        /**
+        * Constructor. Reads a whole file from a stream into memory, e.g. from
+        * an osgDB::Archive, and streams from there.
+        * A FileError will be thrown if the data isn't recognized.
+        * @param stream is the stream to read the file from.
+        * @param buffersize is the same as for the constructor taking a filename.
+        */
+        FileStream(std::istream& stream,const int buffersize=4096) 
+            throw (NameError,InitError,FileError);
+
         /**
         * Copy constructor.
         */
@@ -69,6 +79,13 @@ namespace osgAudio
         */
         void setLooping(bool loop = true);
 
+        /**
+        * Set the part of the file to loop, when looping.
+        * @param start is the first sample frame of the loop.
+        * @param end is the sample frame after the loop, 0 for the end of the file.
+        */
+        void setLoopPoints(unsigned int start,unsigned int end = 0);
+
         std::string getFilename() const;
 
     protected:
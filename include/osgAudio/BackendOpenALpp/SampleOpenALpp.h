@@ -50,6 +50,25 @@ namespace osgAudio
         */
         Sample(const std::string& filename ) throw (FileError,NameError);
 
+        /**
+        * Constructor.
+        * @param filename is name of file to load.
+        * @param compressed keeps the file in memory and decodes it when played,
+        * rather than decoding it now. Saves memory for rarely played sounds.
+        */
+        Sample(const std::string& filename, bool compressed ) throw (FileError,NameError);
+
+        /**
+        * Constructor. Loads a sound file from a stream, e.g. from an osgDB::Archive.
+        * @param stream is the stream to read the file from.
+        */
+        Sample(std::istream& stream ) throw (FileError,NameError);
+
+        /**
+        * Constructor. Wraps an openalpp Sample, e.g. from an openalpp::SoundBank.
+        */
+        Sample(openalpp::Sample *sample );
+
         /**
         * Copy constructor.
         */
@@ -71,6 +90,11 @@ namespace osgAudio
         */
         std::string getFilename() const;
 
+        /**
+        * @return true if the file is kept compressed in memory.
+        */
+        bool isCompressed() const;
+
         /**
         * Assignment operator.
         */
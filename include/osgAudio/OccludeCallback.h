@@ -108,7 +108,6 @@ namespace osgAudio {
 
         SoundState *getSoundState() { return m_sound_state; }
 
-    private:
         friend class SoundUpdateCB;
         friend class SoundNode;
 
@@ -118,7 +117,7 @@ namespace osgAudio {
         \param sound_pos - Position of the current sound
         \param sound_state - The sound state to potentially occlude.
         */
-        void apply(const osg::Matrix& listener_matrix, const osg::Vec3& sound_pos, osgAudio::SoundState *sound_state);
+        virtual void apply(const osg::Matrix& listener_matrix, const osg::Vec3& sound_pos, osgAudio::SoundState *sound_state);
 
         // The node from which the intersect is performed
         osg::ref_ptr<osg::Node> m_root;
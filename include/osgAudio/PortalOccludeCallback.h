@@ -0,0 +1,95 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OSGAUDIO_PORTALOCCLUDECALLBACK_H
+#define OSGAUDIO_PORTALOCCLUDECALLBACK_H 1
+
+#include <osgAudio/Export.h>
+#include <osgAudio/OccludeCallback.h>
+#include <osgAudio/SoundPropagationGraph.h>
+
+namespace osgAudio {
+
+    /// Occlusion through a room/portal graph instead of line-of-sight rays
+    /*!
+    PortalOccludeCallback finds the shortest path through open SoundPortal nodes between
+    the SoundRoom of the listener and the SoundRoom of the sound. The sound is then
+    attenuated with the transmissions of the portals along the path, and moved to a virtual
+    position in the direction of the first portal seen by the listener, at the distance
+    of the full path.
+
+    The propagation graph is shared by copies of the callback, so a single graph can
+    serve all the sounds of a scene.
+
+    If directRaycast is enabled, sounds in the same room as the listener are
+    additionally tested for occlusion with the ray of the OccludeCallback.
+    */
+    class OSGAUDIO_EXPORT PortalOccludeCallback : public OccludeCallback {
+    public:
+
+        /*!
+        Constructor.
+        \param root - Rooms and portals are collected from all nodes below root.
+        */
+        PortalOccludeCallback(osg::Node *root);
+
+        /*!
+        Constructor without args.
+        */
+        PortalOccludeCallback();
+
+        // Implementation of virtual functions of osg::Object
+        virtual osg::Object* cloneType() const { return new PortalOccludeCallback(); }
+        virtual osg::Object* clone(const osg::CopyOp&) const {
+            return new PortalOccludeCallback(*this);
+        }
+        virtual const char* libraryName() const { return "osgAudio"; }
+        virtual const char* className() const { return "PortalOccludeCallback"; }
+
+        /// Set the graph used for propagation. It can be shared among several callbacks
+        void setPropagationGraph(SoundPropagationGraph *graph) { m_graph = graph; }
+
+        /// Get the graph used for propagation
+        SoundPropagationGraph *getPropagationGraph() { return m_graph.get(); }
+
+        /// Get the const graph used for propagation
+        const SoundPropagationGraph *getPropagationGraph() const { return m_graph.get(); }
+
+        /// Enable ray occlusion tests for sounds in the same room as the listener
+        void setDirectRaycast(bool flag) { m_direct_raycast = flag; }
+
+        ///
+        bool getDirectRaycast() const { return m_direct_raycast; }
+
+    protected:
+        virtual void apply(const osg::Matrix& listener_matrix, const osg::Vec3& sound_pos, osgAudio::SoundState *sound_state);
+
+        osg::ref_ptr<SoundPropagationGraph> m_graph;
+        bool m_direct_raycast;
+    };
+
+} // Namespace osgAudio
+
+#endif // OSGAUDIO_PORTALOCCLUDECALLBACK_H
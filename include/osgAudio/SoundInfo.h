@@ -0,0 +1,92 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OSGAUDIO_SOUNDINFO_H
+#define OSGAUDIO_SOUNDINFO_H 1
+
+#include <osgAudio/Export.h>
+
+#include <string>
+#include <iosfwd>
+
+namespace osgAudio 
+{
+
+    /// Format and length of a sound file, as read from its header.
+    /*!
+    Used to decide how to load a file without loading it: only the header of
+    a WAV or FLAC file, and the first and last pages of an Ogg file are read.
+    */
+    class OSGAUDIO_EXPORT SoundInfo
+    {
+    public:
+        enum Format { UNKNOWN, WAVE, OGG_VORBIS, OGG_OPUS, FLAC };
+
+        SoundInfo();
+
+        /// Reads the header of a file. \return false if the format isn't recognized.
+        bool read(const std::string& path);
+
+        /// Reads the header from a seekable stream. \return false if the format isn't recognized.
+        bool read(std::istream& stream);
+
+        Format getFormat() const { return m_format; }
+
+        /// True for WAV files with compressed samples, e.g. ADPCM
+        bool isCompressed() const { return m_compressed; }
+
+        unsigned int getChannels() const { return m_channels; }
+
+        /// Sample frames per second
+        unsigned int getFrequency() const { return m_frequency; }
+
+        /// Bits per sample once decoded
+        unsigned int getBitsPerSample() const { return m_bits; }
+
+        /// Length in sample frames, 0 if unknown
+        unsigned long getFrames() const { return m_frames; }
+
+        /// Length in seconds, 0 if unknown
+        double getDuration() const { return m_frequency ? (double)m_frames/m_frequency : 0.0; }
+
+        /// Size of the fully decoded sound in bytes, 0 if unknown
+        unsigned long getDecodedSize() const { return m_frames*m_channels*(m_bits/8); }
+
+    protected:
+        bool readWave(std::istream& stream);
+        bool readOgg(std::istream& stream);
+        bool readFlac(std::istream& stream);
+
+        Format m_format;
+        bool m_compressed;
+        unsigned int m_channels;
+        unsigned int m_frequency;
+        unsigned int m_bits;
+        unsigned long m_frames;
+    };
+
+} // namespace osgAudio
+
+#endif /* OSGAUDIO_SOUNDINFO_H */
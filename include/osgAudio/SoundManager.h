@@ -114,14 +114,31 @@ namespace osgAudio
         Each call to getSample will first look in the cache and try to find the
         path there. If it can be found, it will return that Sample.
         Otherwise it will be loaded from disk.
+        \param compressed - Keep the file compressed in memory and decode it when
+        played, for large but rarely played sounds. Only used when the file is loaded.
         */
-        osgAudio::Sample* getSample( const std::string& path, bool add_to_cache=true );
+        osgAudio::Sample* getSample( const std::string& path, bool add_to_cache=true, bool compressed=false );
 
         /*! 
         Clear the sample cache with all loaded samples.
         */
         void clearSampleCache(void) {  m_sample_cache.clear(); }
 
+        /*!
+        Mount a sound bank, built with the osgaudiobank tool. getSample() and
+        getSound() look up paths in the mounted banks, most recently mounted
+        first, before searching for files. The bank is mapped into memory, so
+        loading a sample from it needs no file I/O of its own.
+        Only supported by the OpenAL subsystem.
+        \return false if the bank can't be found or read.
+        */
+        bool mountSoundBank( const std::string& path );
+
+        /*!
+        Unmount all sound banks. Samples already loaded from them stay valid.
+        */
+        void unmountSoundBanks(void) { m_sound_banks.clear(); }
+
 
         /*! 
         Return a pointer to a Stream
@@ -137,6 +154,30 @@ namespace osgAudio
         */
         void clearStreamCache(void) {  m_stream_cache.clear(); }
 
+        /*!
+        Return a pointer to either a Sample or a Stream, whichever suits the file.
+        The header of the file is read to find out how large it is when decoded,
+        files larger than the streaming thresholds are loaded as a Stream, the
+        others as a Sample. Both are cached like with getSample() and getStream().
+        Pass the result to SoundState::setSound().
+        \return Null if the file can't be found.
+        */
+        osg::Referenced* getSound( const std::string& path, bool add_to_cache=true );
+
+        /*!
+        Set when getSound() streams a file rather than decoding it into a Sample.
+        \param max_sample_size - Files larger than this many bytes when decoded are streamed.
+        \param max_sample_duration - Files longer than this many seconds are streamed.
+        */
+        void setStreamingThresholds(unsigned long max_sample_size, float max_sample_duration)
+        {
+            m_max_sample_size = max_sample_size;
+            m_max_sample_duration = max_sample_duration;
+        }
+
+        unsigned long getMaxSampleSize() const { return m_max_sample_size; }
+        float getMaxSampleDuration() const { return m_max_sample_duration; }
+
 
         /*!
         Return a pointer to the SoundState with the name "id".
@@ -193,6 +234,13 @@ namespace osgAudio
         /// Set the transformation matrix for the listener
         void setListenerMatrix( const osg::Matrix& matrix);
 
+        /*!
+        Set the transformation matrix for the listener at a given time in seconds, used for
+        the velocity instead of the wall clock. SoundRoot passes the reference time of the frame,
+        so that Doppler stays right when frames are not rendered in realtime.
+        */
+        void setListenerMatrix( const osg::Matrix& matrix, double time );
+
         /// Return the current listener matrix
         const osg::Matrix &getListenerMatrix( ) const { return m_listener_matrix; }
 
@@ -288,6 +336,12 @@ namespace osgAudio
 
         void resetSource(osgAudio::Source *source);
 
+        /// Load a sample from the mounted sound banks, null if it isn't in any of them
+        osgAudio::Sample *getBankSample( const std::string& path, bool compressed );
+
+        /// The mounted sound banks, kept opaque to not depend on the subsystem here
+        std::vector< osg::ref_ptr<osg::Referenced> > m_sound_banks;
+
         typedef std::map<std::string, osg::ref_ptr<osgAudio::Sample> > SampleMap;
         typedef SampleMap::iterator SampleMapIterator;
         typedef SampleMap::value_type SampleMapValType;
@@ -300,6 +354,9 @@ namespace osgAudio
 
         StreamMap m_stream_cache;
 
+        unsigned long m_max_sample_size;
+        float m_max_sample_duration;
+
         osg::ref_ptr<osgAudio::Listener> m_listener;
         osgAudio::AudioEnvironment* m_sound_environment;
 
@@ -340,7 +397,7 @@ namespace osgAudio
         osg::Vec3 m_last_pos;
         float m_max_velocity;
         osg::Timer m_timer;
-        osg::Timer_t m_last_tick;
+        double m_last_time;
         bool m_first_run;
         bool m_clamp_velocity;
         float m_update_frequency;
@@ -0,0 +1,101 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef OSGAUDIO_SOUNDPORTAL_H
+#define OSGAUDIO_SOUNDPORTAL_H 1
+
+
+#include <osgAudio/Export.h>
+
+#include <string>
+
+#include <osg/Node>
+#include <osg/CopyOp>
+#include <osg/Vec3>
+
+namespace osgAudio
+{
+
+    /// A node describing an opening (door, window...) through which sound travels between two rooms.
+    /**
+    SoundPortal nodes are the edges of the sound propagation graph used by the
+    PortalOccludeCallback. A portal connects the two SoundRoom nodes with the given
+    names. An empty room name refers to the exterior, i.e. everything that is not
+    inside any SoundRoom.
+    The transmission is the fraction of the sound energy passing the portal, 1 for
+    a fully open door, 0 for a closed one. It can be changed at any time.
+    */
+    class OSGAUDIO_EXPORT SoundPortal: public osg::Node {
+    public:
+        /// Default constructor
+        SoundPortal();
+
+        /// Copy constructor
+        SoundPortal(const SoundPortal &copy, const osg::CopyOp &copyop = osg::CopyOp::SHALLOW_COPY);
+
+        META_Node(osgAudio, SoundPortal);
+
+        /// Set the names of the two rooms connected by this portal
+        void setRooms(const std::string& room_a, const std::string& room_b) { m_room_a = room_a; m_room_b = room_b; }
+
+        /// Get the name of the first room connected by this portal
+        const std::string& getRoomA() const { return m_room_a; }
+
+        /// Get the name of the second room connected by this portal
+        const std::string& getRoomB() const { return m_room_b; }
+
+        /// Set the (local) position of the center of the portal
+        void setCenter(const osg::Vec3& center) { m_center = center; dirtyBound(); }
+
+        /// Get the (local) position of the center of the portal
+        const osg::Vec3& getCenter() const { return m_center; }
+
+        /// Set the fraction [0..1] of the sound passing through the portal
+        void setTransmission(float t) { m_transmission = t; }
+
+        /// Get the fraction [0..1] of the sound passing through the portal
+        float getTransmission() const { return m_transmission; }
+
+        /// A portal with zero transmission is considered closed
+        bool isOpen() const { return m_transmission > 0.0f; }
+
+        /// The portal is a point in space, its bound is centered at getCenter()
+        virtual osg::BoundingSphere computeBound() const;
+
+    protected:
+        /// Destructor
+        virtual ~SoundPortal() {}
+
+        /// Assignment operator
+        SoundPortal &operator=(const SoundPortal &node);
+
+        std::string m_room_a, m_room_b;
+        osg::Vec3 m_center;
+        float m_transmission;
+    };
+
+} // namespace osgAudio
+
+
+#endif //OSGAUDIO_SOUNDPORTAL_H
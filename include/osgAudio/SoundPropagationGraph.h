@@ -0,0 +1,155 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OSGAUDIO_SOUNDPROPAGATIONGRAPH_H
+#define OSGAUDIO_SOUNDPROPAGATIONGRAPH_H 1
+
+#include <osgAudio/Export.h>
+
+#include <vector>
+#include <string>
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/observer_ptr>
+#include <osg/Node>
+#include <osg/BoundingBox>
+#include <osg/Vec3>
+
+#include <osgAudio/SoundRoom.h>
+#include <osgAudio/SoundPortal.h>
+
+namespace osgAudio {
+
+    /// Room/portal graph used to find how sound travels from an emitter to the listener.
+    /*!
+    The graph is collected from all SoundRoom and SoundPortal nodes found below a root node.
+    Room volumes and portal positions are stored in world coordinates, so if the rooms or
+    portals are moved, dirty() must be called to have the graph rebuilt. Portal transmissions
+    are read from the nodes each time they are needed, so doors can be opened and closed at
+    any time.
+
+    The shortest paths from the listener to all portals are computed once (Dijkstra) when
+    the listener moves, after which each emitter is resolved with a single lookup. This
+    replaces one intersection test per emitter and frame.
+    */
+    class OSGAUDIO_EXPORT SoundPropagationGraph : public osg::Referenced {
+    public:
+
+        /// Result of a propagation query
+        struct Path {
+            Path() : reachable(false), direct(true), attenuation(1.0f), distance(0.0f) {}
+
+            /// false if no open portal path connects emitter and listener
+            bool reachable;
+            /// true if emitter and listener are in the same room
+            bool direct;
+            /// Product of the transmissions of the portals along the path
+            float attenuation;
+            /// Length of the path through the portals
+            float distance;
+            /// Position the sound appears to come from, as seen by the listener
+            osg::Vec3 virtual_position;
+        };
+
+        /*!
+        Constructor.
+        \param root - Rooms and portals are collected from all nodes below root.
+        */
+        SoundPropagationGraph(osg::Node *root=0L);
+
+        /// Set the node below which rooms and portals are collected
+        void setRoot(osg::Node *root) { m_root = root; dirty(); }
+
+        /// Get the node below which rooms and portals are collected
+        osg::Node *getRoot() { return m_root.get(); }
+
+        /// Get the const node below which rooms and portals are collected
+        const osg::Node *getRoot() const { return m_root.get(); }
+
+        /// Force the graph to be rebuilt the next time it is used
+        void dirty() { m_dirty = true; }
+
+        /// Number of rooms in the graph, including the exterior
+        unsigned int getNumRooms() const { return m_rooms.size(); }
+
+        /// Number of portals in the graph
+        unsigned int getNumPortals() const { return m_portals.size(); }
+
+        /*!
+        Find the path from the emitter to the listener.
+        \param listener_pos - World position of the listener
+        \param sound_pos - World position of the emitter
+        \param path - Result of the query
+        */
+        void computePath(const osg::Vec3& listener_pos, const osg::Vec3& sound_pos, Path& path);
+
+    protected:
+        virtual ~SoundPropagationGraph() {}
+
+        /// Collect rooms and portals from the root node
+        void build();
+
+        /// Returns the index of the smallest room containing pos, 0 (the exterior) if none
+        unsigned int findRoom(const osg::Vec3& pos) const;
+
+        /// Recompute the shortest paths from the listener to all portals if needed
+        void updateListener(const osg::Vec3& listener_pos);
+
+        /// Returns the current transmission of a portal, 0 if it is closed or gone
+        float getTransmission(unsigned int portal) const;
+
+        struct Room {
+            std::string name;
+            osg::BoundingBox bounds;
+            std::vector<unsigned int> portals;
+        };
+
+        struct Portal {
+            osg::observer_ptr<SoundPortal> node;
+            osg::Vec3 position;
+            unsigned int rooms[2];
+        };
+
+        friend class CollectSoundRoomsVisitor;
+
+        osg::observer_ptr<osg::Node> m_root;
+        bool m_dirty;
+
+        std::vector<Room> m_rooms;
+        std::vector<Portal> m_portals;
+
+        // Shortest path state from the last listener position
+        osg::Vec3 m_listener_pos;
+        unsigned int m_listener_room;
+        bool m_listener_valid;
+        std::vector<float> m_distance;
+        std::vector<int> m_previous;
+        std::vector<float> m_transmissions;
+    };
+
+} // Namespace osgAudio
+
+#endif // OSGAUDIO_SOUNDPROPAGATIONGRAPH_H
@@ -0,0 +1,78 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef OSGAUDIO_SOUNDROOM_H
+#define OSGAUDIO_SOUNDROOM_H 1
+
+
+#include <osgAudio/Export.h>
+
+#include <osg/Group>
+#include <osg/CopyOp>
+#include <osg/BoundingBox>
+
+namespace osgAudio
+{
+
+    /// A node describing an acoustically closed volume (a room) in an indoor scene.
+    /**
+    SoundRoom nodes are the vertices of the sound propagation graph used by the
+    PortalOccludeCallback. Rooms are connected to each other through SoundPortal
+    nodes, which refer to rooms by name (osg::Object::getName()). The room volume is
+    an axis aligned box given in the local coordinate system of the node. If no
+    box is specified, the bounding box of the children is used instead.
+    */
+    class OSGAUDIO_EXPORT SoundRoom: public osg::Group {
+    public:
+        /// Default constructor
+        SoundRoom();
+
+        /// Copy constructor
+        SoundRoom(const SoundRoom &copy, const osg::CopyOp &copyop = osg::CopyOp::SHALLOW_COPY);
+
+        META_Node(osgAudio, SoundRoom);
+
+        /// Set the (local) volume of the room. An invalid box means "use the bounds of the children"
+        void setRoomBounds(const osg::BoundingBox& bb) { m_room_bounds = bb; }
+
+        /// Get the (local) volume of the room as specified with setRoomBounds()
+        const osg::BoundingBox& getRoomBounds() const { return m_room_bounds; }
+
+        /// Returns the (local) volume of the room actually used for propagation
+        osg::BoundingBox computeRoomBounds() const;
+
+    protected:
+        /// Destructor
+        virtual ~SoundRoom() {}
+
+        /// Assignment operator
+        SoundRoom &operator=(const SoundRoom &node);
+
+        osg::BoundingBox m_room_bounds;
+    };
+
+} // namespace osgAudio
+
+
+#endif //OSGAUDIO_SOUNDROOM_H
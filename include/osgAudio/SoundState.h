@@ -138,6 +138,9 @@ public:
         /// Set the stream that this state will play
         void setStream(osgAudio::Stream *stream) { m_sample = 0; m_stream = stream; set(Stream); if (m_source.valid()) apply(); }
 
+        /// Set either a Sample or a Stream, as returned by SoundManager::getSound()
+        void setSound(osg::Referenced *sound);
+
         /// Returns the sample, if used
         const osgAudio::Sample * getSample() const {
             if(hasSource())
@@ -255,6 +258,13 @@ public:
         /// Return if the soundstate is playing
         bool getPlay() { return m_play; }
 
+        /*! Decodes and queues the first buffers of the stream ahead of time, so that
+        a following setPlay(true) starts it without delay. Requires a stream and an allocated source.
+        \param timeout - The longest time to wait for the decoder, in seconds.
+        \return false if the stream couldn't be prerolled, it then starts with the usual delay.
+        */
+        bool preroll(float timeout=1.0f);
+
         void setOccludeDampingFactor(float d) { m_occlude_damping_factor = d; }
         float getOccludeDampingFactor() const { return m_occlude_damping_factor; }
 
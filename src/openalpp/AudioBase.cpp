@@ -30,6 +30,32 @@
 
 using namespace openalpp;
 
+#if OPENAL_VERSION >= 2007
+// ALC_SOFT_loopback, from alext.h of OpenAL Soft, which not all OpenAL
+// implementations install
+#ifndef ALC_SOFT_loopback
+#define ALC_SOFT_loopback 1
+#define ALC_FORMAT_CHANNELS_SOFT                 0x1990
+#define ALC_FORMAT_TYPE_SOFT                     0x1991
+#define ALC_SHORT_SOFT                           0x1402
+#define ALC_FLOAT_SOFT                           0x1406
+#define ALC_MONO_SOFT                            0x1500
+#define ALC_STEREO_SOFT                          0x1501
+#define ALC_QUAD_SOFT                            0x1503
+#define ALC_5POINT1_SOFT                         0x1504
+#define ALC_6POINT1_SOFT                         0x1505
+#define ALC_7POINT1_SOFT                         0x1506
+#ifndef ALC_APIENTRY
+#define ALC_APIENTRY
+#endif
+typedef ALCdevice* (ALC_APIENTRY*LPALCLOOPBACKOPENDEVICESOFT)(const ALCchar*);
+typedef ALCboolean (ALC_APIENTRY*LPALCISRENDERFORMATSUPPORTEDSOFT)(ALCdevice*,ALCsizei,ALCenum,ALCenum);
+typedef void (ALC_APIENTRY*LPALCRENDERSAMPLESSOFT)(ALCdevice*,ALCvoid*,ALCsizei);
+#endif
+
+static LPALCRENDERSAMPLESSOFT alcRenderSamples=NULL;
+#endif // OPENAL_VERSION >= 2007
+
 AudioBase::AudioBase(int frequency,int refresh,int synchronous, bool displayInitMsgs )
 throw (InitError)
 {
@@ -103,46 +129,135 @@ throw (InitError)
             attributes[i++]=synchronous;
             attributes[i]=0;
         }
-        context_=alcCreateContext(device_,attributes);
-        if(!context_ || alcGetError(device_)!=ALC_NO_ERROR) {
-            if(context_)
-                alcDestroyContext(context_);
+        createContext(attributes,displayInitMsgs);
+    }
+
+    instances_++;
+}
+
+AudioBase::AudioBase(const RenderFormat &format,bool displayInitMsgs) throw (InitError)
+{
+    if(!instances_) {
+#if OPENAL_VERSION >= 2007
+        if( displayInitMsgs )
+            std::cout << "Initializing OpenAL loopback rendering." << std::endl;
+
+        if(alcIsExtensionPresent(NULL,"ALC_SOFT_loopback")!=ALC_TRUE)
+            throw InitError("OpenAL++: Loopback rendering needs the ALC_SOFT_loopback extension.");
+        LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDevice=
+            (LPALCLOOPBACKOPENDEVICESOFT)alcGetProcAddress(NULL,"alcLoopbackOpenDeviceSOFT");
+        LPALCISRENDERFORMATSUPPORTEDSOFT alcIsRenderFormatSupported=
+            (LPALCISRENDERFORMATSUPPORTEDSOFT)alcGetProcAddress(NULL,"alcIsRenderFormatSupportedSOFT");
+        alcRenderSamples=(LPALCRENDERSAMPLESSOFT)alcGetProcAddress(NULL,"alcRenderSamplesSOFT");
+        if(!alcLoopbackOpenDevice || !alcIsRenderFormatSupported || !alcRenderSamples)
+            throw InitError("OpenAL++: Loopback rendering needs the ALC_SOFT_loopback extension.");
+
+        ALCenum channels;
+        switch(format.channels) {
+        case 1: channels=ALC_MONO_SOFT; break;
+        case 2: channels=ALC_STEREO_SOFT; break;
+        case 4: channels=ALC_QUAD_SOFT; break;
+        case 6: channels=ALC_5POINT1_SOFT; break;
+        case 7: channels=ALC_6POINT1_SOFT; break;
+        case 8: channels=ALC_7POINT1_SOFT; break;
+        default:
+            throw InitError("OpenAL++: Loopback rendering of 1, 2, 4, 6, 7 or 8 channels only.");
+        }
+        const ALCenum type=format.floating ? ALC_FLOAT_SOFT : ALC_SHORT_SOFT;
+
+        ALboolean success = alutInitWithoutContext (0L, 0L);
+        if (success != AL_TRUE) {
+            ALenum error = alutGetError ();
+            std::ostringstream str;
+            str << "Couldn't initialize ALUT: " << std::string(alutGetErrorString(error));
+            throw InitError(str.str().c_str());
+        }
+
+        device_=alcLoopbackOpenDevice(NULL);
+        if(!device_) {
+            alutExit();
+            throw InitError("OpenAL++: Couldn't open loopback device.");
+        }
+        if(!alcIsRenderFormatSupported(device_,(ALCsizei)format.frequency,channels,type)) {
             alcCloseDevice(device_);
-            throw InitError("Couldn't create context");
-        } 
-        alcMakeContextCurrent(context_);
-        reverbinitiated_=false;
+            device_=NULL;
+            alutExit();
+            throw InitError("OpenAL++: Render format not supported by the loopback device.");
+        }
+
+        const int attributes[7]={
+            ALC_FORMAT_CHANNELS_SOFT,channels,
+            ALC_FORMAT_TYPE_SOFT,type,
+            ALC_FREQUENCY,(int)format.frequency,
+            0 };
+        try {
+            createContext(attributes,displayInitMsgs);
+        } catch(InitError &) {
+            alutExit();
+            throw;
+        }
+
+        loopback_=true;
+        renderFormat_=format;
+#else // OPENAL_VERSION >= 2007
+        throw InitError("OpenAL++: Loopback rendering needs OpenAL 1.1.");
+#endif // OPENAL_VERSION >= 2007
+    }
+
+    instances_++;
+}
+
+void AudioBase::createContext(const int *attributes,bool displayInitMsgs) throw (InitError)
+{
+    context_=alcCreateContext(device_,const_cast<int *>(attributes));
+    if(!context_ || alcGetError(device_)!=ALC_NO_ERROR) {
+        if(context_)
+            alcDestroyContext(context_);
+        alcCloseDevice(device_);
+        device_=NULL;
+        throw InitError("Couldn't create context");
+    }
+    alcMakeContextCurrent(context_);
+    reverbinitiated_=false;
 
-        // Check for EAX 2.0 support
+    // Check for EAX 2.0 support
 #if OPENAL_VERSION < 2005
-        unsigned char szFnName[256];
-        ALboolean g_bEAX = alIsExtensionPresent((ALubyte*)"EAX2.0");
+    unsigned char szFnName[256];
+    ALboolean g_bEAX = alIsExtensionPresent((ALubyte*)"EAX2.0");
 #else // OPENAL_VERSION < 2005
-        char szFnName[256];
-        ALboolean g_bEAX = alIsExtensionPresent("EAX2.0");
+    char szFnName[256];
+    ALboolean g_bEAX = alIsExtensionPresent("EAX2.0");
 #endif // OPENAL_VERSION < 2005
+    if (g_bEAX == AL_TRUE)
+    {
+        sprintf((char*)szFnName, "EAXSet");
+        ALvoid *eaxSet = alGetProcAddress(szFnName);
+        if (eaxSet == NULL) g_bEAX = AL_FALSE;
+    }
+    if (g_bEAX == AL_TRUE)
+    {
+        sprintf((char*)szFnName,"EAXGet");
+        ALvoid *eaxGet = alGetProcAddress(szFnName);
+        if (eaxGet == NULL) g_bEAX = AL_FALSE;
+    }
+    if( displayInitMsgs )
+    {
         if (g_bEAX == AL_TRUE)
-        {
-            sprintf((char*)szFnName, "EAXSet");
-            ALvoid *eaxSet = alGetProcAddress(szFnName);
-            if (eaxSet == NULL) g_bEAX = AL_FALSE;
-        }
-        if (g_bEAX == AL_TRUE)
-        {
-            sprintf((char*)szFnName,"EAXGet");
-            ALvoid *eaxGet = alGetProcAddress(szFnName);
-            if (eaxGet == NULL) g_bEAX = AL_FALSE;
-        }
-        if( displayInitMsgs )
-        {
-            if (g_bEAX == AL_TRUE)
-                std::cerr << "Using OpenAL EAX2.0 extension" << std::endl;
-            else
-                std::cerr << "No OpenAL EAX2.0 extensions available" << std::endl;
-        }
+            std::cerr << "Using OpenAL EAX2.0 extension" << std::endl;
+        else
+            std::cerr << "No OpenAL EAX2.0 extensions available" << std::endl;
     }
+}
 
-    instances_++;
+void AudioBase::renderSamples(void *buffer,unsigned int frames) throw (FatalError)
+{
+#if OPENAL_VERSION >= 2007
+    if(loopback_ && alcRenderSamples) {
+        alcRenderSamples(device_,buffer,(ALCsizei)frames);
+        return;
+    }
+#endif
+    throw FatalError("AudioBase::renderSamples(): Not a loopback device");
 }
 
 AudioBase::~AudioBase() {
@@ -153,6 +268,8 @@ AudioBase::~AudioBase() {
         alcMakeContextCurrent(NULL);
         alcDestroyContext(context_);
         alcCloseDevice(device_);
+        device_=NULL;
+        loopback_=false;
     }
 }
 
@@ -181,6 +298,8 @@ const char *openalpp::alGetErrorString(ALenum error)
 // Static members
 int AudioBase::instances_=0;
 ALCdevice *AudioBase::device_=NULL;
+bool AudioBase::loopback_=false;
+RenderFormat AudioBase::renderFormat_;
 #ifndef WIN32
 #if OPENAL_VERSION < 2007
 void *AudioBase::context_=NULL;
@@ -23,9 +23,24 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <limits.h>
+#include <vector>
+
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+#include <OpenThreads/ScopedLock>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define OPENALPP_CONVERT_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OPENALPP_CONVERT_NEON
+#endif
 
 #include <openalpp/AudioConvert.h>
 
@@ -83,8 +98,11 @@ inline unsigned short Bits(ALenum format) {
     return 0;
 }
 
-AudioConvert::AudioConvert(ALenum format,unsigned int frequency)
-: frequency_(frequency), format_(format) {
+AudioConvert::AudioConvert(ALenum format,unsigned int frequency,Resampler::Quality quality)
+: frequency_(frequency), format_(format), quality_(quality),
+sourceFormat_(0), sourceFrequency_(0), sourceFrameSize_(0), resampling_(false),
+resampler_(Channels(format) ? Channels(format) : 1, 1.0, quality),
+toTarget_(NULL), fromResampler_(NULL) {
     bits_=Bits(format);
     channels_=Channels(format);
     if(!(bits_ && channels_))
@@ -102,80 +120,54 @@ void *AudioConvert::apply(void *data,ALenum format,
         return ret;
     }
 
-    ALvoid *compressed = NULL;
-    ALvoid *retval = NULL;
-    acAudioCVT s16le;
-
-    if(!IsRaw(format)) {    // Take care of compressed formats..
-        ALushort acfmt;
-        ALubyte achan;
-        ALushort acfreq;
-
-        switch(format) {
-      case AL_FORMAT_IMA_ADPCM_MONO16_EXT:
-      case AL_FORMAT_IMA_ADPCM_STEREO16_EXT:
-      case AL_FORMAT_WAVE_EXT:
-          acLoadWAV(data,&size,&retval,&acfmt,&achan,&acfreq);
-
-          format   = _al_AC2ALFMT(acfmt, achan);
-          frequency= acfreq;
-          break;
-      default:
-          break;
-        }
-
-        compressed = data = retval;
-    }
-
-    //unsigned int insize=size;  
-    //unsigned short inbits=Bits(format),inchannels=Channels(format);
+    if(IsRaw(format))
+        return convertAll(data,format,frequency,size);
 
-    if(acBuildAudioCVT(&s16le,
-        /* from */
-        _al_AL2ACFMT(format),
-        _al_ALCHANNELS(format),
-        frequency,
+    // Take care of compressed formats, decoded to 16 bits first
+    ALvoid *decoded = NULL;
+    ALushort acfmt;
+    ALubyte achan;
+    ALushort acfreq;
 
-        /* to */
-        _al_AL2ACFMT(format_),
-        _al_ALCHANNELS(format_),
-        frequency_) < 0) {
-            free(compressed);
-            throw FatalError("Couldn't build audio conversion data structure.");
-    }
+    switch(format) {
+    case AL_FORMAT_IMA_ADPCM_MONO16_EXT:
+    case AL_FORMAT_IMA_ADPCM_STEREO16_EXT:
+    case AL_FORMAT_WAVE_EXT:
+        acLoadWAV(data,&size,&decoded,&acfmt,&achan,&acfreq);
 
-    s16le.buf=retval=malloc(size * s16le.len_mult);
-    if(retval==NULL) {
-        free(compressed);
-        throw MemoryError("Out of memory");
+        format   = _al_AC2ALFMT(acfmt, achan);
+        frequency= acfreq;
+        break;
+    default:
+        break;
     }
-    memcpy(retval,data,size);
-
-    s16le.len =size;
 
-    if(acConvertAudio(&s16le)<0) {
-        free(compressed);
+    if(!decoded)
+        return NULL;
+    if(!IsRaw(format)) {
+        free(decoded);
         return NULL;
     }
 
-    size=s16le.len_cvt;
-
-    if(s16le.buf!=compressed)
-        free(compressed);
-
-    return s16le.buf;
+    void *converted;
+    try {
+        converted=convertAll(decoded,format,frequency,size);
+    } catch(...) {
+        free(decoded);
+        throw;
+    }
+    free(decoded);
+    return converted;
 }
 
-static struct MS_ADPCM_decoder_FULL {
+struct MS_ADPCM_decoder_FULL {
     alWaveFMT_LOKI wavefmt;
     ALushort wSamplesPerBlock;
     ALushort wNumCoef;
-    ALshort aCoeff[7][2];
-    struct MS_ADPCM_decodestate_FULL state[2];
-} MS_ADPCM_state_FULL;
+    ALint aCoeff[7][2];
+};
 
 ALboolean _al_RAWFORMAT(ALenum format) {
-    std::cerr << "_al_RAWFORMAT\n";
     switch(format) {
     case AL_FORMAT_MONO16:
     case AL_FORMAT_MONO8:
@@ -186,139 +178,40 @@ ALboolean _al_RAWFORMAT(ALenum format) {
     return AL_FALSE;
 }
 
-/* Convert rate up by multiple of 2 */
-void acFreqMUL2(acAudioCVT *cvt, ALushort format) {
-    std::cerr << "acFreqMUL2\n";
-
-    int i;
-    ALubyte *src, *dst;
-
-    src = (ALubyte *) cvt->buf + cvt->len_cvt;
-    dst = (ALubyte *) cvt->buf + cvt->len_cvt * 2;
-
-    switch(format & 0xFF) {
-    case 8:
-        for ( i=cvt->len_cvt; i; --i ) {
-            src -= 1;
-            dst -= 2;
-            dst[0] = src[0];
-            dst[1] = src[0];
-        }
-        break;
-    case 16:
-        for ( i=cvt->len_cvt/2; i; --i ) {
-            src -= 2;
-            dst -= 4;
-            dst[0] = src[0];
-            dst[1] = src[1];
-            dst[2] = src[0];
-            dst[3] = src[1];
-        }
-        break;
-    }
-    cvt->len_cvt *= 2;
-}
-
-/* Convert rate down by multiple of 2 */
-void acFreqDIV2(acAudioCVT *cvt, ALushort format) {
-    std::cerr << "acFreqDIV2\n";
-
-    int i;
-    ALubyte *src, *dst;
-
-    src = (ALubyte *)cvt->buf;
-    dst = (ALubyte *)cvt->buf;
-    switch(format & 0xFF) {
-    case 8:
-        for ( i=cvt->len_cvt/2; i; --i ) {
-            dst[0] = src[0];
-            src += 2;
-            dst += 1;
-        }
-        break;
-    case 16:
-        for ( i=cvt->len_cvt/4; i; --i ) {
-            dst[0] = src[0];
-            dst[1] = src[1];
-            src += 4;
-            dst += 2;
-        }
-        break;
-    }
+/*
+* Convert the rate with the windowed-sinc Resampler. This is the last filter,
+* so the data is in the target format already.
+*/
+void acFreqResample(acAudioCVT *cvt, ALushort) {
+    const int bytes = (cvt->dst_format & 0xFF) / 8;
+    const unsigned int channels = cvt->dst_channels;
+    const unsigned long frames = cvt->len_cvt / (bytes * channels);
+    const double ratio = (double)cvt->src_rate / cvt->dst_rate;
+
+    std::vector<short> out;
+    if(bytes == 2) {
+        Resampler::resample((const short *)cvt->buf, frames, channels, ratio, out,
+                            (Resampler::Quality)cvt->rate_quality);
+        if(!out.empty())
+            memcpy(cvt->buf, &out[0], out.size() * 2);
+    } else {
+        const ALubyte *src = (const ALubyte *)cvt->buf;
+        std::vector<short> in(frames * channels);
+        for(size_t i = 0; i < in.size(); i++)
+            in[i] = (short)((src[i] - 128) * 256);
 
-    cvt->len_cvt /= 2;
-}
+        Resampler::resample(in.empty() ? NULL : &in[0], frames, channels, ratio, out,
+                            (Resampler::Quality)cvt->rate_quality);
 
-/* Very slow rate conversion routine */
-void acFreqSLOW(acAudioCVT *cvt, ALushort format) {
-    std::cerr << "acFreqSLOW\n";
-
-    double ipos;
-    int i, clen;
-
-    clen = (int) ((double)cvt->len_cvt / cvt->rate_incr);
-    if(cvt->rate_incr > 1.0) {
-        switch(format & 0xFF) {
-      case 8: {
-          ALubyte *output;
-
-          output = (ALubyte *)cvt->buf;
-          ipos = 0.0;
-          for ( i=clen; i; --i ) {
-              *output = *((ALubyte *) cvt->buf + (int)ipos);
-              ipos += cvt->rate_incr;
-              output += 1;
-          }
-              } break;
-      case 16: {
-          ALushort *output;
-
-          clen &= ~1;
-          output = (ALushort *) cvt->buf;
-          ipos = 0.0;
-          for ( i=clen/2; i; --i ) {
-              *output=((ALushort *)cvt->buf)[(int)ipos];
-              ipos += cvt->rate_incr;
-              output += 1;
-          }
-               } break;
-        }
-    } else {
-        switch (format & 0xFF) {
-      case 8: {
-          ALubyte *output;
-
-          output = (ALubyte *) cvt->buf + clen;
-          ipos = (double)cvt->len_cvt;
-          for ( i=clen; i; --i ) {
-              ipos -= cvt->rate_incr;
-              output -= 1;
-              *output = *((ALubyte *) cvt->buf + (int)ipos);
-          }
-              } break;
-      case 16: {
-          ALushort *output;
-
-          clen &= ~1;
-          output = (ALushort *) cvt->buf;
-          output += clen / sizeof *output;
-
-          ipos = (double)cvt->len_cvt/2;
-          for ( i=clen/2; i; --i ) {
-              ipos -= cvt->rate_incr;
-              output -= 1;
-              *output=((ALushort *)cvt->buf)[(int)ipos];
-          }
-               } break;
-        }
+        ALubyte *dst = (ALubyte *)cvt->buf;
+        for(size_t i = 0; i < out.size(); i++)
+            dst[i] = (ALubyte)((out[i] >> 8) + 128);
     }
-    cvt->len_cvt = clen;
+    cvt->len_cvt = out.size() * bytes;
 }
 
 /* Duplicate a mono channel to both stereo channels */
 void acConvertStereo(acAudioCVT *cvt, ALushort format) {
-    std::cerr << "acConvertStereo\n";
-
     int i;
 
     if((format & 0xFF) == 16) {
@@ -353,8 +246,6 @@ void acConvertStereo(acAudioCVT *cvt, ALushort format) {
 
 /* Effectively mix right and left channels into a single channel */
 void acConvertMono(acAudioCVT *cvt, ALushort format) {
-    std::cerr << "acConvertMono\n";
-
     int i;
     ALint sample;
 
@@ -493,8 +384,6 @@ void acConvertMono(acAudioCVT *cvt, ALushort format) {
 
 /* Toggle signed/unsigned */
 void acConvertSign(acAudioCVT *cvt, ALushort format) {
-    std::cerr << "acConvertSign\n";
-
     int i;
     ALubyte *data;
 
@@ -518,8 +407,6 @@ void acConvertSign(acAudioCVT *cvt, ALushort format) {
 
 /* Toggle endianness */
 void acConvertEndian(acAudioCVT *cvt, ALushort format) {
-    std::cerr << "acConvertEndian\n";
-
     int i;
     ALubyte *data, tmp;
 
@@ -536,8 +423,6 @@ void acConvertEndian(acAudioCVT *cvt, ALushort format) {
 
 /* Convert 8-bit to 16-bit - LSB */
 void acConvert16LSB( acAudioCVT *cvt, ALushort format ) {
-    std::cerr << "acConvert16LSB\n";
-
     int i;
     ALubyte *src, *dst;
 
@@ -558,8 +443,6 @@ void acConvert16LSB( acAudioCVT *cvt, ALushort format ) {
 
 /* Convert 8-bit to 16-bit - MSB */
 void acConvert16MSB(acAudioCVT *cvt, ALushort format) {
-    std::cerr << "acConvertMSB\n";
-
     int i;
     ALubyte *src, *dst;
 
@@ -578,8 +461,6 @@ void acConvert16MSB(acAudioCVT *cvt, ALushort format) {
 
 /* Convert 16-bit to 8-bit */
 void acConvert8(acAudioCVT *cvt, ALushort format) {
-    std::cerr << "acConvert8\n";
-
     int i;
     ALubyte *src, *dst;
 
@@ -599,13 +480,410 @@ void acConvert8(acAudioCVT *cvt, ALushort format) {
     cvt->len_cvt /= 2;
 }
 
+/*
+* Fused conversion between the formats OpenAL buffers use: unsigned 8 bit and
+* native 16 bit, mono and stereo. Sign, size and channel conversion are done
+* in one pass, in place, with a SIMD kernel for the common cases.
+*/
+
+namespace {
+
+    typedef void (*acFilter)(acAudioCVT *cvt, ALushort format);
+
+    struct FormatU8 {
+        typedef ALubyte Type;
+        static inline int toS16(ALubyte value) { return (value - 128) * 256; }
+        static inline ALubyte fromS16(int value) { return (ALubyte)((value >> 8) + 128); }
+    };
+
+    struct FormatS16 {
+        typedef ALshort Type;
+        static inline int toS16(ALshort value) { return value; }
+        static inline ALshort fromS16(int value) { return (ALshort)value; }
+    };
+
+    /*
+    * SIMD conversion of Block frames at a time. Block is 0 for the cases
+    * without a kernel.
+    */
+    template<class From, class To, int InChannels, int OutChannels>
+    struct FormatKernel {
+        enum { Block = 0 };
+        static inline void run(const typename From::Type *, typename To::Type *) {}
+    };
+
+#if defined(OPENALPP_CONVERT_SSE2)
+    template<> struct FormatKernel<FormatS16, FormatS16, 1, 2> {
+        enum { Block = 8 };
+        static inline void run(const ALshort *src, ALshort *dst) {
+            __m128i v = _mm_loadu_si128((const __m128i *)src);
+            _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(v, v));
+            _mm_storeu_si128((__m128i *)(dst + 8), _mm_unpackhi_epi16(v, v));
+        }
+    };
+
+    template<> struct FormatKernel<FormatS16, FormatS16, 2, 1> {
+        enum { Block = 8 };
+        static inline void run(const ALshort *src, ALshort *dst) {
+            const __m128i ones = _mm_set1_epi16(1);
+            __m128i lo = _mm_srai_epi32(_mm_madd_epi16(_mm_loadu_si128((const __m128i *)src), ones), 1);
+            __m128i hi = _mm_srai_epi32(_mm_madd_epi16(_mm_loadu_si128((const __m128i *)(src + 8)), ones), 1);
+            _mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(lo, hi));
+        }
+    };
+
+    template<> struct FormatKernel<FormatU8, FormatS16, 1, 1> {
+        enum { Block = 16 };
+        static inline void run(const ALubyte *src, ALshort *dst) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)src), _mm_set1_epi8((char)0x80));
+            const __m128i zero = _mm_setzero_si128();
+            _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi8(zero, v));
+            _mm_storeu_si128((__m128i *)(dst + 8), _mm_unpackhi_epi8(zero, v));
+        }
+    };
+
+    template<> struct FormatKernel<FormatS16, FormatU8, 1, 1> {
+        enum { Block = 16 };
+        static inline void run(const ALshort *src, ALubyte *dst) {
+            __m128i lo = _mm_srai_epi16(_mm_loadu_si128((const __m128i *)src), 8);
+            __m128i hi = _mm_srai_epi16(_mm_loadu_si128((const __m128i *)(src + 8)), 8);
+            __m128i v = _mm_xor_si128(_mm_packs_epi16(lo, hi), _mm_set1_epi8((char)0x80));
+            _mm_storeu_si128((__m128i *)dst, v);
+        }
+    };
+#elif defined(OPENALPP_CONVERT_NEON)
+    template<> struct FormatKernel<FormatS16, FormatS16, 1, 2> {
+        enum { Block = 8 };
+        static inline void run(const ALshort *src, ALshort *dst) {
+            int16x8_t v = vld1q_s16(src);
+            int16x8x2_t z = vzipq_s16(v, v);
+            vst1q_s16(dst, z.val[0]);
+            vst1q_s16(dst + 8, z.val[1]);
+        }
+    };
+
+    template<> struct FormatKernel<FormatS16, FormatS16, 2, 1> {
+        enum { Block = 8 };
+        static inline void run(const ALshort *src, ALshort *dst) {
+            int16x8x2_t v = vld2q_s16(src);
+            vst1q_s16(dst, vhaddq_s16(v.val[0], v.val[1]));
+        }
+    };
+
+    template<> struct FormatKernel<FormatU8, FormatS16, 1, 1> {
+        enum { Block = 16 };
+        static inline void run(const ALubyte *src, ALshort *dst) {
+            int8x16_t v = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(src), vdupq_n_u8(0x80)));
+            vst1q_s16(dst, vshll_n_s8(vget_low_s8(v), 8));
+            vst1q_s16(dst + 8, vshll_n_s8(vget_high_s8(v), 8));
+        }
+    };
+
+    template<> struct FormatKernel<FormatS16, FormatU8, 1, 1> {
+        enum { Block = 16 };
+        static inline void run(const ALshort *src, ALubyte *dst) {
+            int8x16_t v = vcombine_s8(vshrn_n_s16(vld1q_s16(src), 8), vshrn_n_s16(vld1q_s16(src + 8), 8));
+            vst1q_u8(dst, veorq_u8(vreinterpretq_u8_s8(v), vdupq_n_u8(0x80)));
+        }
+    };
+#endif
+
+    /*
+    * Converts frames in place. Growing conversions go from the end of the
+    * buffer, shrinking ones from the start, so that no input is overwritten
+    * before it is read.
+    */
+    template<class From, class To, int InChannels, int OutChannels>
+    struct FormatConverter {
+        typedef typename From::Type InType;
+        typedef typename To::Type OutType;
+        typedef FormatKernel<From, To, InChannels, OutChannels> Kernel;
+
+        static inline void frame(const InType *src, OutType *dst) {
+            const int left = From::toS16(src[0]);
+            const int right = InChannels == 2 ? From::toS16(src[InChannels - 1]) : left;
+            if(OutChannels == 1) {
+                dst[0] = To::fromS16((left + right) >> 1);
+            } else {
+                dst[0] = To::fromS16(left);
+                dst[OutChannels - 1] = To::fromS16(right);
+            }
+        }
+
+        static void run(const InType *src, OutType *dst, size_t frames) {
+            const size_t blocks = Kernel::Block > 0 ? frames / Kernel::Block : 0;
+            const size_t head = blocks * Kernel::Block;
+
+            if(sizeof(OutType) * OutChannels > sizeof(InType) * InChannels) {
+                for(size_t i = frames; i > head; ) {
+                    --i;
+                    frame(src + i * InChannels, dst + i * OutChannels);
+                }
+                for(size_t b = blocks; b; ) {
+                    --b;
+                    Kernel::run(src + b * Kernel::Block * InChannels, dst + b * Kernel::Block * OutChannels);
+                }
+            } else {
+                for(size_t b = 0; b < blocks; b++)
+                    Kernel::run(src + b * Kernel::Block * InChannels, dst + b * Kernel::Block * OutChannels);
+                for(size_t i = head; i < frames; i++)
+                    frame(src + i * InChannels, dst + i * OutChannels);
+            }
+        }
+    };
+
+    typedef void (*acFrameConverter)(const void *src, void *dst, size_t frames);
+
+    /*
+    * Conversion of one format pair, as a filter and between two buffers.
+    * Size conversions keep the channels, and run on the samples as if they
+    * were mono, to use the mono kernels.
+    */
+    template<class From, class To, int InChannels, int OutChannels>
+    struct FormatPair {
+        static void convert(const void *src, void *dst, size_t frames) {
+            if(InChannels == OutChannels)
+                FormatConverter<From, To, 1, 1>::run((const typename From::Type *)src,
+                    (typename To::Type *)dst, frames * InChannels);
+            else
+                FormatConverter<From, To, InChannels, OutChannels>::run((const typename From::Type *)src,
+                    (typename To::Type *)dst, frames);
+        }
+
+        static void filter(acAudioCVT *cvt, ALushort) {
+            const size_t frames = cvt->len_cvt / (sizeof(typename From::Type) * InChannels);
+            convert(cvt->buf, cvt->buf, frames);
+            cvt->len_cvt = frames * sizeof(typename To::Type) * OutChannels;
+        }
+    };
+
+    struct FormatFunctions {
+        acFilter filter;
+        acFrameConverter convert;
+    };
+
+    template<class Pair>
+    FormatFunctions formatFunctions() {
+        FormatFunctions functions = { Pair::filter, Pair::convert };
+        return functions;
+    }
+
+    template<class From, class To>
+    FormatFunctions selectChannels(ALubyte src_channels, ALubyte dst_channels) {
+        if(src_channels == 1 && dst_channels == 1)
+            return formatFunctions<FormatPair<From, To, 1, 1> >();
+        if(src_channels == 1 && dst_channels == 2)
+            return formatFunctions<FormatPair<From, To, 1, 2> >();
+        if(src_channels == 2 && dst_channels == 1)
+            return formatFunctions<FormatPair<From, To, 2, 1> >();
+        if(src_channels == 2 && dst_channels == 2)
+            return formatFunctions<FormatPair<From, To, 2, 2> >();
+        FormatFunctions none = { NULL, NULL };
+        return none;
+    }
+
+    /*
+    * The fused conversion between two formats, or NULLs if it isn't between
+    * AUDIO_U8 and AUDIO_S16 mono or stereo.
+    */
+    FormatFunctions selectFormat(ALushort src_format, ALubyte src_channels,
+                                 ALushort dst_format, ALubyte dst_channels) {
+        if(src_format == AUDIO_U8 && dst_format == AUDIO_U8)
+            return selectChannels<FormatU8, FormatU8>(src_channels, dst_channels);
+        if(src_format == AUDIO_U8 && dst_format == AUDIO_S16)
+            return selectChannels<FormatU8, FormatS16>(src_channels, dst_channels);
+        if(src_format == AUDIO_S16 && dst_format == AUDIO_U8)
+            return selectChannels<FormatS16, FormatU8>(src_channels, dst_channels);
+        if(src_format == AUDIO_S16 && dst_format == AUDIO_S16)
+            return selectChannels<FormatS16, FormatS16>(src_channels, dst_channels);
+        FormatFunctions none = { NULL, NULL };
+        return none;
+    }
+
+}
+
+/*
+* Chunked conversion. Input goes through the fused format converter into the
+* target channels, and through the Resampler if the rates differ, one chunk
+* at a time, so memory use doesn't depend on the size of the stream.
+*/
+
+/* Frames converted at a time */
+static const unsigned long STREAM_CHUNK = 4096;
+
+void AudioConvert::setSource(ALenum format,unsigned int frequency) {
+    if(!IsRaw(format))
+        throw FatalError("AudioConvert: Only 8 and 16 bit mono and stereo can be converted chunk by chunk");
+
+    const ALubyte srcChannels = (ALubyte)Channels(format);
+    const ALubyte dstChannels = (ALubyte)channels_;
+    resampling_ = frequency != frequency_;
+
+    // Straight to the target format, or to 16 bits for the resampler
+    const ALushort dstFormat = resampling_ ? AUDIO_S16 : _al_AL2ACFMT(format_);
+    toTarget_ = selectFormat(_al_AL2ACFMT(format), srcChannels, dstFormat, dstChannels).convert;
+    fromResampler_ = selectFormat(AUDIO_S16, dstChannels, _al_AL2ACFMT(format_), dstChannels).convert;
+    if(!toTarget_ || !fromResampler_)
+        throw FatalError("AudioConvert: Unsupported conversion");
+
+    sourceFormat_ = format;
+    sourceFrequency_ = frequency;
+    sourceFrameSize_ = Channels(format) * Bits(format) / 8;
+    if(resampling_)
+        resampler_.setRatio((double)frequency / frequency_);
+    reset();
+}
+
+void AudioConvert::reset() {
+    pending_.clear();
+    resampler_.reset();
+}
+
+unsigned int AudioConvert::getMaxOutput(unsigned int size) const {
+    const unsigned int frameSize = channels_ * bits_ / 8;
+    const unsigned long frames = sourceFrameSize_ ? (pending_.size() + size) / sourceFrameSize_ : 0;
+    if(!resampling_)
+        return frames * frameSize;
+    return resampler_.getMaxOutput(frames) * frameSize;
+}
+
+unsigned int AudioConvert::drain(char *out,unsigned int outsize) {
+    const unsigned int frameSize = channels_ * bits_ / 8;
+    unsigned int written = 0;
+    for(;;) {
+        unsigned long room = (outsize - written) / frameSize;
+        if(room > STREAM_CHUNK)
+            room = STREAM_CHUNK;
+        if(!room)
+            break;
+
+        resampled_.resize(STREAM_CHUNK * channels_);
+        unsigned long frames = resampler_.process(NULL, 0, &resampled_[0], room);
+        if(!frames)
+            break;
+        fromResampler_(&resampled_[0], out + written, frames);
+        written += frames * frameSize;
+    }
+    return written;
+}
+
+unsigned int AudioConvert::convertFrames(const char *in,unsigned long frames,char *out,unsigned int outsize) {
+    const unsigned int frameSize = channels_ * bits_ / 8;
+    if(!resampling_) {
+        toTarget_(in, out, frames);
+        return frames * frameSize;
+    }
+
+    // The resampler keeps the input it can't deliver yet
+    scratch_.resize(frames * channels_);
+    toTarget_(in, &scratch_[0], frames);
+
+    unsigned long room = outsize / frameSize;
+    if(room > STREAM_CHUNK)
+        room = STREAM_CHUNK;
+    resampled_.resize(STREAM_CHUNK * channels_);
+    unsigned long done = resampler_.process(&scratch_[0], frames, &resampled_[0], room);
+    fromResampler_(&resampled_[0], out, done);
+    return done * frameSize + drain(out + done * frameSize, outsize - done * frameSize);
+}
+
+unsigned int AudioConvert::convert(const void *data,unsigned int size,
+                                   void *out,unsigned int outsize,unsigned int *consumed) {
+    if(!toTarget_)
+        throw FatalError("AudioConvert: setSource() must be called before convert()");
+
+    const char *in = (const char *)data;
+    char *dst = (char *)out;
+    const unsigned int frameSize = channels_ * bits_ / 8;
+    unsigned int used = 0, written = 0;
+
+    // Output the resampler held back last time first
+    if(resampling_)
+        written += drain(dst, outsize);
+
+    while(used < size) {
+        // Only input that there is room for is consumed. The resampler
+        // holds back at most a chunk.
+        unsigned long room = (outsize - written) / frameSize;
+        if(!room)
+            break;
+        if(resampling_)
+            room = STREAM_CHUNK;
+
+        // Complete a frame split between calls
+        if(!pending_.empty()) {
+            unsigned int n = sourceFrameSize_ - pending_.size();
+            if(n > size - used)
+                n = size - used;
+            pending_.insert(pending_.end(), in + used, in + used + n);
+            used += n;
+            if(pending_.size() < sourceFrameSize_)
+                break;
+            written += convertFrames(&pending_[0], 1, dst + written, outsize - written);
+            pending_.clear();
+            continue;
+        }
+
+        unsigned long frames = (size - used) / sourceFrameSize_;
+        if(!frames) {
+            pending_.assign(in + used, in + size);
+            used = size;
+            break;
+        }
+        if(frames > room)
+            frames = room;
+        if(frames > STREAM_CHUNK)
+            frames = STREAM_CHUNK;
+
+        written += convertFrames(in + used, frames, dst + written, outsize - written);
+        used += frames * sourceFrameSize_;
+    }
+
+    if(consumed)
+        *consumed = used;
+    return written;
+}
+
+unsigned int AudioConvert::flush(void *out,unsigned int outsize) {
+    unsigned int written = 0;
+    if(resampling_) {
+        const unsigned int frameSize = channels_ * bits_ / 8;
+        written = drain((char *)out, outsize);
+
+        resampled_.resize((resampler_.getMaxOutput(0) + STREAM_CHUNK) * channels_);
+        unsigned long room = (outsize - written) / frameSize;
+        if(room > resampled_.size() / channels_)
+            room = resampled_.size() / channels_;
+        unsigned long frames = resampler_.flush(&resampled_[0], room);
+        fromResampler_(&resampled_[0], (char *)out + written, frames);
+        written += frames * frameSize;
+    }
+    reset();
+    return written;
+}
+
+void *AudioConvert::convertAll(const void *data,ALenum format,unsigned int frequency,unsigned int &size) {
+    // A stream of its own, so that a stream of this converter isn't disturbed
+    AudioConvert stream(format_,frequency_,quality_);
+    stream.setSource(format,frequency);
+
+    // Room for the output and for what the resampler flushes at the end
+    const unsigned int frameSize = channels_ * bits_ / 8;
+    const unsigned int outsize = stream.getMaxOutput(size) + STREAM_CHUNK * frameSize;
+    char *out = (char *)malloc(outsize);
+    if(!out)
+        throw MemoryError("Out of memory");
+
+    unsigned int written = stream.convert(data,size,out,outsize);
+    written += stream.flush(out + written,outsize - written);
+    size = written;
+    return out;
+}
+
 int acBuildAudioCVT(acAudioCVT *cvt,
                     ALushort src_format, ALubyte src_channels, ALuint src_rate,
                     ALushort dst_format, ALubyte dst_channels, ALuint dst_rate)
 {
-
-    std::cerr << "acBuildAudioCVT\n";
-
     /* Start off with no conversion necessary */
     cvt->needed       = 0;
     cvt->filter_index = 0;
@@ -613,6 +891,21 @@ int acBuildAudioCVT(acAudioCVT *cvt,
     cvt->len_mult     = 1;
     cvt->len_ratio    = 1.0;
 
+    /* The common formats are converted in a single pass */
+    if(src_format != dst_format || src_channels != dst_channels) {
+        acFilter fused = selectFormat(src_format, src_channels, dst_format, dst_channels).filter;
+        if(fused) {
+            const int src_size = (src_format & 0xFF) / 8 * src_channels;
+            const int dst_size = (dst_format & 0xFF) / 8 * dst_channels;
+            cvt->filters[cvt->filter_index++] = fused;
+            if(dst_size > src_size)
+                cvt->len_mult *= (dst_size + src_size - 1) / src_size;
+            cvt->len_ratio *= (double)dst_size / src_size;
+            src_format = dst_format;
+            src_channels = dst_channels;
+        }
+    }
+
     /* First filter:  Endian conversion from src to dst */
     if((( src_format & 0x1000) != (dst_format & 0x1000)) &&
         (( src_format & 0xff) != 8))
@@ -674,53 +967,17 @@ int acBuildAudioCVT(acAudioCVT *cvt,
     }
 
     /* Do rate conversion */
-    cvt->rate_incr = 0.0;
-    if((src_rate / 100) != (dst_rate / 100)) {
-        ALuint hi_rate, lo_rate;
-        int len_mult;
-        double len_ratio;
-        void (*rate_cvt)(acAudioCVT *, ALushort );
-
-        if ( src_rate > dst_rate ) {
-            hi_rate   = src_rate;
-            lo_rate   = dst_rate;
-            rate_cvt  = acFreqDIV2;
-            len_mult  = 1;
-            len_ratio = 0.5;
-        } else {
-            hi_rate   = dst_rate;
-            lo_rate   = src_rate;
-            rate_cvt  = acFreqMUL2;
-            len_mult  = 2;
-            len_ratio = 2.0;
-        }
-        /* If hi_rate = lo_rate*2^x then conversion is easy */
-        while(((lo_rate * 2)/100) <= (hi_rate/100)) {
-            cvt->filters[cvt->filter_index++] = rate_cvt;
-            lo_rate        *= 2;
-            cvt->len_mult  *= len_mult;
-            cvt->len_ratio *= len_ratio;
-        }
-
-        /* We may need a slow conversion here to finish up */
-        if((lo_rate/100) != (hi_rate/100)) {
-            /* The problem with this is that if the input buffer is
-            say 1K, and the conversion rate is say 1.1, then the
-            output buffer is 1.1K, which may not be an acceptable
-            buffer size for the audio driver (not a power of 2)
-            */
-            /* For now, punt and hope the rate distortion isn't great.
-            */
-            if ( src_rate < dst_rate ) {
-                cvt->rate_incr = (double)lo_rate/hi_rate;
-                cvt->len_mult *= 2;
-                cvt->len_ratio /= cvt->rate_incr;
-            } else {
-                cvt->rate_incr = (double)hi_rate/lo_rate;
-                cvt->len_ratio *= cvt->rate_incr;
-            }
-            cvt->filters[cvt->filter_index++] = acFreqSLOW;
-        }
+    cvt->rate_incr    = 0.0;
+    cvt->src_rate     = src_rate;
+    cvt->dst_rate     = dst_rate;
+    cvt->dst_channels = dst_channels;
+    cvt->rate_quality = Resampler::Medium;
+    if(src_rate != dst_rate && src_rate && dst_rate) {
+        cvt->rate_incr = (double)src_rate / dst_rate;
+        cvt->len_ratio /= cvt->rate_incr;
+        if(dst_rate > src_rate)
+            cvt->len_mult *= (dst_rate + src_rate - 1) / src_rate + 1;
+        cvt->filters[cvt->filter_index++] = acFreqResample;
     }
 
     /* Set up the filter information */
@@ -743,8 +1000,6 @@ int acBuildAudioCVT(acAudioCVT *cvt,
 * with the number of channels specified by channels.
 */
 ALenum _al_AC2ALFMT( ALuint acformat, ALuint channels ) {
-    std::cerr << "_al_AC2ALFMT\n";
-
     switch( acformat ) {
     case AUDIO_U8:
         if(channels == 2)
@@ -771,8 +1026,6 @@ ALenum _al_AC2ALFMT( ALuint acformat, ALuint channels ) {
 * combined with _al_ALCHANNELS.
 */
 ALushort _al_AL2ACFMT( ALenum alformat ) {
-    std::cerr << "_al_AL2ACFMT\n";
-
     switch( alformat ) {
     case AL_FORMAT_STEREO8:
     case AL_FORMAT_MONO8:
@@ -787,8 +1040,6 @@ ALushort _al_AL2ACFMT( ALenum alformat ) {
 }
 
 int acConvertAudio(acAudioCVT *cvt) {
-    std::cerr << "acConvertAudio\n";
-
     int i;
 
     /* Make sure there's data to convert */
@@ -818,312 +1069,561 @@ ALuint swap32(ALuint D) {
     return (D<<24) | ((D<<8)&0x00FF0000) | ((D>>8)&0x0000FF00) | (D>>24);
 }
 
-static ALint IMA_ADPCM_nibble(alIMAADPCM_decodestate_LOKI *state,
-                              ALubyte nybble)
-{
-    const ALint max_audioval = ((1<<(16-1))-1);
-    const ALint min_audioval = -(1<<(16-1));
-    const int index_table[16] = {
-        -1, -1, -1, -1,
-        2,  4,  6,  8,
-        -1, -1, -1, -1,
-        2,  4,  6,  8
+/*
+* ADPCM decoding. Every block starts with the complete decoder state in its
+* header, so blocks are decoded independently, by several threads for long
+* files. The nibble kernels are table driven.
+*/
+
+namespace {
+
+    /*
+    * IMA ADPCM difference and next step index, for each step index and nibble.
+    * Generated from the step table of the IMA ADPCM specification and the
+    * index changes { -1, -1, -1, -1, 2, 4, 6, 8 }: the difference is
+    * (step>>3) + (step if bit 2) + (step>>1 if bit 1) + (step>>2 if bit 0),
+    * negative if bit 3, and the next index is clamped to 0..88. Literal
+    * tables, so that they are initialized before any thread decodes.
+    */
+    const ALint IMA_ADPCM_diff[89][16] = {
+        { 0, 1, 3, 4, 7, 8, 10, 11, 0, -1, -3, -4, -7, -8, -10, -11 },
+        { 1, 3, 5, 7, 9, 11, 13, 15, -1, -3, -5, -7, -9, -11, -13, -15 },
+        { 1, 3, 5, 7, 10, 12, 14, 16, -1, -3, -5, -7, -10, -12, -14, -16 },
+        { 1, 3, 6, 8, 11, 13, 16, 18, -1, -3, -6, -8, -11, -13, -16, -18 },
+        { 1, 3, 6, 8, 12, 14, 17, 19, -1, -3, -6, -8, -12, -14, -17, -19 },
+        { 1, 4, 7, 10, 13, 16, 19, 22, -1, -4, -7, -10, -13, -16, -19, -22 },
+        { 1, 4, 7, 10, 14, 17, 20, 23, -1, -4, -7, -10, -14, -17, -20, -23 },
+        { 1, 4, 8, 11, 15, 18, 22, 25, -1, -4, -8, -11, -15, -18, -22, -25 },
+        { 2, 6, 10, 14, 18, 22, 26, 30, -2, -6, -10, -14, -18, -22, -26, -30 },
+        { 2, 6, 10, 14, 19, 23, 27, 31, -2, -6, -10, -14, -19, -23, -27, -31 },
+        { 2, 6, 11, 15, 21, 25, 30, 34, -2, -6, -11, -15, -21, -25, -30, -34 },
+        { 2, 7, 12, 17, 23, 28, 33, 38, -2, -7, -12, -17, -23, -28, -33, -38 },
+        { 2, 7, 13, 18, 25, 30, 36, 41, -2, -7, -13, -18, -25, -30, -36, -41 },
+        { 3, 9, 15, 21, 28, 34, 40, 46, -3, -9, -15, -21, -28, -34, -40, -46 },
+        { 3, 10, 17, 24, 31, 38, 45, 52, -3, -10, -17, -24, -31, -38, -45, -52 },
+        { 3, 10, 18, 25, 34, 41, 49, 56, -3, -10, -18, -25, -34, -41, -49, -56 },
+        { 4, 12, 21, 29, 38, 46, 55, 63, -4, -12, -21, -29, -38, -46, -55, -63 },
+        { 4, 13, 22, 31, 41, 50, 59, 68, -4, -13, -22, -31, -41, -50, -59, -68 },
+        { 5, 15, 25, 35, 46, 56, 66, 76, -5, -15, -25, -35, -46, -56, -66, -76 },
+        { 5, 16, 27, 38, 50, 61, 72, 83, -5, -16, -27, -38, -50, -61, -72, -83 },
+        { 6, 18, 31, 43, 56, 68, 81, 93, -6, -18, -31, -43, -56, -68, -81, -93 },
+        { 6, 19, 33, 46, 61, 74, 88, 101, -6, -19, -33, -46, -61, -74, -88, -101 },
+        { 7, 22, 37, 52, 67, 82, 97, 112, -7, -22, -37, -52, -67, -82, -97, -112 },
+        { 8, 24, 41, 57, 74, 90, 107, 123, -8, -24, -41, -57, -74, -90, -107, -123 },
+        { 9, 27, 45, 63, 82, 100, 118, 136, -9, -27, -45, -63, -82, -100, -118, -136 },
+        { 10, 30, 50, 70, 90, 110, 130, 150, -10, -30, -50, -70, -90, -110, -130, -150 },
+        { 11, 33, 55, 77, 99, 121, 143, 165, -11, -33, -55, -77, -99, -121, -143, -165 },
+        { 12, 36, 60, 84, 109, 133, 157, 181, -12, -36, -60, -84, -109, -133, -157, -181 },
+        { 13, 39, 66, 92, 120, 146, 173, 199, -13, -39, -66, -92, -120, -146, -173, -199 },
+        { 14, 43, 73, 102, 132, 161, 191, 220, -14, -43, -73, -102, -132, -161, -191, -220 },
+        { 16, 48, 81, 113, 146, 178, 211, 243, -16, -48, -81, -113, -146, -178, -211, -243 },
+        { 17, 52, 88, 123, 160, 195, 231, 266, -17, -52, -88, -123, -160, -195, -231, -266 },
+        { 19, 58, 97, 136, 176, 215, 254, 293, -19, -58, -97, -136, -176, -215, -254, -293 },
+        { 21, 64, 107, 150, 194, 237, 280, 323, -21, -64, -107, -150, -194, -237, -280, -323 },
+        { 23, 70, 118, 165, 213, 260, 308, 355, -23, -70, -118, -165, -213, -260, -308, -355 },
+        { 26, 78, 130, 182, 235, 287, 339, 391, -26, -78, -130, -182, -235, -287, -339, -391 },
+        { 28, 85, 143, 200, 258, 315, 373, 430, -28, -85, -143, -200, -258, -315, -373, -430 },
+        { 31, 94, 157, 220, 284, 347, 410, 473, -31, -94, -157, -220, -284, -347, -410, -473 },
+        { 34, 103, 173, 242, 313, 382, 452, 521, -34, -103, -173, -242, -313, -382, -452, -521 },
+        { 38, 114, 191, 267, 345, 421, 498, 574, -38, -114, -191, -267, -345, -421, -498, -574 },
+        { 42, 126, 210, 294, 379, 463, 547, 631, -42, -126, -210, -294, -379, -463, -547, -631 },
+        { 46, 138, 231, 323, 417, 509, 602, 694, -46, -138, -231, -323, -417, -509, -602, -694 },
+        { 51, 153, 255, 357, 459, 561, 663, 765, -51, -153, -255, -357, -459, -561, -663, -765 },
+        { 56, 168, 280, 392, 505, 617, 729, 841, -56, -168, -280, -392, -505, -617, -729, -841 },
+        { 61, 184, 308, 431, 555, 678, 802, 925, -61, -184, -308, -431, -555, -678, -802, -925 },
+        { 68, 204, 340, 476, 612, 748, 884, 1020, -68, -204, -340, -476, -612, -748, -884, -1020 },
+        { 74, 223, 373, 522, 672, 821, 971, 1120, -74, -223, -373, -522, -672, -821, -971, -1120 },
+        { 82, 246, 411, 575, 740, 904, 1069, 1233, -82, -246, -411, -575, -740, -904, -1069, -1233 },
+        { 90, 271, 452, 633, 814, 995, 1176, 1357, -90, -271, -452, -633, -814, -995, -1176, -1357 },
+        { 99, 298, 497, 696, 895, 1094, 1293, 1492, -99, -298, -497, -696, -895, -1094, -1293, -1492 },
+        { 109, 328, 547, 766, 985, 1204, 1423, 1642, -109, -328, -547, -766, -985, -1204, -1423, -1642 },
+        { 120, 360, 601, 841, 1083, 1323, 1564, 1804, -120, -360, -601, -841, -1083, -1323, -1564, -1804 },
+        { 132, 397, 662, 927, 1192, 1457, 1722, 1987, -132, -397, -662, -927, -1192, -1457, -1722, -1987 },
+        { 145, 436, 728, 1019, 1311, 1602, 1894, 2185, -145, -436, -728, -1019, -1311, -1602, -1894, -2185 },
+        { 160, 480, 801, 1121, 1442, 1762, 2083, 2403, -160, -480, -801, -1121, -1442, -1762, -2083, -2403 },
+        { 176, 528, 881, 1233, 1587, 1939, 2292, 2644, -176, -528, -881, -1233, -1587, -1939, -2292, -2644 },
+        { 194, 582, 970, 1358, 1746, 2134, 2522, 2910, -194, -582, -970, -1358, -1746, -2134, -2522, -2910 },
+        { 213, 639, 1066, 1492, 1920, 2346, 2773, 3199, -213, -639, -1066, -1492, -1920, -2346, -2773, -3199 },
+        { 234, 703, 1173, 1642, 2112, 2581, 3051, 3520, -234, -703, -1173, -1642, -2112, -2581, -3051, -3520 },
+        { 258, 774, 1291, 1807, 2324, 2840, 3357, 3873, -258, -774, -1291, -1807, -2324, -2840, -3357, -3873 },
+        { 284, 852, 1420, 1988, 2556, 3124, 3692, 4260, -284, -852, -1420, -1988, -2556, -3124, -3692, -4260 },
+        { 312, 936, 1561, 2185, 2811, 3435, 4060, 4684, -312, -936, -1561, -2185, -2811, -3435, -4060, -4684 },
+        { 343, 1030, 1717, 2404, 3092, 3779, 4466, 5153, -343, -1030, -1717, -2404, -3092, -3779, -4466, -5153 },
+        { 378, 1134, 1890, 2646, 3402, 4158, 4914, 5670, -378, -1134, -1890, -2646, -3402, -4158, -4914, -5670 },
+        { 415, 1246, 2078, 2909, 3742, 4573, 5405, 6236, -415, -1246, -2078, -2909, -3742, -4573, -5405, -6236 },
+        { 457, 1372, 2287, 3202, 4117, 5032, 5947, 6862, -457, -1372, -2287, -3202, -4117, -5032, -5947, -6862 },
+        { 503, 1509, 2516, 3522, 4529, 5535, 6542, 7548, -503, -1509, -2516, -3522, -4529, -5535, -6542, -7548 },
+        { 553, 1660, 2767, 3874, 4981, 6088, 7195, 8302, -553, -1660, -2767, -3874, -4981, -6088, -7195, -8302 },
+        { 608, 1825, 3043, 4260, 5479, 6696, 7914, 9131, -608, -1825, -3043, -4260, -5479, -6696, -7914, -9131 },
+        { 669, 2008, 3348, 4687, 6027, 7366, 8706, 10045, -669, -2008, -3348, -4687, -6027, -7366, -8706, -10045 },
+        { 736, 2209, 3683, 5156, 6630, 8103, 9577, 11050, -736, -2209, -3683, -5156, -6630, -8103, -9577, -11050 },
+        { 810, 2431, 4052, 5673, 7294, 8915, 10536, 12157, -810, -2431, -4052, -5673, -7294, -8915, -10536, -12157 },
+        { 891, 2674, 4457, 6240, 8023, 9806, 11589, 13372, -891, -2674, -4457, -6240, -8023, -9806, -11589, -13372 },
+        { 980, 2941, 4902, 6863, 8825, 10786, 12747, 14708, -980, -2941, -4902, -6863, -8825, -10786, -12747, -14708 },
+        { 1078, 3235, 5393, 7550, 9708, 11865, 14023, 16180, -1078, -3235, -5393, -7550, -9708, -11865, -14023, -16180 },
+        { 1186, 3559, 5932, 8305, 10679, 13052, 15425, 17798, -1186, -3559, -5932, -8305, -10679, -13052, -15425, -17798 },
+        { 1305, 3915, 6526, 9136, 11747, 14357, 16968, 19578, -1305, -3915, -6526, -9136, -11747, -14357, -16968, -19578 },
+        { 1435, 4306, 7178, 10049, 12922, 15793, 18665, 21536, -1435, -4306, -7178, -10049, -12922, -15793, -18665, -21536 },
+        { 1579, 4737, 7896, 11054, 14214, 17372, 20531, 23689, -1579, -4737, -7896, -11054, -14214, -17372, -20531, -23689 },
+        { 1737, 5211, 8686, 12160, 15636, 19110, 22585, 26059, -1737, -5211, -8686, -12160, -15636, -19110, -22585, -26059 },
+        { 1911, 5733, 9555, 13377, 17200, 21022, 24844, 28666, -1911, -5733, -9555, -13377, -17200, -21022, -24844, -28666 },
+        { 2102, 6306, 10511, 14715, 18920, 23124, 27329, 31533, -2102, -6306, -10511, -14715, -18920, -23124, -27329, -31533 },
+        { 2312, 6937, 11562, 16187, 20812, 25437, 30062, 34687, -2312, -6937, -11562, -16187, -20812, -25437, -30062, -34687 },
+        { 2543, 7630, 12718, 17805, 22893, 27980, 33068, 38155, -2543, -7630, -12718, -17805, -22893, -27980, -33068, -38155 },
+        { 2798, 8394, 13990, 19586, 25183, 30779, 36375, 41971, -2798, -8394, -13990, -19586, -25183, -30779, -36375, -41971 },
+        { 3077, 9232, 15388, 21543, 27700, 33855, 40011, 46166, -3077, -9232, -15388, -21543, -27700, -33855, -40011, -46166 },
+        { 3385, 10156, 16928, 23699, 30471, 37242, 44014, 50785, -3385, -10156, -16928, -23699, -30471, -37242, -44014, -50785 },
+        { 3724, 11172, 18621, 26069, 33518, 40966, 48415, 55863, -3724, -11172, -18621, -26069, -33518, -40966, -48415, -55863 },
+        { 4095, 12286, 20478, 28669, 36862, 45053, 53245, 61436, -4095, -12286, -20478, -28669, -36862, -45053, -53245, -61436 }
     };
-    const ALint step_table[89] = {
-        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
-        34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130,
-        143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408,
-        449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282,
-        1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
-        3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630,
-        9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
-        22385, 24623, 27086, 29794, 32767
+
+    const ALubyte IMA_ADPCM_next[89][16] = {
+        { 0, 0, 0, 0, 2, 4, 6, 8, 0, 0, 0, 0, 2, 4, 6, 8 },
+        { 0, 0, 0, 0, 3, 5, 7, 9, 0, 0, 0, 0, 3, 5, 7, 9 },
+        { 1, 1, 1, 1, 4, 6, 8, 10, 1, 1, 1, 1, 4, 6, 8, 10 },
+        { 2, 2, 2, 2, 5, 7, 9, 11, 2, 2, 2, 2, 5, 7, 9, 11 },
+        { 3, 3, 3, 3, 6, 8, 10, 12, 3, 3, 3, 3, 6, 8, 10, 12 },
+        { 4, 4, 4, 4, 7, 9, 11, 13, 4, 4, 4, 4, 7, 9, 11, 13 },
+        { 5, 5, 5, 5, 8, 10, 12, 14, 5, 5, 5, 5, 8, 10, 12, 14 },
+        { 6, 6, 6, 6, 9, 11, 13, 15, 6, 6, 6, 6, 9, 11, 13, 15 },
+        { 7, 7, 7, 7, 10, 12, 14, 16, 7, 7, 7, 7, 10, 12, 14, 16 },
+        { 8, 8, 8, 8, 11, 13, 15, 17, 8, 8, 8, 8, 11, 13, 15, 17 },
+        { 9, 9, 9, 9, 12, 14, 16, 18, 9, 9, 9, 9, 12, 14, 16, 18 },
+        { 10, 10, 10, 10, 13, 15, 17, 19, 10, 10, 10, 10, 13, 15, 17, 19 },
+        { 11, 11, 11, 11, 14, 16, 18, 20, 11, 11, 11, 11, 14, 16, 18, 20 },
+        { 12, 12, 12, 12, 15, 17, 19, 21, 12, 12, 12, 12, 15, 17, 19, 21 },
+        { 13, 13, 13, 13, 16, 18, 20, 22, 13, 13, 13, 13, 16, 18, 20, 22 },
+        { 14, 14, 14, 14, 17, 19, 21, 23, 14, 14, 14, 14, 17, 19, 21, 23 },
+        { 15, 15, 15, 15, 18, 20, 22, 24, 15, 15, 15, 15, 18, 20, 22, 24 },
+        { 16, 16, 16, 16, 19, 21, 23, 25, 16, 16, 16, 16, 19, 21, 23, 25 },
+        { 17, 17, 17, 17, 20, 22, 24, 26, 17, 17, 17, 17, 20, 22, 24, 26 },
+        { 18, 18, 18, 18, 21, 23, 25, 27, 18, 18, 18, 18, 21, 23, 25, 27 },
+        { 19, 19, 19, 19, 22, 24, 26, 28, 19, 19, 19, 19, 22, 24, 26, 28 },
+        { 20, 20, 20, 20, 23, 25, 27, 29, 20, 20, 20, 20, 23, 25, 27, 29 },
+        { 21, 21, 21, 21, 24, 26, 28, 30, 21, 21, 21, 21, 24, 26, 28, 30 },
+        { 22, 22, 22, 22, 25, 27, 29, 31, 22, 22, 22, 22, 25, 27, 29, 31 },
+        { 23, 23, 23, 23, 26, 28, 30, 32, 23, 23, 23, 23, 26, 28, 30, 32 },
+        { 24, 24, 24, 24, 27, 29, 31, 33, 24, 24, 24, 24, 27, 29, 31, 33 },
+        { 25, 25, 25, 25, 28, 30, 32, 34, 25, 25, 25, 25, 28, 30, 32, 34 },
+        { 26, 26, 26, 26, 29, 31, 33, 35, 26, 26, 26, 26, 29, 31, 33, 35 },
+        { 27, 27, 27, 27, 30, 32, 34, 36, 27, 27, 27, 27, 30, 32, 34, 36 },
+        { 28, 28, 28, 28, 31, 33, 35, 37, 28, 28, 28, 28, 31, 33, 35, 37 },
+        { 29, 29, 29, 29, 32, 34, 36, 38, 29, 29, 29, 29, 32, 34, 36, 38 },
+        { 30, 30, 30, 30, 33, 35, 37, 39, 30, 30, 30, 30, 33, 35, 37, 39 },
+        { 31, 31, 31, 31, 34, 36, 38, 40, 31, 31, 31, 31, 34, 36, 38, 40 },
+        { 32, 32, 32, 32, 35, 37, 39, 41, 32, 32, 32, 32, 35, 37, 39, 41 },
+        { 33, 33, 33, 33, 36, 38, 40, 42, 33, 33, 33, 33, 36, 38, 40, 42 },
+        { 34, 34, 34, 34, 37, 39, 41, 43, 34, 34, 34, 34, 37, 39, 41, 43 },
+        { 35, 35, 35, 35, 38, 40, 42, 44, 35, 35, 35, 35, 38, 40, 42, 44 },
+        { 36, 36, 36, 36, 39, 41, 43, 45, 36, 36, 36, 36, 39, 41, 43, 45 },
+        { 37, 37, 37, 37, 40, 42, 44, 46, 37, 37, 37, 37, 40, 42, 44, 46 },
+        { 38, 38, 38, 38, 41, 43, 45, 47, 38, 38, 38, 38, 41, 43, 45, 47 },
+        { 39, 39, 39, 39, 42, 44, 46, 48, 39, 39, 39, 39, 42, 44, 46, 48 },
+        { 40, 40, 40, 40, 43, 45, 47, 49, 40, 40, 40, 40, 43, 45, 47, 49 },
+        { 41, 41, 41, 41, 44, 46, 48, 50, 41, 41, 41, 41, 44, 46, 48, 50 },
+        { 42, 42, 42, 42, 45, 47, 49, 51, 42, 42, 42, 42, 45, 47, 49, 51 },
+        { 43, 43, 43, 43, 46, 48, 50, 52, 43, 43, 43, 43, 46, 48, 50, 52 },
+        { 44, 44, 44, 44, 47, 49, 51, 53, 44, 44, 44, 44, 47, 49, 51, 53 },
+        { 45, 45, 45, 45, 48, 50, 52, 54, 45, 45, 45, 45, 48, 50, 52, 54 },
+        { 46, 46, 46, 46, 49, 51, 53, 55, 46, 46, 46, 46, 49, 51, 53, 55 },
+        { 47, 47, 47, 47, 50, 52, 54, 56, 47, 47, 47, 47, 50, 52, 54, 56 },
+        { 48, 48, 48, 48, 51, 53, 55, 57, 48, 48, 48, 48, 51, 53, 55, 57 },
+        { 49, 49, 49, 49, 52, 54, 56, 58, 49, 49, 49, 49, 52, 54, 56, 58 },
+        { 50, 50, 50, 50, 53, 55, 57, 59, 50, 50, 50, 50, 53, 55, 57, 59 },
+        { 51, 51, 51, 51, 54, 56, 58, 60, 51, 51, 51, 51, 54, 56, 58, 60 },
+        { 52, 52, 52, 52, 55, 57, 59, 61, 52, 52, 52, 52, 55, 57, 59, 61 },
+        { 53, 53, 53, 53, 56, 58, 60, 62, 53, 53, 53, 53, 56, 58, 60, 62 },
+        { 54, 54, 54, 54, 57, 59, 61, 63, 54, 54, 54, 54, 57, 59, 61, 63 },
+        { 55, 55, 55, 55, 58, 60, 62, 64, 55, 55, 55, 55, 58, 60, 62, 64 },
+        { 56, 56, 56, 56, 59, 61, 63, 65, 56, 56, 56, 56, 59, 61, 63, 65 },
+        { 57, 57, 57, 57, 60, 62, 64, 66, 57, 57, 57, 57, 60, 62, 64, 66 },
+        { 58, 58, 58, 58, 61, 63, 65, 67, 58, 58, 58, 58, 61, 63, 65, 67 },
+        { 59, 59, 59, 59, 62, 64, 66, 68, 59, 59, 59, 59, 62, 64, 66, 68 },
+        { 60, 60, 60, 60, 63, 65, 67, 69, 60, 60, 60, 60, 63, 65, 67, 69 },
+        { 61, 61, 61, 61, 64, 66, 68, 70, 61, 61, 61, 61, 64, 66, 68, 70 },
+        { 62, 62, 62, 62, 65, 67, 69, 71, 62, 62, 62, 62, 65, 67, 69, 71 },
+        { 63, 63, 63, 63, 66, 68, 70, 72, 63, 63, 63, 63, 66, 68, 70, 72 },
+        { 64, 64, 64, 64, 67, 69, 71, 73, 64, 64, 64, 64, 67, 69, 71, 73 },
+        { 65, 65, 65, 65, 68, 70, 72, 74, 65, 65, 65, 65, 68, 70, 72, 74 },
+        { 66, 66, 66, 66, 69, 71, 73, 75, 66, 66, 66, 66, 69, 71, 73, 75 },
+        { 67, 67, 67, 67, 70, 72, 74, 76, 67, 67, 67, 67, 70, 72, 74, 76 },
+        { 68, 68, 68, 68, 71, 73, 75, 77, 68, 68, 68, 68, 71, 73, 75, 77 },
+        { 69, 69, 69, 69, 72, 74, 76, 78, 69, 69, 69, 69, 72, 74, 76, 78 },
+        { 70, 70, 70, 70, 73, 75, 77, 79, 70, 70, 70, 70, 73, 75, 77, 79 },
+        { 71, 71, 71, 71, 74, 76, 78, 80, 71, 71, 71, 71, 74, 76, 78, 80 },
+        { 72, 72, 72, 72, 75, 77, 79, 81, 72, 72, 72, 72, 75, 77, 79, 81 },
+        { 73, 73, 73, 73, 76, 78, 80, 82, 73, 73, 73, 73, 76, 78, 80, 82 },
+        { 74, 74, 74, 74, 77, 79, 81, 83, 74, 74, 74, 74, 77, 79, 81, 83 },
+        { 75, 75, 75, 75, 78, 80, 82, 84, 75, 75, 75, 75, 78, 80, 82, 84 },
+        { 76, 76, 76, 76, 79, 81, 83, 85, 76, 76, 76, 76, 79, 81, 83, 85 },
+        { 77, 77, 77, 77, 80, 82, 84, 86, 77, 77, 77, 77, 80, 82, 84, 86 },
+        { 78, 78, 78, 78, 81, 83, 85, 87, 78, 78, 78, 78, 81, 83, 85, 87 },
+        { 79, 79, 79, 79, 82, 84, 86, 88, 79, 79, 79, 79, 82, 84, 86, 88 },
+        { 80, 80, 80, 80, 83, 85, 87, 88, 80, 80, 80, 80, 83, 85, 87, 88 },
+        { 81, 81, 81, 81, 84, 86, 88, 88, 81, 81, 81, 81, 84, 86, 88, 88 },
+        { 82, 82, 82, 82, 85, 87, 88, 88, 82, 82, 82, 82, 85, 87, 88, 88 },
+        { 83, 83, 83, 83, 86, 88, 88, 88, 83, 83, 83, 83, 86, 88, 88, 88 },
+        { 84, 84, 84, 84, 87, 88, 88, 88, 84, 84, 84, 84, 87, 88, 88, 88 },
+        { 85, 85, 85, 85, 88, 88, 88, 88, 85, 85, 85, 85, 88, 88, 88, 88 },
+        { 86, 86, 86, 86, 88, 88, 88, 88, 86, 86, 86, 86, 88, 88, 88, 88 },
+        { 87, 87, 87, 87, 88, 88, 88, 88, 87, 87, 87, 87, 88, 88, 88, 88 }
     };
-    ALint delta, step;
-
-    /* Compute difference and new sample value */
-    step = step_table[(int) state->index];
-    delta = step >> 3;
-    if ( nybble & 0x04 ) delta += step;
-    if ( nybble & 0x02 ) delta += (step >> 1);
-    if ( nybble & 0x01 ) delta += (step >> 2);
-    if ( nybble & 0x08 ) delta = -delta;
-    state->valprev += delta;
-
-    /* Update index value */
-    state->index += index_table[nybble];
-    if ( state->index > 88 ) {
-        state->index = 88;
-    } else
-        if ( state->index < 0 ) {
-            state->index = 0;
-        }
 
-        /* Clamp output sample */
-        if ( state->valprev > max_audioval ) {
-            state->valprev = max_audioval;
-        } else
-            if ( state->valprev < min_audioval ) {
-                state->valprev = min_audioval;
-            }
-            return(state->valprev);
-}
+    const ALint MS_ADPCM_adaptive[16] = {
+        230, 230, 230, 230, 307, 409, 512, 614,
+        768, 614, 512, 409, 307, 230, 230, 230
+    };
 
-/* Fill the decode buffer with a channel block of data (8 samples) */
-static void Fill_IMA_ADPCM_block(ALubyte *decoded, ALubyte *encoded,
-                                 int channel, int numchannels,
-                                 alIMAADPCM_decodestate_LOKI *state)
-{
-    int i;
-    ALbyte  nybble;
-    ALint new_sample;
-
-    decoded += (channel * 2);
-    for ( i=0; i<4; ++i ) {
-        nybble = (*encoded)&0x0F;
-        new_sample = IMA_ADPCM_nibble(state, nybble);
-        decoded[0] = new_sample&0xFF;
-        new_sample >>= 8;
-        decoded[1] = new_sample&0xFF;
-        decoded += 2 * numchannels;
-
-        nybble = (*encoded)>>4;
-        new_sample = IMA_ADPCM_nibble(state, nybble);
-        decoded[0] = new_sample&0xFF;
-        new_sample >>= 8;
-        decoded[1] = new_sample&0xFF;
-        decoded += 2 * numchannels;
-
-        ++encoded;
-    }
-}
+    /* MS ADPCM nibbles are signed */
+    const ALint MS_ADPCM_signed[16] = {
+        0, 1, 2, 3, 4, 5, 6, 7, -8, -7, -6, -5, -4, -3, -2, -1
+    };
 
-int IMA_ADPCM_decode(ALubyte *indata, ALubyte *outdata,
-                     ALuint len, alIMAADPCM_state_LOKI *istate, int offset)
-{
-    alIMAADPCM_decodestate_LOKI *state;
-    int indata_len;
-    int c, channels = istate->wavefmt.channels;
-    int samplesleft;
+    inline ALint clamp16(ALint sample) {
+        return sample < MS_ADPCM_min ? MS_ADPCM_min :
+            sample > MS_ADPCM_max ? MS_ADPCM_max : sample;
+    }
 
-    indata += offset;
-    state = istate->state;
+    inline ALint readLE16(const ALubyte *p) {
+        return (ALshort)((p[1]<<8)|p[0]);
+    }
 
-    if(len < istate->wavefmt.blockalign)
-        return -1;
+    /**
+    * Decode one IMA ADPCM block of istate->wSamplesPerBlock sample frames.
+    * @return false if the block is corrupt.
+    */
+    bool IMA_ADPCM_decode_block(const ALubyte *encoded, ALshort *decoded, const void *decoder) {
+        const alIMAADPCM_state_LOKI *istate = (const alIMAADPCM_state_LOKI *)decoder;
+        const int channels = istate->wavefmt.channels;
+        const int samples = istate->wSamplesPerBlock;
+        ALint valprev[2];
+        int index[2];
 
-    indata_len = len;
-    /* Get ready... Go! */
-    while ( indata_len >= istate->wavefmt.blockalign ) {
         /* Grab the initial information for this block */
-        for ( c=0; c<channels; ++c ) {
-            /* Fill the state information for this block */
-            state[c].valprev = ((indata[1]<<8)|indata[0]);
-            indata += 2;
-            if ( state[c].valprev & 0x8000 )
-                state[c].valprev -= 0x10000;
-            state[c].index = *indata++;
+        for ( int c=0; c<channels; ++c ) {
+            valprev[c] = readLE16(encoded);
+            index[c] = encoded[2];
             /* Reserved byte in buffer header, should be 0 */
-            if ( *indata++ != 0 ) {
-                /* Uh oh, corrupt data?  Buggy code? */
-                std::ostringstream str;
-                str << __FILE__ << ": " << __LINE__ << ": " << "Reserved byte in buffer should be 0" << std::ends;
-                throw FatalError(str.str().c_str());
+            if ( encoded[3] != 0 || index[c] > 88 )
+                return false;
+            decoded[c] = (ALshort)valprev[c];
+            encoded += 4;
+        }
+
+        /* Each channel has 4 bytes, 8 samples, in turn */
+        for ( int s=1; s<samples; s+=8 ) {
+            for ( int c=0; c<channels; ++c ) {
+                ALint value = valprev[c];
+                int idx = index[c];
+                ALshort *out = decoded + s*channels + c;
+                for ( int i=0; i<4; ++i ) {
+                    const ALubyte byte = *encoded++;
+
+                    value = clamp16(value + IMA_ADPCM_diff[idx][byte & 0x0F]);
+                    idx = IMA_ADPCM_next[idx][byte & 0x0F];
+                    *out = (ALshort)value;
+                    out += channels;
+
+                    value = clamp16(value + IMA_ADPCM_diff[idx][byte >> 4]);
+                    idx = IMA_ADPCM_next[idx][byte >> 4];
+                    *out = (ALshort)value;
+                    out += channels;
+                }
+                valprev[c] = value;
+                index[c] = idx;
             }
+        }
 
-            /* Store the initial valprev we start with */
-            outdata[0] = state[c].valprev&0xFF;
-            outdata[1] = state[c].valprev>>8;
-            outdata += 2;
+        return true;
+    }
+
+    /**
+    * Decode one MS ADPCM block of decoder->wSamplesPerBlock sample frames.
+    * @return false if the block is corrupt.
+    */
+    bool MS_ADPCM_decode_block(const ALubyte *encoded, ALshort *decoded, const void *decoder) {
+        const MS_ADPCM_decoder_FULL *mstate = (const MS_ADPCM_decoder_FULL *)decoder;
+        const int channels = mstate->wavefmt.channels;
+        const ALint *coeff[2];
+        ALint delta[2], samp1[2], samp2[2];
+
+        /* Grab the initial information for this block */
+        for ( int c=0; c<channels; ++c ) {
+            if ( encoded[c] >= mstate->wNumCoef )
+                return false;
+            coeff[c] = mstate->aCoeff[encoded[c]];
         }
+        encoded += channels;
+        for ( int c=0; c<channels; ++c, encoded+=2 )
+            delta[c] = (ALushort)readLE16(encoded);
+        for ( int c=0; c<channels; ++c, encoded+=2 )
+            samp1[c] = readLE16(encoded);
+        for ( int c=0; c<channels; ++c, encoded+=2 )
+            samp2[c] = readLE16(encoded);
 
-        /* Decode and store the other samples in this block */
-        samplesleft = (istate->wSamplesPerBlock-1)*channels;
-        while ( samplesleft > 0 ) {
-            for ( c=0; c<channels; ++c ) {
-                Fill_IMA_ADPCM_block(outdata, indata,
-                    c, channels, &state[c]);
-                indata += 4;
-                samplesleft -= 8;
-            }
-            outdata += (channels * 8 * 2);
+        /* Store the two initial samples we start with */
+        for ( int c=0; c<channels; ++c ) {
+            decoded[c] = (ALshort)samp2[c];
+            decoded[channels+c] = (ALshort)samp1[c];
         }
-        indata_len -= istate->wavefmt.blockalign;
+        decoded += 2*channels;
+
+        /* Decode the other samples, high nibble first, alternating channels */
+        const int nybbles = (mstate->wSamplesPerBlock-2)*channels;
+        for ( int n=0; n<nybbles; ++n ) {
+            const int c = channels == 2 ? (n & 1) : 0;
+            const int nybble = (n & 1) ? (encoded[n>>1] & 0x0F) : (encoded[n>>1] >> 4);
+
+            ALint sample = (samp1[c]*coeff[c][0] + samp2[c]*coeff[c][1])/256;
+            sample = clamp16(sample + delta[c]*MS_ADPCM_signed[nybble]);
+            *decoded++ = (ALshort)sample;
+
+            delta[c] = (delta[c]*MS_ADPCM_adaptive[nybble])/256;
+            if ( delta[c] < 16 )
+                delta[c] = 16;
+            samp2[c] = samp1[c];
+            samp1[c] = sample;
+        }
+
+        return true;
     }
 
-    return 0;
-}
+    typedef bool (*ADPCM_block_decoder)(const ALubyte *encoded, ALshort *decoded, const void *decoder);
 
+    /**
+    * A range of blocks of an ADPCM file.
+    */
+    struct ADPCM_range {
+        ADPCM_block_decoder decode;
+        const void *decoder;
+        const ALubyte *encoded;
+        ALshort *decoded;
+        unsigned int blocks;
+        unsigned int blockalign;        /* Encoded bytes per block */
+        unsigned int blocksamples;      /* Decoded samples per block, all channels */
+
+        bool run() const {
+            for(unsigned int b = 0; b < blocks; b++)
+                if(!decode(encoded + b*blockalign, decoded + b*blocksamples, decoder))
+                    return false;
+            return true;
+        }
+    };
 
-int IMA_ADPCM_decode_FULL(alIMAADPCM_state_LOKI *istate,
-                          ALubyte **audio_buf, ALuint *audio_len)
-{
-    std::cerr << "IMA_ADPCM_decode_FULL\n";
-    ALubyte *freeable, *encoded;
-    ALint encoded_len;
-    unsigned int channels;
+    /**
+    * Ranges of blocks of one file, decoded by the pool threads and the thread
+    * that files them.
+    */
+    struct ADPCM_batch {
+        const ADPCM_range *ranges;
+        unsigned int count;
+        unsigned int next;              /* First range no thread has taken */
+        unsigned int running;           /* Ranges taken but not decoded yet */
+        bool ok;
+    };
 
+    /**
+    * Threads decoding ADPCM files, started with the first file large enough
+    * to be split, and kept for the following ones.
+    */
+    class ADPCMDecodePool {
+    public:
+        static ADPCMDecodePool *instance() {
+            static ADPCMDecodePool s_pool;
+            return &s_pool;
+        }
 
+        /**
+        * @return the threads decoding a file, the calling one included.
+        */
+        unsigned int getNumThreads() const { return (unsigned int)workers_.size()+1; }
 
-    /* Check to make sure we have enough variables in the state array */
-    channels = istate->wavefmt.channels;
-    if ( channels > NELEMS(istate->state) )
-        return(-1);
+        /**
+        * Decode the ranges, on the pool threads and the calling thread.
+        * Returns when all of them are decoded, also when the pool threads are
+        * busy with other files or couldn't be started.
+        * @return false if a block is corrupt.
+        */
+        bool decode(const ADPCM_range *ranges,unsigned int count) {
+            ADPCM_batch batch = { ranges, count, 0, 0, true };
+
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+            batches_.push_back(&batch);
+            condition_.broadcast();
+
+            while(batch.next < batch.count)
+                runNext(&batch);
+            while(batch.running)
+                condition_.wait(&mutex_);
+            return batch.ok;
+        }
 
-    /* Allocate the proper sized output buffer */
-    encoded_len = *audio_len;
-    encoded = *audio_buf;
-    freeable = *audio_buf;
-    *audio_len = (encoded_len/istate->wavefmt.blockalign) * 
-        istate->wSamplesPerBlock*
-        istate->wavefmt.channels*sizeof(ALshort);
-
-    *audio_buf = (ALubyte *)malloc(*audio_len);
-    if ( *audio_buf == NULL )
-        return(-1);
+    protected:
+        class Worker : public OpenThreads::Thread {
+        public:
+            Worker(ADPCMDecodePool *pool) : pool_(pool) {}
 
-    return IMA_ADPCM_decode(encoded, *audio_buf,
-        encoded_len, istate, 0);
-}
+        protected:
+            void run() { pool_->work(); }
 
-static ALint MS_ADPCM_nibble_FULL(struct MS_ADPCM_decodestate_FULL *state,
-                                  ALubyte nybble, ALshort *coeff)
-{
-    const ALint adaptive[] = {
-        230, 230, 230, 230, 307, 409, 512, 614,
-        768, 614, 512, 409, 307, 230, 230, 230
+            ADPCMDecodePool *pool_;
+        };
+
+        ADPCMDecodePool() : done_(false) {
+            const int processors = OpenThreads::GetNumberOfProcessors();
+            for(int i = 1; i < processors; i++) {
+                Worker *worker = new Worker(this);
+                if(worker->start()) {
+                    delete worker;
+                    break;
+                }
+                workers_.push_back(worker);
+            }
+        }
+
+        ~ADPCMDecodePool() {
+            mutex_.lock();
+            done_ = true;
+            condition_.broadcast();
+            mutex_.unlock();
+
+            for(unsigned int i = 0; i < workers_.size(); i++) {
+                workers_[i]->join();
+                delete workers_[i];
+            }
+        }
+
+        void work() {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+            while(!done_) {
+                if(batches_.empty())
+                    condition_.wait(&mutex_);
+                else
+                    runNext(batches_.front());
+            }
+        }
+
+        /* Decode the next range of a batch, called with mutex_ locked */
+        void runNext(ADPCM_batch *batch) {
+            const ADPCM_range &range = batch->ranges[batch->next++];
+            if(batch->next == batch->count)
+                batches_.erase(std::find(batches_.begin(),batches_.end(),batch));
+            batch->running++;
+
+            mutex_.unlock();
+            const bool ok = range.run();
+            mutex_.lock();
+
+            batch->ok = batch->ok && ok;
+            if(--batch->running == 0 && batch->next == batch->count)
+                condition_.broadcast();
+        }
+
+        std::vector<Worker *> workers_;
+        std::vector<ADPCM_batch *> batches_;
+        OpenThreads::Mutex mutex_;
+        OpenThreads::Condition condition_;
+        bool done_;
     };
-    ALint new_sample, delta;
 
-    new_sample = ((state->iSamp1 * coeff[0]) +
-        (state->iSamp2 * coeff[1]))/256;
+    /* Fewer blocks are decoded faster than they're handed to another thread */
+    const unsigned int ADPCM_min_blocks_per_thread = 256;
 
-    if(nybble & 0x08) {
-        new_sample += state->iDelta * (nybble-0x10);
-    } else {
-        new_sample += state->iDelta * nybble;
+    /**
+    * Decode all blocks of an ADPCM file, in parallel on all processors.
+    * @return false if a block is corrupt.
+    */
+    bool ADPCM_decode(const ADPCM_range &all) {
+        if(all.blocks < 2*ADPCM_min_blocks_per_thread)
+            return all.run();
+
+        unsigned int threads = ADPCMDecodePool::instance()->getNumThreads();
+        if(threads > all.blocks/ADPCM_min_blocks_per_thread)
+            threads = all.blocks/ADPCM_min_blocks_per_thread;
+        if(threads < 2)
+            return all.run();
+
+        std::vector<ADPCM_range> ranges(threads,all);
+        const unsigned int per_thread = all.blocks/threads;
+        for(unsigned int t = 0; t < threads; t++) {
+            ranges[t].encoded += t*per_thread*all.blockalign;
+            ranges[t].decoded += t*per_thread*all.blocksamples;
+            ranges[t].blocks = t+1 < threads ? per_thread : all.blocks - t*per_thread;
+        }
+        return ADPCMDecodePool::instance()->decode(&ranges[0],threads);
     }
 
-    if(new_sample < MS_ADPCM_min) {
-        new_sample = MS_ADPCM_min;
-    } else if(new_sample > MS_ADPCM_max) {
-        new_sample = MS_ADPCM_max;
-    }
+}
 
-    delta = ((ALint) state->iDelta * adaptive[nybble]);
-    if(delta < 4096) {
-        delta = 16;
-    } else {
-        delta /= 256;
-    }
+int IMA_ADPCM_decode_FULL(alIMAADPCM_state_LOKI *istate,
+                          ALubyte **audio_buf, ALuint *audio_len)
+{
+    /* Check to make sure we have enough variables in the state array */
+    const unsigned int channels = istate->wavefmt.channels;
+    const unsigned int blockalign = istate->wavefmt.blockalign;
+    const unsigned int samples = istate->wSamplesPerBlock;
+    if ( channels < 1 || channels > NELEMS(istate->state) || samples < 1 || (samples-1)%8 ||
+        blockalign < channels*(4 + (samples-1)/2) )
+        return(-1);
 
-    state->iDelta = delta;
-    state->iSamp2 = state->iSamp1;
-    state->iSamp1 = new_sample;
+    /* Allocate the proper sized output buffer */
+    ADPCM_range all;
+    all.decode = IMA_ADPCM_decode_block;
+    all.decoder = istate;
+    all.encoded = *audio_buf;
+    all.blocks = *audio_len/blockalign;
+    all.blockalign = blockalign;
+    all.blocksamples = samples*channels;
+
+    *audio_len = all.blocks*all.blocksamples*sizeof(ALshort);
+    *audio_buf = (ALubyte *)malloc(*audio_len ? *audio_len : 1);
+    if ( *audio_buf == NULL )
+        return(-1);
+    all.decoded = (ALshort *)*audio_buf;
 
-    return new_sample;
+    if ( !ADPCM_decode(all) ) {
+        free(*audio_buf);
+        *audio_buf = NULL;
+        return(-1);
+    }
+    return 0;
 }
 
-static int MS_ADPCM_decode_FULL(ALubyte **audio_buf, ALuint *audio_len) {
-    std::cerr << "MS_ADPCM_decode_FULL\n";
-    struct MS_ADPCM_decodestate_FULL *state[2];
-    ALubyte *freeable, *encoded, *decoded;
-    ALint encoded_len, samplesleft;
-    ALbyte nybble, stereo;
-    ALshort *coeff[2];
-    ALint new_sample;
+static int MS_ADPCM_decode_FULL(const MS_ADPCM_decoder_FULL *mstate,
+                                ALubyte **audio_buf, ALuint *audio_len)
+{
+    const unsigned int channels = mstate->wavefmt.channels;
+    const unsigned int blockalign = mstate->wavefmt.blockalign;
+    const unsigned int samples = mstate->wSamplesPerBlock;
+    if ( channels < 1 || channels > 2 || samples < 2 ||
+        blockalign < channels*7 + ((samples-2)*channels+1)/2 )
+        return -1;
 
     /* Allocate the proper sized output buffer */
-    encoded_len = *audio_len;
-    encoded = *audio_buf;
-    freeable = *audio_buf;
-    *audio_len = (encoded_len/MS_ADPCM_state_FULL.wavefmt.blockalign) * 
-        MS_ADPCM_state_FULL.wSamplesPerBlock*
-        MS_ADPCM_state_FULL.wavefmt.channels*sizeof(ALshort);
-    *audio_buf = (ALubyte *)malloc(*audio_len);
+    ADPCM_range all;
+    all.decode = MS_ADPCM_decode_block;
+    all.decoder = mstate;
+    all.encoded = *audio_buf;
+    all.blocks = *audio_len/blockalign;
+    all.blockalign = blockalign;
+    all.blocksamples = samples*channels;
+
+    *audio_len = all.blocks*all.blocksamples*sizeof(ALshort);
+    *audio_buf = (ALubyte *)malloc(*audio_len ? *audio_len : 1);
     if(*audio_buf == NULL)
         return -1;
-    decoded = *audio_buf;
+    all.decoded = (ALshort *)*audio_buf;
 
-    /* Get ready... Go! */
-    stereo = (MS_ADPCM_state_FULL.wavefmt.channels == 2);
-    state[0] = &MS_ADPCM_state_FULL.state[0];
-    state[1] = &MS_ADPCM_state_FULL.state[(int) stereo];
-    while ( encoded_len >= MS_ADPCM_state_FULL.wavefmt.blockalign ) {
-        /* Grab the initial information for this block */
-        state[0]->hPredictor = *encoded++;
-        if ( stereo )
-            state[1]->hPredictor = *encoded++;
-        state[0]->iDelta = ((encoded[1]<<8)|encoded[0]);
-        encoded += sizeof(ALshort);
-        if ( stereo ) {
-            state[1]->iDelta = ((encoded[1]<<8)|encoded[0]);
-            encoded += sizeof(ALshort);
-        }
-        state[0]->iSamp1 = ((encoded[1]<<8)|encoded[0]);
-        encoded += sizeof(ALshort);
-        if ( stereo ) {
-            state[1]->iSamp1 = ((encoded[1]<<8)|encoded[0]);
-            encoded += sizeof(ALshort);
-        }
-        state[0]->iSamp2 = ((encoded[1]<<8)|encoded[0]);
-        encoded += sizeof(ALshort);
-        if ( stereo ) {
-            state[1]->iSamp2 = ((encoded[1]<<8)|encoded[0]);
-            encoded += sizeof(ALshort);
-        }
-        coeff[0] = MS_ADPCM_state_FULL.aCoeff[state[0]->hPredictor];
-        coeff[1] = MS_ADPCM_state_FULL.aCoeff[state[1]->hPredictor];
-
-        /* Store the two initial samples we start with */
-        decoded[0] = state[0]->iSamp2&0xFF;
-        decoded[1] = state[0]->iSamp2>>8;
-        decoded += 2;
-        if ( stereo ) {
-            decoded[0] = state[1]->iSamp2&0xFF;
-            decoded[1] = state[1]->iSamp2>>8;
-            decoded += 2;
-        }
-        decoded[0] = state[0]->iSamp1&0xFF;
-        decoded[1] = state[0]->iSamp1>>8;
-        decoded += 2;
-        if ( stereo ) {
-            decoded[0] = state[1]->iSamp1&0xFF;
-            decoded[1] = state[1]->iSamp1>>8;
-            decoded += 2;
-        }
-
-        /* Decode and store the other samples in this block */
-        samplesleft = (MS_ADPCM_state_FULL.wSamplesPerBlock-2)*
-            MS_ADPCM_state_FULL.wavefmt.channels;
-        while ( samplesleft > 0 ) {
-            nybble = (*encoded)>>4;
-            new_sample = MS_ADPCM_nibble_FULL(state[0],nybble,coeff[0]);
-            decoded[0] = new_sample&0xFF;
-            new_sample >>= 8;
-            decoded[1] = new_sample&0xFF;
-            decoded += 2;
-
-            nybble = (*encoded)&0x0F;
-            new_sample = MS_ADPCM_nibble_FULL(state[1],nybble,coeff[1]);
-            decoded[0] = new_sample&0xFF;
-            new_sample >>= 8;
-            decoded[1] = new_sample&0xFF;
-            decoded += 2;
-
-            ++encoded;
-            samplesleft -= 2;
-        }
-        encoded_len -= MS_ADPCM_state_FULL.wavefmt.blockalign;
+    if ( !ADPCM_decode(all) ) {
+        free(*audio_buf);
+        *audio_buf = NULL;
+        return -1;
     }
-
-    /* free(freeable); */
     return 0;
 }
 
 int InitIMA_ADPCM(alIMAADPCM_state_LOKI *state, alWaveFMT_LOKI *format) {
     ALubyte  *rogue_feel;
-    ALushort extra_info;
 
     /* Set the rogue pointer to the IMA_ADPCM specific data */
     state->wavefmt.encoding     = swap16le(format->encoding);
@@ -1133,11 +1633,8 @@ int InitIMA_ADPCM(alIMAADPCM_state_LOKI *state, alWaveFMT_LOKI *format) {
     state->wavefmt.blockalign   = swap16le(format->blockalign);
     state->wavefmt.bitspersample =
         swap16le(format->bitspersample);
-    rogue_feel = (ALubyte *)format + sizeof(*format);
-    if ( sizeof(*format) == 16 ) {
-        extra_info = ((rogue_feel[1]<<8)|rogue_feel[0]);
-        rogue_feel += sizeof(ALushort);
-    }
+    /* Skip the size of the extra information */
+    rogue_feel = (ALubyte *)format + sizeof(*format) + sizeof(ALushort);
     state->wSamplesPerBlock = ((rogue_feel[1]<<8)|rogue_feel[0]);
 
     state->state[0].valprev = 0;
@@ -1149,36 +1646,32 @@ int InitIMA_ADPCM(alIMAADPCM_state_LOKI *state, alWaveFMT_LOKI *format) {
     return(0);
 }
 
-static int InitMS_ADPCM(alWaveFMT_LOKI *format) {
+static int InitMS_ADPCM(MS_ADPCM_decoder_FULL *state, alWaveFMT_LOKI *format) {
     ALubyte *rogue_feel;
-    ALushort extra_info;
     int i;
 
     /* Set the rogue pointer to the MS_ADPCM specific data */
-    MS_ADPCM_state_FULL.wavefmt.encoding = swap16le(format->encoding);
-    MS_ADPCM_state_FULL.wavefmt.channels = swap16le(format->channels);
-    MS_ADPCM_state_FULL.wavefmt.frequency = swap32le(format->frequency);
-    MS_ADPCM_state_FULL.wavefmt.byterate = swap32le(format->byterate);
-    MS_ADPCM_state_FULL.wavefmt.blockalign = swap16le(format->blockalign);
-    MS_ADPCM_state_FULL.wavefmt.bitspersample =
+    state->wavefmt.encoding = swap16le(format->encoding);
+    state->wavefmt.channels = swap16le(format->channels);
+    state->wavefmt.frequency = swap32le(format->frequency);
+    state->wavefmt.byterate = swap32le(format->byterate);
+    state->wavefmt.blockalign = swap16le(format->blockalign);
+    state->wavefmt.bitspersample =
         swap16le(format->bitspersample);
-    rogue_feel = (ALubyte *)format+sizeof(*format);
-    if(sizeof(*format) == 16) {
-        extra_info = ((rogue_feel[1]<<8)|rogue_feel[0]);
-        rogue_feel += sizeof(ALushort);
-    }
+    /* Skip the size of the extra information */
+    rogue_feel = (ALubyte *)format + sizeof(*format) + sizeof(ALushort);
 
-    MS_ADPCM_state_FULL.wSamplesPerBlock = ((rogue_feel[1]<<8)|rogue_feel[0]);
+    state->wSamplesPerBlock = ((rogue_feel[1]<<8)|rogue_feel[0]);
     rogue_feel += sizeof(ALushort);
-    MS_ADPCM_state_FULL.wNumCoef = ((rogue_feel[1]<<8)|rogue_feel[0]);
+    state->wNumCoef = ((rogue_feel[1]<<8)|rogue_feel[0]);
     rogue_feel += sizeof(ALushort);
-    if ( MS_ADPCM_state_FULL.wNumCoef != 7 )
+    if ( state->wNumCoef != 7 )
         return -1;
 
-    for(i = 0; i < MS_ADPCM_state_FULL.wNumCoef; i++) {
-        MS_ADPCM_state_FULL.aCoeff[i][0] =((rogue_feel[1]<<8)|rogue_feel[0]);
+    for(i = 0; i < state->wNumCoef; i++) {
+        state->aCoeff[i][0] = readLE16(rogue_feel);
         rogue_feel += sizeof(ALushort);
-        MS_ADPCM_state_FULL.aCoeff[i][1] =((rogue_feel[1]<<8)|rogue_feel[0]);
+        state->aCoeff[i][1] = readLE16(rogue_feel);
         rogue_feel += sizeof(ALushort);
     }
 
@@ -1215,6 +1708,7 @@ void *ac_wave_to_pcm(void *data, ALuint *size,
     int offset = 12;
     long length;
     alIMAADPCM_state_LOKI ima_decoder;
+    MS_ADPCM_decoder_FULL ms_decoder;
 
     do {
         offset += (length=ReadChunk(data, offset, &riffchunk)) + 8;
@@ -1264,10 +1758,10 @@ void *ac_wave_to_pcm(void *data, ALuint *size,
         return retval;
         break;
     case MS_ADPCM_CODE:
-        /* not possible to do an inplace conversion */
-        *fmt = AUDIO_S16LSB;
+        /* not possible to do an inplace conversion, decoded to native byte order */
+        *fmt = AUDIO_S16;
 
-        if(InitMS_ADPCM(format) < 0)
+        if(InitMS_ADPCM(&ms_decoder, format) < 0)
             return NULL;
 
         do {
@@ -1277,15 +1771,15 @@ void *ac_wave_to_pcm(void *data, ALuint *size,
             retval = riffchunk.data;
         } while (riffchunk.magic != DATA);
 
-        if(MS_ADPCM_decode_FULL((ALubyte **) &retval,
+        if(MS_ADPCM_decode_FULL(&ms_decoder, (ALubyte **) &retval,
             (ALuint *) &length) < 0)
             return NULL;
         *size = length;
         return retval;
         break;
     case IMA_ADPCM_CODE:
-        /* not possible to do an inplace conversion */
-        *fmt = AUDIO_S16LSB;
+        /* not possible to do an inplace conversion, decoded to native byte order */
+        *fmt = AUDIO_S16;
 
         if(InitIMA_ADPCM(&ima_decoder, format) < 0)
             return NULL;
@@ -1360,7 +1854,6 @@ void *AudioConvert(ALvoid *data,
     acAudioCVT s16le;
 
     if((f_format == t_format) && (f_freq == t_freq)) {
-        std::cerr << "No conversion needed.\n";
         /*
         * no conversion needed.
         */
@@ -1380,7 +1873,6 @@ void *AudioConvert(ALvoid *data,
     * full here.
     */
     if(_al_RAWFORMAT(f_format) == AL_FALSE) {
-        std::cerr << "Audio compressed\n";
         ALushort acfmt;
         ALubyte achan;
         ALushort acfreq;
@@ -23,6 +23,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 #include <openalpp/AudioEnvironment.h>
+#include <openalpp/StreamScheduler.h>
 #include <openalpp/windowsstuff.h>
 
 using namespace openalpp;
@@ -41,6 +42,31 @@ AudioEnvironment::AudioEnvironment(int frequency,int refresh) throw (InitError)
 : AudioBase(frequency,refresh) {
 }
 
+AudioEnvironment::AudioEnvironment(const RenderFormat &format,bool displayInitMsgs)
+throw (InitError)
+: AudioBase(format,displayInitMsgs) {
+}
+
+// Frames rendered between refills of the streams, well below the frames
+// queued by a stream
+static const unsigned int RENDER_CHUNK=512;
+
+void AudioEnvironment::render(void *buffer,unsigned int frames) throw (FatalError) {
+    if(!isLoopback())
+        throw FatalError("AudioEnvironment::render(): Not a loopback environment");
+
+    const unsigned int framesize=getRenderFormat().getFrameSize();
+    char *out=(char *)buffer;
+    while(frames) {
+        StreamScheduler::instance()->serviceNow();
+
+        const unsigned int chunk=frames<RENDER_CHUNK ? frames : RENDER_CHUNK;
+        renderSamples(out,chunk);
+        out+=chunk*framesize;
+        frames-=chunk;
+    }
+}
+
 void AudioEnvironment::setSoundVelocity(float speed) throw(ValueError,FatalError){
     alDopplerVelocity(speed);
     ALenum error;
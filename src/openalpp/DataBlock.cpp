@@ -0,0 +1,90 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <istream>
+#include <iterator>
+
+#include <openalpp/DataBlock.h>
+
+using namespace openalpp;
+
+
+MemoryBlock::MemoryBlock(const void *data,size_t size)
+: memory_((const char *)data,(const char *)data+size)
+{
+    data_ = memory_.empty() ? 0L : &memory_[0];
+    size_ = memory_.size();
+}
+
+MemoryBlock::MemoryBlock(std::istream &stream) throw (FileError)
+{
+    // One large sequential read if the size is known
+    std::streampos start = stream.tellg();
+    if(start!=std::streampos(-1) && stream.seekg(0,std::ios::end)) {
+        std::streampos end = stream.tellg();
+        stream.seekg(start);
+        if(end>start) {
+            memory_.resize((size_t)(end-start));
+            stream.read(&memory_[0],memory_.size());
+            memory_.resize((size_t)stream.gcount());
+        }
+    } else {
+        stream.clear();
+        memory_.assign(std::istreambuf_iterator<char>(stream),std::istreambuf_iterator<char>());
+    }
+
+    if(memory_.empty())
+        throw FileError("MemoryBlock: Couldn't read any data from stream");
+
+    data_ = &memory_[0];
+    size_ = memory_.size();
+}
+
+MemoryBlock::MemoryBlock(std::vector<char> &data)
+{
+    memory_.swap(data);
+    data_ = memory_.empty() ? 0L : &memory_[0];
+    size_ = memory_.size();
+}
+
+SubBlock::SubBlock(const DataBlock *parent,size_t offset,size_t size)
+: parent_(parent), offset_(offset)
+{
+    if(offset_>parent->size())
+        offset_ = parent->size();
+    if(size>parent->size()-offset_)
+        size = parent->size()-offset_;
+    data_ = parent->data()+offset_;
+    size_ = size;
+}
+
+void SubBlock::willNeed(size_t offset,size_t length) const
+{
+    if(offset>=size_)
+        return;
+    if(length>size_-offset)
+        length = size_-offset;
+    parent_->willNeed(offset_+offset,length);
+}
@@ -129,8 +129,11 @@ void DeviceUpdater::run() {
             totalDataSize_ += tmpBufSize_;
             leave();
         }
-        YieldCurrentThread();
-        OpenThreads::Thread::microSleep(10*1000);
+        else
+        {
+            // Sleep until the rest of the block should have been captured
+            waitForWake((double)(nSamples-iSamplesAvailable+1)/frequency_);
+        }
         //std::cerr << " capturing data " << std::endl;
 
     } while(!shouldStop() && !done);
@@ -23,179 +23,187 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <iostream>
+#include <fstream>
 #include <sstream>
+#include <cstdlib>
 
 #include <openalpp/FileStreamUpdater.h>
 #include <openalpp/FileStream.h>
+#include <openalpp/MappedFile.h>
+#include <openalpp/DataBlock.h>
 #include <openalpp/Sample.h>
-#include <vorbis/vorbisfile.h>
-
-#ifdef _WIN32 /* We need the following two to set stdin/stdout to binary */
-#include <io.h>
-#include <fcntl.h>
-#endif
-
-
-
-
-/************************************************************************************************************************
-The following function are the vorbis callback functions.  As their names suggest, they are expected to work in exactly the
-same way as normal c io functions (fread, fclose etc.).  Its up to us to return the information that the libs need to parse
-the file from memory
-************************************************************************************************************************/
-//---------------------------------------------------------------------------------
-// Function    : VorbisRead
-// Purpose    : Callback for the Vorbis read function
-// Info        : 
-//---------------------------------------------------------------------------------
-size_t VorbisRead(void *ptr            /* ptr to the data that the vorbis files need*/, 
-                  size_t byteSize    /* how big a byte is*/, 
-                  size_t sizeToRead /* How much we can read*/, 
-                  void *datasource    /* this is a pointer to the data we passed into ov_open_callbacks (our SOggFile struct*/)
-{
-    FILE* file = (FILE*)datasource;
-
-    size_t bytes_read = fread(ptr, byteSize, sizeToRead, file);
 
-    return bytes_read; //actualSizeToRead;
-}
+using namespace openalpp;
 
-//---------------------------------------------------------------------------------
-// Function    : VorbisSeek
-// Purpose    : Callback for the Vorbis seek function
-// Info        : 
-//---------------------------------------------------------------------------------
-int VorbisSeek(void *datasource        /*this is a pointer to the data we passed into ov_open_callbacks (our SOggFile struct*/, 
-               ogg_int64_t offset    /*offset from the point we wish to seek to*/, 
-               int whence            /*where we want to seek to*/)
+FileStream::FileStream(const std::string& filename,const int buffersize,
+                       unsigned int numbuffers,float bufferduration,
+                       unsigned int decodeahead)
+throw (NameError,InitError,FileError) : Stream() , filename_(filename)
 {
-    FILE* file = (FILE*)datasource;
+    // Map the file into memory if possible, otherwise read all of it
+    osg::ref_ptr<DataBlock> block;
+    try {
+        block = new MappedFile(filename);
+    }
+    catch(FileError &) {
+        std::ifstream file(filename.c_str(),std::ios::in|std::ios::binary);
+        if(!file)
+            throw FileError("FileStream: Couldn't open file: " + filename);
+        block = new MemoryBlock(file);
+    }
 
-    return fseek(file, offset, whence );
+    open(block.get(),buffersize,numbuffers,bufferduration,decodeahead);
 }
 
-//---------------------------------------------------------------------------------
-// Function    : VorbisClose
-// Purpose    : Callback for the Vorbis close function
-// Info        : 
-//---------------------------------------------------------------------------------
-int VorbisClose(void *datasource /*this is a pointer to the data we passed into ov_open_callbacks (our SOggFile struct*/)
+FileStream::FileStream(DataBlock *block,const int buffersize,
+                       unsigned int numbuffers,float bufferduration,
+                       unsigned int decodeahead)
+throw (NameError,InitError,FileError) : Stream()
 {
-    // This file is called when we call ov_close.  If we wanted, we could free our memory here, but
-    FILE* file = (FILE*)datasource;
+    if(!block || !block->size())
+        throw FileError("FileStream: No data to stream from");
 
-    return fclose(file);
+    open(block,buffersize,numbuffers,bufferduration,decodeahead);
 }
 
-//---------------------------------------------------------------------------------
-// Function    : VorbisTell
-// Purpose    : Classback for the Vorbis tell function
-// Info        : 
-//---------------------------------------------------------------------------------
-long VorbisTell(void *datasource /*this is a pointer to the data we passed into ov_open_callbacks (our SOggFile struct*/)
+FileStream::FileStream(std::istream &stream,const int buffersize,
+                       unsigned int numbuffers,float bufferduration,
+                       unsigned int decodeahead)
+throw (NameError,InitError,FileError) : Stream()
 {
-    FILE* file = (FILE*)datasource;
-
-    return ftell(file);
+    osg::ref_ptr<DataBlock> block = new MemoryBlock(stream);
+    open(block.get(),buffersize,numbuffers,bufferduration,decodeahead);
 }
-/************************************************************************************************************************
-End of Vorbis callback functions
-************************************************************************************************************************/
 
+void FileStream::open(DataBlock *block,const int buffersize,
+                      unsigned int numbuffers,float bufferduration,
+                      unsigned int decodeahead)
+throw (NameError,InitError,FileError)
+{
+    block_ = block;
+    numBuffers_ = numbuffers<2 ? 2 : numbuffers;
+    bufferDuration_ = bufferduration;
+    decodeAhead_ = decodeahead;
+
+    // Find a decoder for the file type, or throw an error.
+    osg::ref_ptr<StreamDecoder> decoder = openDecoder();
+    updater_ = createUpdater(decoder.get(),createBuffers(numBuffers_));
+}
 
+StreamDecoder *FileStream::openDecoder() throw (FileError)
+{
+    StreamDecoder *decoder = StreamDecoderRegistry::instance()->open(block_.get(),filename_);
+    if(!decoder)
+        throw FileError("FileStream: File of unknown type");
+    return decoder;
+}
 
-using namespace openalpp;
+/**
+* Get a sample position from a tag like LOOPSTART=44100.
+* @return -1 if there is no such tag.
+*/
+static long getTagFrames(StreamDecoder *decoder,const char *tag)
+{
+    const std::string value = decoder->getTag(tag);
+    if(value.empty())
+        return -1;
+    return atol(value.c_str());
+}
 
-FileStream::FileStream(const std::string& filename,const int buffersize)
-throw (NameError,InitError,FileError) : Stream() , filename_(filename)
+FileStreamUpdater *FileStream::createUpdater(StreamDecoder *decoder,
+                                             const std::vector<ALuint> &buffers,
+                                             const FileStreamUpdater *like)
+throw (FatalError,FileError)
 {
-    FILE *filehandle=fopen(filename.c_str(),"rb");
-    if(!filehandle)
-        throw FileError("FileStream: Couldn't open file: " + filename);
+    const std::string filename = filename_.empty() ? std::string("<memory>") : filename_;
 
-    unsigned long    ulFrequency = 0;
-    unsigned long    ulFormat = 0;
-    unsigned long    ulBufferSize;
-    unsigned long    ulChannels=0;
+    // Released if it can't be used
+    osg::ref_ptr<StreamDecoder> ref = decoder;
+    const unsigned long ulFrequency = decoder->getFrequency();
+    const unsigned long ulChannels = decoder->getChannels();
 
-    oggfile_ = new OggVorbis_File;
-    // Check for file type, create a FileStreamUpdater if a known type is
-    // detected, otherwise throw an error.
+    if (ulChannels!=1 && ulChannels!=2 && ulChannels!=4 && ulChannels!=6) {
+        std::ostringstream str;
+        str << "FileStream: File " << filename << " contains " << ulChannels << " which is not recognized" << std::endl;
+        throw FileError(str.str().c_str());
+    }
+    if (!decoder->getFormat()) {
+        if (ulChannels==4)
+            throw FatalError("QUAD16 format was requested but is not supported by OpenAL device");
+        throw FatalError("51CHN16 format was requested but is not supported by OpenAL device");
+    }
 
-    _vorbisCallbacks.read_func = VorbisRead;
-    _vorbisCallbacks.close_func = VorbisClose;
-    _vorbisCallbacks.seek_func = VorbisSeek;
-    _vorbisCallbacks.tell_func = VorbisTell;
+    // Set BufferSize to bufferduration seconds of 16 bit samples.
+    // IMPORTANT : The Buffer Size must be an exact multiple of the BlockAlignment,
+    // which it is when counted in whole sample frames.
+    unsigned long ulFrames = (unsigned long)(ulFrequency * bufferDuration_);
+    if (ulFrames < 256)
+        ulFrames = 256;
+    const unsigned long ulBufferSize = ulFrames * ulChannels * 2;
+
+    FileStreamUpdater *updater=new FileStreamUpdater(decoder,
+        buffers,
+        ulBufferSize); 
+    updater->setDecodeAhead(decodeAhead_);
+
+    if(like) {
+        updater->setLooping(like->getLooping());
+        updater->setLoopPoints(like->getLoopStart(),like->getLoopEnd());
+        return updater;
+    }
 
+    // Loop points, as used by many games and tools
+    long loopstart = getTagFrames(decoder,"LOOPSTART");
+    long loopend = getTagFrames(decoder,"LOOPEND");
+    long looplength = getTagFrames(decoder,"LOOPLENGTH");
+    if(loopend<0 && looplength>0)
+        loopend = (loopstart>0 ? loopstart : 0) + looplength;
+    if(loopstart>0 || loopend>0)
+        updater->setLoopPoints(loopstart>0 ? loopstart : 0,loopend>0 ? loopend : 0);
 
+    return updater;
+}
 
-    //    if(ov_open(filehandle, oggfile_, NULL, 0)>=0) 
-    if (ov_open_callbacks(filehandle, oggfile_, NULL, 0, _vorbisCallbacks)>=0)
-    {
-        vorbis_info *ogginfo=ov_info(oggfile_,-1);
-
-        ulFrequency = ogginfo->rate;
-        ulChannels = ogginfo->channels;
-
-        if (ulChannels==1) {// We'll request 16 bit later...
-            ulFormat=AL_FORMAT_MONO16;
-            // Set BufferSize to 250ms (Frequency * 2 (16bit) divided by 4 (quarter of a second))
-            ulBufferSize = ulFrequency >> 1;
-            // IMPORTANT : The Buffer Size must be an exact multiple of the BlockAlignment ...
-            ulBufferSize -= (ulBufferSize % 2);
-            ulBufferSize = ulBufferSize*2;              
-        }
-        else if (ulChannels==2) {
-            ulFormat=AL_FORMAT_STEREO16;
-            // Set BufferSize to 250ms (Frequency * 4 (16bit stereo) divided by 4 (quarter of a second))
-            ulBufferSize = ulFrequency;
-            // IMPORTANT : The Buffer Size must be an exact multiple of the BlockAlignment ...
-            ulBufferSize -= (ulBufferSize % 4);
-            ulBufferSize = ulBufferSize*2;              
-        }
-        else if (ulChannels==4) {
-            ulFormat = alGetEnumValue("AL_FORMAT_QUAD16");
-            if (!ulFormat) 
-                throw FatalError("QUAD16 format was requested but is not supported by OpenAL device");
-            // Set BufferSize to 250ms (Frequency * 8 (16bit 4-channel) divided by 4 (quarter of a second))
-            ulBufferSize = ulFrequency * 2;
-            // IMPORTANT : The Buffer Size must be an exact multiple of the BlockAlignment ...
-            ulBufferSize -= (ulBufferSize % 8);
-        }
-        else if (ulChannels == 6)
-        {
-            ulFormat = alGetEnumValue("AL_FORMAT_51CHN16");
-            if (!ulFormat)
-                throw FatalError("51CHN16 format was requested but is not supported by OpenAL device");
-
-            // Set BufferSize to 250ms (Frequency * 12 (16bit 6-channel) divided by 4 (quarter of a second))
-            ulBufferSize = ulFrequency * 3;
-            // IMPORTANT : The Buffer Size must be an exact multiple of the BlockAlignment ...
-            ulBufferSize -= (ulBufferSize % 12);
-        }
-        else {
-            fclose(filehandle);
-            std::ostringstream str;
-            str << "FileStream: File " << filename << " contains " << ulChannels << " which is not recognized" << std::endl;
-            throw FileError(str.str().c_str());
-        }
-
-        updater_=new FileStreamUpdater(oggfile_,
-            buffer_->getName(),buffer2_->getAlBuffer(),
-            ulFormat,ulFrequency,
-            ulBufferSize); 
-
-    } 
-    else 
-    {
-        fclose(filehandle);
-        throw FileError("FileStream: File of unknown type");
+bool FileStream::createCursor(Cursor &cursor)
+{
+    try {
+        cursor.updater = createUpdater(openDecoder(),
+            generateBuffers(numBuffers_,cursor.buffers),
+            (const FileStreamUpdater *)updater_.get());
+    }
+    catch(Error &error) {
+        std::cerr << "FileStream: Sources will play in lock-step: " << error.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void FileStream::reopen()
+{
+    // Fall back to sharing the decoder if the file can't be opened again
+    std::vector<osg::ref_ptr<SoundBuffer> > buffers;
+    try {
+        updater_ = createUpdater(openDecoder(),
+            generateBuffers(numBuffers_,buffers),
+            (const FileStreamUpdater *)updater_.get());
     }
+    catch(Error &error) {
+        std::cerr << "FileStream: Copy shares the decoder: " << error.what() << std::endl;
+        return;
+    }
+    morebuffers_ = buffers;
+    cursors_.clear();
+    isRecording_ = false;
 }
 
 FileStream::FileStream(const FileStream &stream)
-: Stream((const Stream &)stream), oggfile_(stream.oggfile_)
+: Stream((const Stream &)stream),
+filename_(stream.filename_), block_(stream.block_),
+numBuffers_(stream.numBuffers_), bufferDuration_(stream.bufferDuration_),
+decodeAhead_(stream.decodeAhead_)
 {
+    reopen();
 }
 
 FileStream::~FileStream() 
@@ -206,12 +214,32 @@ FileStream &FileStream::operator=(const FileStream &stream) {
     if(&stream!=this) 
     {
         Stream::operator=((const Stream &)stream);
-        oggfile_ = stream.oggfile_;
+        filename_ = stream.filename_;
+        block_ = stream.block_;
+        numBuffers_ = stream.numBuffers_;
+        bufferDuration_ = stream.bufferDuration_;
+        decodeAhead_ = stream.decodeAhead_;
+        reopen();
     }
     return *this;
 }
 
 void FileStream::setLooping(bool loop) {
-    ((FileStreamUpdater *)updater_.get())->setLooping(loop);
+    std::vector<osg::ref_ptr<StreamUpdater> > updaters=getUpdaters();
+    for(unsigned int i=0;i<updaters.size();i++)
+        ((FileStreamUpdater *)updaters[i].get())->setLooping(loop);
 }
 
+void FileStream::setLoopPoints(unsigned int start,unsigned int end) {
+    std::vector<osg::ref_ptr<StreamUpdater> > updaters=getUpdaters();
+    for(unsigned int i=0;i<updaters.size();i++)
+        ((FileStreamUpdater *)updaters[i].get())->setLoopPoints(start,end);
+}
+
+unsigned int FileStream::getLoopStart() const {
+    return ((FileStreamUpdater *)updater_.get())->getLoopStart();
+}
+
+unsigned int FileStream::getLoopEnd() const {
+    return ((FileStreamUpdater *)updater_.get())->getLoopEnd();
+}
@@ -27,170 +27,114 @@
 
 using namespace openalpp;
 
-const char *getOggVorbisErrorMessage(int e)
-{
-    switch(e) {
-    case (OV_ENOSEEK):
-        return "Bitstream is not seekable.";
-    case (OV_EINVAL):
-        return "Invalid argument value; possibly called with an OggVorbis_File structure that isn't open.";
-    case (OV_EREAD):
-        return "A read from media returned an error.";
-    case (OV_EFAULT):
-        return "Internal logic fault; indicates a bug or heap/stack corruption.";
-    case (OV_EBADLINK):
-        return "Invalid stream section supplied to libvorbisfile, or the requested link is corrupt.";
-    default:
-        return "Invalid error code specified";
-    }
-    return "";
-}
-
 FileStreamUpdater::FileStreamUpdater(
-                                     OggVorbis_File *oggfile,
-                                     const ALuint buffer1,ALuint buffer2,
-                                     ALenum format,unsigned int frequency,
+                                     StreamDecoder *decoder,
+                                     const std::vector<ALuint> &buffers,
                                      unsigned int buffersize)
-                                     : StreamUpdater(buffer1,buffer2,format,frequency), 
+                                     : StreamUpdater(buffers,decoder->getFormat(),decoder->getFrequency()), 
+                                     decoder_(decoder),
                                      buffersize_(buffersize),
-                                     oggfile_(oggfile),
-                                     looping_(false),
-                                     seekPending_(false),
-                                     seekTime_(0)
+                                     looping_(0),
+                                     loopStart_(0),
+                                     loopEnd_(0),
+                                     frameSize_(decoder->getChannels()*2),
+                                     position_(0)
 {
-
-    setCancelModeAsynchronous();
-
     buffer_ = new ALshort[buffersize_/sizeof(ALshort)];
+
+    // Serviced by the shared StreamScheduler threads
+    schedule();
 }
 
 FileStreamUpdater::~FileStreamUpdater() 
 {
-    // call update to do any remaining buffer deallocation
-    StreamUpdater::update(buffer_, 0); 
+    // Make sure no scheduler thread is decoding or feeding while we clean up
+    unschedule();
 
-    if (oggfile_)
-    {
-        ov_clear(oggfile_);
-        delete oggfile_;
-    }
-    delete buffer_;
+    decoder_ = 0L;
+    delete[] buffer_;
     buffer_=0L;
 }
 
-void FileStreamUpdater::run() 
+void *FileStreamUpdater::readBlock(unsigned int &length) 
 {
+    unsigned int count=0;
+    bool rewound=false;     // At the loop start, and nothing read since
 
-    bool eofReached = false;
-
-    runmutex_.lock();
-    while(!shouldStop())
+    while (count < buffersize_)
     {
+        const bool looping = (unsigned int)looping_!=0;
+        const unsigned long loopStart = (unsigned int)loopStart_;
+        const unsigned long loopEnd = (unsigned int)loopEnd_;
 
-        unsigned int count=0;
-        int stream=0;
-
-        while (count < buffersize_)
+        unsigned int want = buffersize_-count;
+        if (looping && loopEnd>loopStart)
         {
-            long amt;
-
-            if (seekPending_)
+            // Stop exactly at the loop end, and continue from the loop start
+            // in the same buffer
+            if (position_ >= loopEnd)
             {
-                seekNow(seekTime_);
-                seekPending_ = false;
-                count = 0;
+                if (!seekFrame(loopStart))
+                    break;
+                rewound = true;
                 continue;
-
-            }
-
-            if (!eofReached)
-            {
-                amt = ov_read(oggfile_,&((char *)buffer_)[count],
-                    buffersize_-count,
-                    0,2,1,&stream);
-            }
-            else
-            {
-                amt = 0;
             }
+            unsigned long left = loopEnd-position_;
+            if (want > left*frameSize_)
+                want = (unsigned int)(left*frameSize_);
+        }
 
+        long amt = decoder_->read(&((char *)buffer_)[count],want);
 
-            // We must break if:
-            // * An error occurred
-            // * We hit EOF and the file was not looping 
-            // * We hit EOF and the file was looping, but we couldn't loop...
-            if (amt > 0)
-            {
-                eofReached = false;
-            }
-            else if (amt == 0) 
-            {
-                //if (!eofReached) fprintf(stdout, "EOF reached\n");
-                eofReached = true;
-                if (looping_)
-                {
-                    if(!ov_seekable(oggfile_))
-                        break;
-                    if(seekNow(0.0)) 
-                        eofReached = false;
-                    else
-                        break;
-
-                }
-            }
-            else
-            {
-                std::cerr << "FileStreamUpdater::run() - ov_read error" << std::endl;
+        // We must break if:
+        // * An error occurred
+        // * We hit EOF and the file was not looping 
+        // * We hit EOF and the file was looping, but we couldn't loop...
+        // * We hit EOF right after looping, the loop start is at or past
+        //   the end of the file, or the file is empty
+        if (amt > 0)
+        {
+            count += amt;
+            position_ += amt/frameSize_;
+            rewound = false;
+        }
+        else if (amt == 0) 
+        {
+            if (!looping || rewound || !seekFrame(loopStart))
                 break;
-            }
-
-
-            if (amt > 0)
-            {
-                count += amt;
-            }
-
-
+            rewound = true;
+        }
+        else
+        {
+            std::cerr << "FileStreamUpdater::readBlock() - decoding error" << std::endl;
+            break;
         }
-
-
-        update(buffer_, count);
-        //setSleepTime(10*1000);
-        //sleep();
-
-        //std::cerr << "FileStreamUpdater" << std::endl;
-
-        runmutex_.unlock();
     }
 
-    runmutex_.unlock();
+    length = count;
+    return count ? buffer_ : NULL;
 }
 
 
-void FileStreamUpdater::seek(float time_s)
+bool FileStreamUpdater::seekNow(float time_s)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(runmutex_);
-
-    seekTime_ = time_s;
-    seekPending_ = true;
+    return seekFrame((unsigned long)(time_s*frequency_ + 0.5f));
 }
 
-bool FileStreamUpdater::seekNow(float time_s)
+bool FileStreamUpdater::seekFrame(unsigned long frame)
 {
-    if ((oggfile_) && ov_seekable(oggfile_))
-    {
-        int s = ov_time_seek(oggfile_, time_s);
-        if (s) {
-            const char *str = getOggVorbisErrorMessage(s);
-            std::cerr << "Error seeking oggstream: " << str << std::endl;
-            return false;
-        }
-        return true;
-    }
-    return false;
+    if (!decoder_->seek(frame))
+        return false;
+    position_ = frame;
+    return true;
 }
 
 void FileStreamUpdater::setLooping(bool loop) {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(runmutex_);
-    looping_=loop;
+    // Picked up by the decoder at the next loop end
+    looping_.exchange(loop ? 1 : 0);
+}
+
+void FileStreamUpdater::setLoopPoints(unsigned int start,unsigned int end) {
+    loopStart_.exchange(start);
+    loopEnd_.exchange(end);
 }
@@ -0,0 +1,251 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef OPENALPP_HAVE_FLAC
+
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+#include <FLAC/stream_decoder.h>
+
+#include <openalpp/FlacDecoder.h>
+
+using namespace openalpp;
+
+namespace {
+
+    /**
+    * Decoder of a FLAC file in memory. libFLAC decodes a whole frame at a
+    * time, the samples that weren't read yet are kept in pending_.
+    */
+    class FlacDecoder : public StreamDecoder {
+    public:
+        FlacDecoder(const DataBlock *block);
+
+        bool valid() const { return decoder_ && channels_ && frequency_; }
+
+        long read(char *buffer,unsigned int length);
+        bool seek(unsigned long frame);
+        std::string getTag(const std::string &name);
+
+    protected:
+        virtual ~FlacDecoder();
+
+        static FLAC__StreamDecoderReadStatus readCallback(const FLAC__StreamDecoder *,
+            FLAC__byte buffer[],size_t *bytes,void *data);
+        static FLAC__StreamDecoderSeekStatus seekCallback(const FLAC__StreamDecoder *,
+            FLAC__uint64 offset,void *data);
+        static FLAC__StreamDecoderTellStatus tellCallback(const FLAC__StreamDecoder *,
+            FLAC__uint64 *offset,void *data);
+        static FLAC__StreamDecoderLengthStatus lengthCallback(const FLAC__StreamDecoder *,
+            FLAC__uint64 *length,void *data);
+        static FLAC__bool eofCallback(const FLAC__StreamDecoder *,void *data);
+        static FLAC__StreamDecoderWriteStatus writeCallback(const FLAC__StreamDecoder *,
+            const FLAC__Frame *frame,const FLAC__int32 *const samples[],void *data);
+        static void metadataCallback(const FLAC__StreamDecoder *,
+            const FLAC__StreamMetadata *metadata,void *data);
+        static void errorCallback(const FLAC__StreamDecoder *,
+            FLAC__StreamDecoderErrorStatus,void *) {}
+
+        osg::ref_ptr<const DataBlock> block_;
+        size_t position_;
+        FLAC__StreamDecoder *decoder_;
+        unsigned int bits_;
+        std::vector<ALshort> pending_;
+        size_t pendingPos_;
+        std::vector<std::string> comments_;
+    };
+
+}
+
+bool FlacDecoderFactory::probe(const char *data,size_t size) const {
+    return size>=4 && !memcmp(data,"fLaC",4);
+}
+
+StreamDecoder *FlacDecoderFactory::open(const DataBlock *block,const std::string &) {
+    osg::ref_ptr<FlacDecoder> decoder=new FlacDecoder(block);
+    if(!decoder->valid())
+        return NULL;
+    return decoder.release();
+}
+
+FlacDecoder::FlacDecoder(const DataBlock *block)
+: StreamDecoder(), block_(block), position_(0), decoder_(0L), bits_(16), pendingPos_(0) {
+    decoder_=FLAC__stream_decoder_new();
+    if(!decoder_)
+        return;
+
+    FLAC__stream_decoder_set_metadata_respond(decoder_,FLAC__METADATA_TYPE_VORBIS_COMMENT);
+    if(FLAC__stream_decoder_init_stream(decoder_,readCallback,seekCallback,tellCallback,
+        lengthCallback,eofCallback,writeCallback,metadataCallback,errorCallback,this)
+        !=FLAC__STREAM_DECODER_INIT_STATUS_OK ||
+        !FLAC__stream_decoder_process_until_end_of_metadata(decoder_)) {
+        FLAC__stream_decoder_delete(decoder_);
+        decoder_=0L;
+    }
+}
+
+FlacDecoder::~FlacDecoder() {
+    if(decoder_) {
+        FLAC__stream_decoder_finish(decoder_);
+        FLAC__stream_decoder_delete(decoder_);
+    }
+}
+
+long FlacDecoder::read(char *buffer,unsigned int length) {
+    const size_t wanted=length/2;
+    size_t count=0;
+
+    while(count<wanted) {
+        if(pendingPos_==pending_.size()) {
+            pending_.clear();
+            pendingPos_=0;
+            if(FLAC__stream_decoder_get_state(decoder_)==FLAC__STREAM_DECODER_END_OF_STREAM)
+                break;
+            if(!FLAC__stream_decoder_process_single(decoder_))
+                return count ? (long)(count*2) : -1;
+            continue;
+        }
+
+        size_t amt=std::min(wanted-count,pending_.size()-pendingPos_);
+        memcpy(buffer+count*2,&pending_[pendingPos_],amt*2);
+        pendingPos_+=amt;
+        count+=amt;
+    }
+    return (long)(count*2);
+}
+
+bool FlacDecoder::seek(unsigned long frame) {
+    pending_.clear();
+    pendingPos_=0;
+    if(FLAC__stream_decoder_seek_absolute(decoder_,frame))
+        return true;
+
+    if(FLAC__stream_decoder_get_state(decoder_)==FLAC__STREAM_DECODER_SEEK_ERROR)
+        FLAC__stream_decoder_flush(decoder_);
+    pending_.clear();
+    return false;
+}
+
+std::string FlacDecoder::getTag(const std::string &name) {
+    // Comments are NAME=value, with case insensitive names
+    for(unsigned int i=0;i<comments_.size();i++) {
+        const std::string &comment=comments_[i];
+        if(comment.size()<=name.size() || comment[name.size()]!='=')
+            continue;
+        unsigned int c=0;
+        while(c<name.size() && toupper(comment[c])==toupper(name[c]))
+            c++;
+        if(c==name.size())
+            return comment.substr(name.size()+1);
+    }
+    return std::string();
+}
+
+FLAC__StreamDecoderReadStatus FlacDecoder::readCallback(const FLAC__StreamDecoder *,
+    FLAC__byte buffer[],size_t *bytes,void *data) {
+    FlacDecoder *self=(FlacDecoder *)data;
+    size_t left=self->block_->size()-self->position_;
+    if(!left) {
+        *bytes=0;
+        return FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
+    }
+    if(*bytes>left)
+        *bytes=left;
+    memcpy(buffer,self->block_->data()+self->position_,*bytes);
+    self->position_+=*bytes;
+    return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+}
+
+FLAC__StreamDecoderSeekStatus FlacDecoder::seekCallback(const FLAC__StreamDecoder *,
+    FLAC__uint64 offset,void *data) {
+    FlacDecoder *self=(FlacDecoder *)data;
+    if(offset>self->block_->size())
+        return FLAC__STREAM_DECODER_SEEK_STATUS_ERROR;
+    if((size_t)offset!=self->position_)
+        self->block_->willNeed((size_t)offset,64*1024);
+    self->position_=(size_t)offset;
+    return FLAC__STREAM_DECODER_SEEK_STATUS_OK;
+}
+
+FLAC__StreamDecoderTellStatus FlacDecoder::tellCallback(const FLAC__StreamDecoder *,
+    FLAC__uint64 *offset,void *data) {
+    *offset=((FlacDecoder *)data)->position_;
+    return FLAC__STREAM_DECODER_TELL_STATUS_OK;
+}
+
+FLAC__StreamDecoderLengthStatus FlacDecoder::lengthCallback(const FLAC__StreamDecoder *,
+    FLAC__uint64 *length,void *data) {
+    *length=((FlacDecoder *)data)->block_->size();
+    return FLAC__STREAM_DECODER_LENGTH_STATUS_OK;
+}
+
+FLAC__bool FlacDecoder::eofCallback(const FLAC__StreamDecoder *,void *data) {
+    FlacDecoder *self=(FlacDecoder *)data;
+    return self->position_>=self->block_->size();
+}
+
+FLAC__StreamDecoderWriteStatus FlacDecoder::writeCallback(const FLAC__StreamDecoder *,
+    const FLAC__Frame *frame,const FLAC__int32 *const samples[],void *data) {
+    FlacDecoder *self=(FlacDecoder *)data;
+    const unsigned int channels=frame->header.channels;
+    const unsigned int blocksize=frame->header.blocksize;
+    const unsigned int bits=frame->header.bits_per_sample ?
+        frame->header.bits_per_sample : self->bits_;
+    if(channels!=self->channels_)
+        return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+
+    // Interleave, scaled to 16 bits
+    const size_t start=self->pending_.size();
+    self->pending_.resize(start+blocksize*channels);
+    ALshort *out=&self->pending_[start];
+    for(unsigned int i=0;i<blocksize;i++) {
+        for(unsigned int c=0;c<channels;c++) {
+            FLAC__int32 s=samples[c][i];
+            *out++=(ALshort)(bits>16 ? s>>(bits-16) : s*(1<<(16-bits)));
+        }
+    }
+    return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+}
+
+void FlacDecoder::metadataCallback(const FLAC__StreamDecoder *,
+    const FLAC__StreamMetadata *metadata,void *data) {
+    FlacDecoder *self=(FlacDecoder *)data;
+    if(metadata->type==FLAC__METADATA_TYPE_STREAMINFO) {
+        const FLAC__StreamMetadata_StreamInfo &info=metadata->data.stream_info;
+        self->channels_=info.channels;
+        self->frequency_=info.sample_rate;
+        self->frames_=(unsigned long)info.total_samples;
+        self->bits_=info.bits_per_sample;
+    } else if(metadata->type==FLAC__METADATA_TYPE_VORBIS_COMMENT) {
+        const FLAC__StreamMetadata_VorbisComment &comment=metadata->data.vorbis_comment;
+        for(FLAC__uint32 i=0;i<comment.num_comments;i++)
+            self->comments_.push_back(std::string((const char *)comment.comments[i].entry,
+                comment.comments[i].length));
+    }
+}
+
+#endif // OPENALPP_HAVE_FLAC
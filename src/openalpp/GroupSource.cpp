@@ -23,15 +23,124 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <algorithm>
 #include <sstream>
+#include <vector>
 
 #include <openalpp/GroupSource.h>
+#include <openalpp/Sample.h>
 #include <openalpp/windowsstuff.h>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#define OPENALPP_MIX_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define OPENALPP_MIX_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OPENALPP_MIX_NEON
+#endif
+
 using namespace openalpp;
 
+/**
+* Frames of the bus that all sources are added to before moving on, 8 kB.
+*/
+static const unsigned long MIX_BLOCK=1024;
+
+/**
+* Add stereo samples to the bus, times the gain of each channel.
+*/
+static void mixStereo(float *bus,const ALshort *in,unsigned long frames,
+                      float lgain,float rgain)
+{
+    const unsigned long n=frames*2;
+    unsigned long i=0;
+#if defined(OPENALPP_MIX_AVX)
+    const __m256 gain=_mm256_setr_ps(lgain,rgain,lgain,rgain,lgain,rgain,lgain,rgain);
+    for(;i+16<=n;i+=16) {
+        // Sign extend the samples to 32 bits, AVX has no 256 bit integers
+        __m128i v0=_mm_loadu_si128((const __m128i *)(in+i));
+        __m128i v1=_mm_loadu_si128((const __m128i *)(in+i+8));
+        __m256i w0=_mm256_insertf128_si256(_mm256_castsi128_si256(
+            _mm_srai_epi32(_mm_unpacklo_epi16(v0,v0),16)),_mm_srai_epi32(_mm_unpackhi_epi16(v0,v0),16),1);
+        __m256i w1=_mm256_insertf128_si256(_mm256_castsi128_si256(
+            _mm_srai_epi32(_mm_unpacklo_epi16(v1,v1),16)),_mm_srai_epi32(_mm_unpackhi_epi16(v1,v1),16),1);
+        _mm256_storeu_ps(bus+i,_mm256_add_ps(_mm256_loadu_ps(bus+i),
+            _mm256_mul_ps(_mm256_cvtepi32_ps(w0),gain)));
+        _mm256_storeu_ps(bus+i+8,_mm256_add_ps(_mm256_loadu_ps(bus+i+8),
+            _mm256_mul_ps(_mm256_cvtepi32_ps(w1),gain)));
+    }
+#elif defined(OPENALPP_MIX_SSE2)
+    const __m128 gain=_mm_setr_ps(lgain,rgain,lgain,rgain);
+    for(;i+8<=n;i+=8) {
+        __m128i v=_mm_loadu_si128((const __m128i *)(in+i));
+        __m128 lo=_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v,v),16));
+        __m128 hi=_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v,v),16));
+        _mm_storeu_ps(bus+i,_mm_add_ps(_mm_loadu_ps(bus+i),_mm_mul_ps(lo,gain)));
+        _mm_storeu_ps(bus+i+4,_mm_add_ps(_mm_loadu_ps(bus+i+4),_mm_mul_ps(hi,gain)));
+    }
+#elif defined(OPENALPP_MIX_NEON)
+    const float gains[4]={lgain,rgain,lgain,rgain};
+    const float32x4_t gain=vld1q_f32(gains);
+    for(;i+8<=n;i+=8) {
+        int16x8_t v=vld1q_s16(in+i);
+        float32x4_t lo=vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi=vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(bus+i,vmlaq_f32(vld1q_f32(bus+i),lo,gain));
+        vst1q_f32(bus+i+4,vmlaq_f32(vld1q_f32(bus+i+4),hi,gain));
+    }
+#endif
+    for(;i<n;i+=2) {
+        bus[i]+=in[i]*lgain;
+        bus[i+1]+=in[i+1]*rgain;
+    }
+}
+
+/**
+* Round the bus to 16 bit samples, saturating.
+*/
+static void saturate(ALshort *out,const float *bus,unsigned long n)
+{
+    unsigned long i=0;
+#if defined(OPENALPP_MIX_AVX)
+    const __m256 lo=_mm256_set1_ps(-32768.0f),hi=_mm256_set1_ps(32767.0f);
+    for(;i+8<=n;i+=8) {
+        __m256i v=_mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(bus+i),lo),hi));
+        _mm_storeu_si128((__m128i *)(out+i),
+            _mm_packs_epi32(_mm256_castsi256_si128(v),_mm256_extractf128_si256(v,1)));
+    }
+#elif defined(OPENALPP_MIX_SSE2)
+    // Clamped first, out of range floats convert to 0x80000000
+    const __m128 lo=_mm_set1_ps(-32768.0f),hi=_mm_set1_ps(32767.0f);
+    for(;i+8<=n;i+=8) {
+        __m128i a=_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(bus+i),lo),hi));
+        __m128i b=_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(bus+i+4),lo),hi));
+        _mm_storeu_si128((__m128i *)(out+i),_mm_packs_epi32(a,b));
+    }
+#elif defined(OPENALPP_MIX_NEON)
+    const uint32x4_t sign=vdupq_n_u32(0x80000000);
+    const uint32x4_t half=vreinterpretq_u32_f32(vdupq_n_f32(0.5f));
+    for(;i+4<=n;i+=4) {
+        // Round half away from zero, the conversion truncates and saturates
+        float32x4_t v=vld1q_f32(bus+i);
+        float32x4_t h=vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(v),sign),half));
+        vst1_s16(out+i,vqmovn_s32(vcvtq_s32_f32(vaddq_f32(v,h))));
+    }
+#endif
+    for(;i<n;i++) {
+        float amp=bus[i];
+        if(amp>32767.0f)
+            amp=32767.0f;
+        else if(amp<-32768.0f)
+            amp=-32768.0f;
+        out[i]=(ALshort)(amp<0.0f ? amp-0.5f : amp+0.5f);
+    }
+}
+
 GroupSource::GroupSource(float x,float y,float z) throw (NameError)
-: SourceBase(x,y,z),mixed_(false) {
+: SourceBase(x,y,z),mixed_(false),resampler_(2,1.0,Resampler::Fast) {
     alGenBuffers(1,&buffer_);
     if(alGetError()!=AL_FALSE)
         throw NameError("Error generating buffer name.");
@@ -247,243 +356,192 @@ ALfloat GroupSource::filterDistance(ALuint source,Speaker speaker) {
     return gain;
 }
 
-ALshort *GroupSource::filterReverb(Source *source,ALshort *buffer,
-                                   ALsizei &size,unsigned int frequency) {
-                                       if(!reverbinitiated_)
-                                           return buffer;
-                                       // out=in[i]+scale*in[i-delay]
-                                       ALfloat delay,scale;
-                                       delay=source->getReverbDelay();
-                                       scale=source->getReverbScale();
-                                       if(delay==0.0 || scale==0.0)
-                                           return buffer;
-
-                                       // Modify delay; 2 is for 2 channels (stereo)
-                                       //               frequency*2==#samples
-                                       int idelay=(int)(delay*2.0*(float)frequency*2.0);
-
-                                       ALshort *tbuffer=(ALshort *)realloc(buffer,size+2*idelay*sizeof(ALshort));
-                                       if(!tbuffer)
-                                           throw MemoryError("Out of memory");
-                                       buffer=tbuffer;
-                                       memset(((char *)buffer)+size,0,2*idelay*sizeof(ALshort));
-                                       size+=2*idelay*sizeof(ALshort);
-
-                                       ALint amp;
-                                       for(unsigned int i=idelay;i<(size/sizeof(ALshort));i++) {
-                                           amp=(ALint)buffer[i]+(ALint)(scale*buffer[i-idelay]);
-                                           if(amp>32767)
-                                               amp=32767;
-                                           else if(amp<-32768)
-                                               amp=-32768;
-                                           buffer[i]=(ALshort)amp;
-                                       }
-                                       return buffer;
-}
+GroupSource::MixInput GroupSource::applyFilters(unsigned int s,unsigned int frequency)
+throw (FileError,FatalError) {
+    //  Apply filters: doppler,pitch,{da,reverb,coning,minmax},listenergain
+    //                   -       *     *   *      *      *         -
 
-/**
-* Apply filters to source.
-*/
-ALshort *GroupSource::applyFilters(Source *source,ALshort *buffer,
-                                   ALsizei &size,unsigned int frequency){
-                                       //  Apply filters: doppler,pitch,{da,reverb,coning,minmax},listenergain
-                                       //                   -       *     *   *      *      *         -
+    Source *source=sources_[s].get();
+    const std::vector<ALshort> &pcm=getMixData(source,frequency);
 
-                                       ALuint sourcename=source->getAlSource();
-                                       ALfloat pitch,lgain,rgain;
+    MixInput input;
+    input.pcm=pcm.empty() ? NULL : &pcm[0];
+    input.frames=pcm.size()/2;
+    input.delay=0;
+    input.scale=0.0f;
 
-                                       //Pitch
+    ALuint sourcename=source->getAlSource();
+    ALfloat pitch;
+
+    //Pitch
 #ifndef WIN32
-                                       alGetSourcefv(sourcename,AL_PITCH,&pitch);
+    alGetSourcefv(sourcename,AL_PITCH,&pitch);
 #else
-                                       alGetSourcef(sourcename,AL_PITCH,&pitch);
+    alGetSourcef(sourcename,AL_PITCH,&pitch);
 #endif
-                                       pitch*=FilterDoppler(sourcename);
-
-                                       if(pitch>0.0) {
-                                           ALsizei nsize=(ALsizei)(size/pitch);
-                                           ALshort *nbuffer=(ALshort *)malloc(nsize);
-                                           ALfloat index=0.0;
-                                           for(unsigned int i=0;i<(nsize/(2*sizeof(ALshort)));i++) {
-                                               if(index*2>(size/sizeof(ALshort)))
-                                               {
-                                                   free(nbuffer);
-                                                   throw FatalError("index>size - we're all doomed!");
-                                               }
-                                               int iindex=(int)index;
-                                               float fracindex=index-(float)iindex;
-                                               unsigned int destl=i*2,destr=i*2+1;
-                                               unsigned int sourcel=iindex*2,sourcer=iindex*2+1;
-
-                                               // Left channel
-                                               nbuffer[destl]=buffer[sourcel];
-                                               if((sourcel+2)<(size/sizeof(ALshort)))
-                                                   nbuffer[destl]+=(ALshort)fracindex*(buffer[sourcel+2]-
-                                                   buffer[sourcel]);
-
-                                               // Right channel
-                                               nbuffer[destr]=buffer[sourcer];
-                                               if((sourcer+2)<(size/sizeof(ALshort)))
-                                                   nbuffer[destr]+=(ALshort)fracindex*(buffer[sourcer+2]-
-                                                   buffer[sourcer]);
-                                               index+=pitch;
-                                           }
-                                           free(buffer);
-                                           buffer=nbuffer;
-                                           size=nsize;
-                                       }
-
-                                       lgain=filterDistance(sourcename,Left);
-                                       rgain=filterDistance(sourcename,Right);
-                                       buffer=filterReverb(source,buffer,size,frequency);
-                                       ALfloat min,max;                          // minmax filter
+    pitch*=FilterDoppler(sourcename);
+
+    if(pitch>0.0 && pitch!=1.0 && input.frames) {
+        // Windowed-sinc, so that raising the pitch doesn't alias
+        std::vector<ALshort> &pitched=pitched_[s];
+        resampler_.setRatio(pitch);
+        resampler_.convert(input.pcm,input.frames,pitched);
+        input.pcm=pitched.empty() ? NULL : &pitched[0];
+        input.frames=pitched.size()/2;
+    }
+
+    input.lgain=filterDistance(sourcename,Left);
+    input.rgain=filterDistance(sourcename,Right);
+
+    // Reverb, out[i]=in[i]+scale*out[i-delay]
+    if(reverbinitiated_) {
+        ALfloat delay=source->getReverbDelay();
+        ALfloat scale=source->getReverbScale();
+        // 2 is for 2 channels (stereo), frequency*2==#samples
+        int idelay=(int)(delay*2.0*(float)frequency*2.0);
+        if(idelay>0 && scale!=0.0) {
+            input.delay=idelay;
+            input.scale=scale;
+        }
+    }
+
+    ALfloat min,max;                          // minmax filter
 #ifndef WIN32
-                                       alGetSourcefv(sourcename,AL_MIN_GAIN,&min);
-                                       alGetSourcefv(sourcename,AL_MAX_GAIN,&max);
+    alGetSourcefv(sourcename,AL_MIN_GAIN,&min);
+    alGetSourcefv(sourcename,AL_MAX_GAIN,&max);
 #else
-                                       alGetSourcef(sourcename,AL_MIN_GAIN,&min);
-                                       alGetSourcef(sourcename,AL_MAX_GAIN,&max);
+    alGetSourcef(sourcename,AL_MIN_GAIN,&min);
+    alGetSourcef(sourcename,AL_MAX_GAIN,&max);
 #endif
 
-                                       if(lgain<min)
-                                           lgain=min;
-                                       else if(lgain>max)
-                                           lgain=max;
-                                       if(rgain<min)
-                                           rgain=min;
-                                       else if(rgain>max)
-                                           rgain=max;
-
-                                       for(unsigned int i=0;i<(size/sizeof(ALshort));i++) {
-                                           if(i%2)
-                                               buffer[i]=(ALshort)(buffer[i]*rgain);
-                                           else
-                                               buffer[i]=(ALshort)(buffer[i]*lgain);
-                                       }
-                                       return buffer;
+    if(input.lgain<min)
+        input.lgain=min;
+    else if(input.lgain>max)
+        input.lgain=max;
+    if(input.rgain<min)
+        input.rgain=min;
+    else if(input.rgain>max)
+        input.rgain=max;
+
+    return input;
 }
 
-void GroupSource::mixSources(unsigned int frequency)
-throw (InitError,FileError,FatalError,MemoryError,ValueError) {
-    ALsizei bsize=0,size=0,loadsize=0;
-    ALenum format;
-    ALboolean success;
-    AudioConvert converter(AL_FORMAT_STEREO16,frequency);
+void GroupSource::mixReverb(const MixInput &input) {
+    // The echoes ring on for delay samples after the sound
+    const unsigned long n=input.frames*2;
+    const unsigned long total=n+2*input.delay;
+    reverb_.resize(total);
+    float *out=&reverb_[0];
+    float *bus=&bus_[0];
+    for(unsigned long i=0;i<total;i++) {
+        float amp=i<n ? (float)input.pcm[i] : 0.0f;
+        if(i>=input.delay)
+            amp+=input.scale*out[i-input.delay];
+        out[i]=amp;
+        bus[i]+=amp*((i&1) ? input.rgain : input.lgain);
+    }
+}
 
-    if(sources_.size()<1)
-        throw InitError("Sources must be included before trying to mix");
+void GroupSource::capture(Source *source,const DataBlock *file) throw (FileError) {
+    const SoundData *sound=source->getSound();
+    for(unsigned int i=0;i<mixdata_.size();i++)
+        if(mixdata_[i].sound.get()==sound)
+            return;
 
-    std::cerr << ((Sample *)sources_[0]->getSound())->getFileName() << "\n";
+    const Sample *sample=dynamic_cast<const Sample *>(sound);
+    if(!sample)
+        throw FileError("Only sources playing samples can be mixed");
+
+    MixData entry;
+    entry.sound=sound;
+    entry.frequency=0;
+    if(file)
+        Sample::decodeFile(file,entry.decoded,entry.format,entry.rate);
+    else
+        sample->getPCM(entry.decoded,entry.format,entry.rate);
+    if(entry.decoded.empty())
+        throw FileError("No sound to mix");
+
+    mixdata_.push_back(MixData());
+    MixData &added=mixdata_.back();
+    added.sound=entry.sound;
+    added.decoded.swap(entry.decoded);
+    added.format=entry.format;
+    added.rate=entry.rate;
+    added.frequency=0;
+}
 
-#if OPENAL_VERSION < 2006
-    ALshort *loaddata=NULL,*data=NULL,*bdata=NULL;
-    ALsizei bits;
-    ALsizei freq;
-    success=
-        alutLoadWAV(((Sample *)sources_[0]->getSound())->getFileName().c_str(),
-        (ALvoid **)&loaddata,&format,&loadsize,&bits,&freq);
-#else
-#if OPENAL_VERSION < 2007
-    ALshort *loaddata=NULL,*data=NULL,*bdata=NULL;
-    ALsizei bits;
-    ALsizei freq;
-    ALboolean loop;
-    alutLoadWAVFile((ALbyte*)((Sample *)sources_[0]->getSound())->getFileName().c_str(),
-        &format,(ALvoid **)&loaddata,&loadsize,&freq,&loop);
-    if (loaddata)
-        success=AL_TRUE;
-    else 
-        success=AL_FALSE;
-#else
-    ALvoid *loaddata=NULL;
-    ALshort* data=NULL,*bdata=NULL;
-    ALfloat freq;
-    loaddata = alutLoadMemoryFromFile(((Sample *)sources_[0]->getSound())->getFileName().c_str(),
-        &format,
-        &loadsize,
-        &freq);
-    success = AL_FALSE;
-    if (loaddata)
-        success = AL_TRUE;
-#endif
-#endif
-    if(success==AL_FALSE || !loaddata)
-        throw FileError("Error opening file for mixing");
+const std::vector<ALshort> &GroupSource::getMixData(Source *source,unsigned int frequency)
+throw (FileError,FatalError) {
+    // Decoded when the source was included, unless its sound changed since
+    capture(source,NULL);
 
-    bsize=loadsize;
-    unsigned int tsize=(unsigned int)bsize;
-    bdata=(ALshort *)converter.apply((void*)loaddata,format,
-        (unsigned int)freq,tsize);
-    bsize=tsize;
+    const SoundData *sound=source->getSound();
+    MixData *entry=NULL;
+    for(unsigned int i=0;i<mixdata_.size() && !entry;i++)
+        if(mixdata_[i].sound.get()==sound)
+            entry=&mixdata_[i];
+    if(entry->frequency==frequency)
+        return entry->pcm;
 
-    if(!bdata)
+    // Not converted yet, or for another mixing frequency
+    AudioConvert converter(AL_FORMAT_STEREO16,frequency);
+    unsigned int size=(unsigned int)entry->decoded.size();
+    ALshort *data=(ALshort *)converter.apply(&entry->decoded[0],entry->format,entry->rate,size);
+    if(!data)
         throw FatalError("Error converting data to internal format!");
 
-    free(loaddata);
+    entry->frequency=frequency;
+    entry->pcm.assign(data,data+size/sizeof(ALshort));
+    free(data);
+
+    return entry->pcm;
+}
 
-    bdata=applyFilters(sources_[0].get(),bdata,bsize,frequency);
+void GroupSource::mixSources(unsigned int frequency)
+throw (InitError,FileError,FatalError,MemoryError,ValueError) {
+    if(sources_.size()<1)
+        throw InitError("Sources must be included before trying to mix");
 
-    for(unsigned int s=1;s<sources_.size();s++) {
-#if OPENAL_VERSION < 2006
-        success=
-            alutLoadWAV(((Sample *)sources_[s]->getSound())->getFileName().c_str(),
-            (ALvoid **)&loaddata,&format,&loadsize,&bits,&freq);
-#else
-#if OPENAL_VERSION < 2007
-        alutLoadWAVFile((ALbyte*)((Sample *)sources_[s]->getSound())->getFileName().c_str(),
-            &format,(ALvoid **)&loaddata,&loadsize,&freq,&loop);
-        if (loaddata)
-            success=AL_TRUE;
-        else
-            success=AL_FALSE;
-#else
-        loaddata = alutLoadMemoryFromFile(((Sample *)sources_[s]->getSound())->getFileName().c_str(),
-            &format,
-            &loadsize,
-            &freq);
-        success = AL_FALSE;
-        if (loaddata)
-            success = AL_TRUE;
-#endif
-#endif
-        if(success==AL_FALSE || !loaddata)
-            throw FileError("Error opening file for mixing");
-
-        size=loadsize;
-        unsigned int tsize2=(unsigned int)size;
-        data=(ALshort *)converter.apply(loaddata,format,
-            (unsigned int)freq,tsize2);
-        size=tsize2;
-
-        if(!data)
-            throw FatalError("Error converting data to internal format!");
-
-        free(loaddata);
-
-        data=applyFilters(sources_[s].get(),data,size,frequency);
-
-        if(size>bsize) {
-            loaddata=bdata;
-            bdata=data;
-            data=(ALshort*)(loaddata);
-            loadsize=bsize;
-            bsize=size;
-            size=loadsize;
-        } 
-        ALint amp;
-        for(ALsizei i=0;i<(size/2);i++) {
-            amp=bdata[i]+data[i];
-            if(amp>32767)
-                amp=32767;
-            else if(amp<-32768)
-                amp=-32768;
-            bdata[i]=(ALshort)amp;
-        }
+    // Load what hasn't been yet first, the filtered inputs point into mixdata_
+    for(unsigned int s=0;s<sources_.size();s++)
+        getMixData(sources_[s].get(),frequency);
+
+    pitched_.resize(sources_.size());
+    inputs_.clear();
+    unsigned long samples=0;
+    for(unsigned int s=0;s<sources_.size();s++) {
+        inputs_.push_back(applyFilters(s,frequency));
+        const MixInput &input=inputs_.back();
+        samples=std::max(samples,input.frames*2+(input.scale!=0.0f ? 2*input.delay : 0));
+    }
 
-        free(data);
+    bus_.assign(samples,0.0f);
+    output_.resize(samples);
+
+    // Reverb feeds back on the sound of its source, so each one is added on its own
+    for(unsigned int s=0;s<inputs_.size();s++)
+        if(inputs_[s].scale!=0.0f)
+            mixReverb(inputs_[s]);
+
+    // All other sources block by block, so that a block of the bus stays in
+    // the cache until it is complete and converted
+    const unsigned long frames=samples/2;
+    for(unsigned long start=0;start<frames;start+=MIX_BLOCK) {
+        const unsigned long end=std::min(start+MIX_BLOCK,frames);
+        float *bus=&bus_[start*2];
+        for(unsigned int s=0;s<inputs_.size();s++) {
+            const MixInput &input=inputs_[s];
+            if(input.scale!=0.0f || input.frames<=start)
+                continue;
+            mixStereo(bus,input.pcm+start*2,std::min(end,input.frames)-start,
+                input.lgain,input.rgain);
+        }
+        saturate(&output_[start*2],bus,(end-start)*2);
     }
 
-    alBufferData(buffer_,AL_FORMAT_STEREO16,bdata,bsize,frequency);
+    alBufferData(buffer_,AL_FORMAT_STEREO16,output_.empty() ? NULL : &output_[0],
+        (ALsizei)(output_.size()*sizeof(ALshort)),frequency);
     ALenum error=alGetError();
     if(error==AL_OUT_OF_MEMORY)
         throw MemoryError("Error buffering data");
@@ -493,12 +551,16 @@ throw (InitError,FileError,FatalError,MemoryError,ValueError) {
         throw FatalError((const char *)alGetString(error));
 
     mixed_=true;  
-    free(bdata);
 }
 
-ALuint GroupSource::includeSource(Source *source) throw (ValueError) {
+ALuint GroupSource::includeSource(Source *source) throw (ValueError,FileError) {
+    return includeSource(source,NULL);
+}
+
+ALuint GroupSource::includeSource(Source *source,const DataBlock *file) throw (ValueError,FileError) {
     if(source->isStreaming())
         throw ValueError("Can't include streaming sources in group.");
+    capture(source,file);
     sources_.push_back(source);
     return source->getAlSource();
 }
@@ -513,14 +575,35 @@ void GroupSource::excludeSource(ALuint sourcename) throw (NameError) {
         if(sourcename==sources_[i]->getAlSource()) {
             sources_[i]=sources_[sources_.size()-1];
             sources_.pop_back();
+
+            // Forget the sounds no remaining source plays
+            for(unsigned int m=0;m<mixdata_.size();) {
+                bool used=false;
+                for(unsigned int s=0;s<sources_.size() && !used;s++)
+                    used=sources_[s]->getSound()==mixdata_[m].sound.get();
+                if(used) {
+                    m++;
+                } else {
+                    MixData &last=mixdata_.back();
+                    mixdata_[m].sound=last.sound;
+                    mixdata_[m].decoded.swap(last.decoded);
+                    mixdata_[m].format=last.format;
+                    mixdata_[m].rate=last.rate;
+                    mixdata_[m].frequency=last.frequency;
+                    mixdata_[m].pcm.swap(last.pcm);
+                    mixdata_.pop_back();
+                }
+            }
             return;
         }
     }
     throw NameError("Trying to exclude source that has not been included.");
 }
 
-GroupSource::GroupSource(const GroupSource &groupsource) : SourceBase(groupsource) {
+GroupSource::GroupSource(const GroupSource &groupsource)
+: SourceBase(groupsource),resampler_(2,1.0,Resampler::Fast) {
     sources_=groupsource.sources_;
+    mixdata_=groupsource.mixdata_;
     mixed_=false;
     alGenBuffers(1,&buffer_);
     if(alGetError()!=AL_FALSE)
@@ -536,6 +619,7 @@ GroupSource &GroupSource::operator=(const GroupSource &groupsource) {
     if(this!=&groupsource) {
         sources_.clear();
         sources_=groupsource.sources_;
+        mixdata_=groupsource.mixdata_;
         mixed_=false;
     }
     return *this;
@@ -0,0 +1,126 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <openalpp/MappedFile.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace openalpp;
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &filename) throw (FileError)
+: file_(INVALID_HANDLE_VALUE), mapping_(0L)
+{
+    file_ = CreateFileA(filename.c_str(),GENERIC_READ,FILE_SHARE_READ,NULL,
+        OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+    if(file_==INVALID_HANDLE_VALUE)
+        throw FileError("MappedFile: Couldn't open file: " + filename);
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file_,&size) || !size.QuadPart) {
+        CloseHandle(file_);
+        throw FileError("MappedFile: Couldn't map empty file: " + filename);
+    }
+    size_ = (size_t)size.QuadPart;
+
+    mapping_ = CreateFileMapping(file_,NULL,PAGE_READONLY,0,0,NULL);
+    if(mapping_)
+        data_ = (const char *)MapViewOfFile(mapping_,FILE_MAP_READ,0,0,0);
+    if(!data_) {
+        if(mapping_)
+            CloseHandle(mapping_);
+        CloseHandle(file_);
+        throw FileError("MappedFile: Couldn't map file: " + filename);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+}
+
+void MappedFile::willNeed(size_t,size_t) const
+{
+    // FILE_FLAG_SEQUENTIAL_SCAN already has the cache manager read ahead
+}
+
+#else // _WIN32
+
+MappedFile::MappedFile(const std::string &filename) throw (FileError)
+{
+    int fd = open(filename.c_str(),O_RDONLY);
+    if(fd<0)
+        throw FileError("MappedFile: Couldn't open file: " + filename);
+
+    struct stat st;
+    if(fstat(fd,&st) || !st.st_size) {
+        close(fd);
+        throw FileError("MappedFile: Couldn't map empty file: " + filename);
+    }
+    size_ = (size_t)st.st_size;
+
+    void *data = mmap(0L,size_,PROT_READ,MAP_SHARED,fd,0);
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+
+    if(data==MAP_FAILED)
+        throw FileError("MappedFile: Couldn't map file: " + filename);
+    data_ = (const char *)data;
+
+    madvise(data,size_,MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+    munmap((void *)data_,size_);
+}
+
+void MappedFile::willNeed(size_t offset,size_t length) const
+{
+    if(offset>=size_)
+        return;
+    if(length>size_-offset)
+        length = size_-offset;
+
+    // madvise() wants a page aligned address
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset - offset%page;
+    madvise((void *)(data_+start),length+(offset-start),MADV_WILLNEED);
+}
+
+#endif // _WIN32
@@ -27,7 +27,17 @@
 
 namespace openalpp {
 
-FileStream::FileStream(const std::string& ,const int)
+FileStream::FileStream(const std::string& ,const int,unsigned int,float,unsigned int)
+  throw (NameError,InitError,FileError) : Stream() {
+  throw InitError("No support for streaming from files compiled in.");
+}
+
+FileStream::FileStream(DataBlock *,const int,unsigned int,float,unsigned int)
+  throw (NameError,InitError,FileError) : Stream() {
+  throw InitError("No support for streaming from files compiled in.");
+}
+
+FileStream::FileStream(std::istream &,const int,unsigned int,float,unsigned int)
   throw (NameError,InitError,FileError) : Stream() {
   throw InitError("No support for streaming from files compiled in.");
 }
@@ -46,4 +56,19 @@ FileStream &FileStream::operator=(const FileStream &/*stream*/) {
 void FileStream::setLooping(bool) {
 }
 
+void FileStream::setLoopPoints(unsigned int,unsigned int) {
+}
+
+bool FileStream::createCursor(Cursor &) {
+  return false;
+}
+
+unsigned int FileStream::getLoopStart() const {
+  return 0;
+}
+
+unsigned int FileStream::getLoopEnd() const {
+  return 0;
+}
+
 }
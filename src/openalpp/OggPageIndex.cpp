@@ -0,0 +1,134 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <map>
+
+#include <osg/observer_ptr>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
+#include <openalpp/OggPageIndex.h>
+
+using namespace openalpp;
+
+
+namespace {
+
+    unsigned int readLE32(const unsigned char *p)
+    {
+        return p[0] | (p[1]<<8) | (p[2]<<16) | ((unsigned int)p[3]<<24);
+    }
+
+    ogg_int64_t readLE64(const unsigned char *p)
+    {
+        return (ogg_int64_t)readLE32(p) | ((ogg_int64_t)readLE32(p+4)<<32);
+    }
+
+    typedef std::map<std::string,osg::observer_ptr<OggPageIndex> > IndexCache;
+
+    OpenThreads::Mutex s_cacheMutex;
+    IndexCache s_cache;
+
+}
+
+OggPageIndex::OggPageIndex(const DataBlock *block) : size_(block ? block->size() : 0)
+{
+    if(!block)
+        return;
+
+    const unsigned char *data = (const unsigned char *)block->data();
+    const size_t size = block->size();
+
+    bool first = true;
+    unsigned int serial = 0;
+
+    size_t offset = 0;
+    while(offset+27<=size) {
+        const unsigned char *page = data+offset;
+
+        // Capture pattern, then version 0
+        if(page[0]!='O' || page[1]!='g' || page[2]!='g' || page[3]!='S' || page[4]!=0) {
+            // Lost sync, look for the next page
+            offset++;
+            continue;
+        }
+
+        unsigned int nsegments = page[26];
+        if(offset+27+nsegments>size)
+            break;
+
+        size_t length = 27+nsegments;
+        for(unsigned int i=0;i<nsegments;i++)
+            length += page[27+i];
+        if(offset+length>size)
+            break;
+
+        unsigned int pageserial = readLE32(page+14);
+        if(first) {
+            serial = pageserial;
+            first = false;
+        }
+
+        // Pages without a finished packet have a granule position of -1
+        ogg_int64_t granule = readLE64(page+6);
+        if(pageserial==serial && granule!=-1) {
+            Page p;
+            p.granule = granule;
+            p.offset = offset;
+            pages_.push_back(p);
+        }
+
+        offset += length;
+    }
+}
+
+OggPageIndex *OggPageIndex::get(const std::string &filename,const DataBlock *block)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_cacheMutex);
+
+    osg::ref_ptr<OggPageIndex> index;
+    IndexCache::iterator it = s_cache.find(filename);
+    if(it!=s_cache.end() && it->second.lock(index) && index->size_==block->size())
+        return index.release();
+
+    index = new OggPageIndex(block);
+    s_cache[filename] = index.get();
+    return index.release();
+}
+
+ogg_int64_t OggPageIndex::findPage(ogg_int64_t sample) const
+{
+    // Binary search for the last page ending before the sample
+    unsigned int lo = 0, hi = pages_.size();
+    while(lo<hi) {
+        unsigned int mid = (lo+hi)/2;
+        if(pages_[mid].granule<sample)
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+
+    return lo ? pages_[lo-1].offset : 0;
+}
@@ -0,0 +1,119 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef OPENALPP_HAVE_OPUS
+
+#include <cstring>
+
+#include <opusfile.h>
+
+#include <openalpp/OpusDecoder.h>
+
+using namespace openalpp;
+
+namespace {
+
+    /**
+    * Decoder of an Ogg Opus file in memory.
+    */
+    class OpusDecoder : public StreamDecoder {
+    public:
+        OpusDecoder(const DataBlock *block);
+
+        bool valid() const { return opusfile_!=0L; }
+
+        long read(char *buffer,unsigned int length);
+        bool seek(unsigned long frame);
+        std::string getTag(const std::string &name);
+
+    protected:
+        virtual ~OpusDecoder();
+
+        osg::ref_ptr<const DataBlock> block_;   // opusfile reads straight from the block
+        OggOpusFile *opusfile_;
+    };
+
+}
+
+bool OpusDecoderFactory::probe(const char *data,size_t size) const {
+    // The first page holds the identification header, after the segment table
+    if(size<28 || memcmp(data,"OggS",4))
+        return false;
+    const size_t header=27+(unsigned char)data[26];
+    return size>=header+8 && !memcmp(data+header,"OpusHead",8);
+}
+
+StreamDecoder *OpusDecoderFactory::open(const DataBlock *block,const std::string &) {
+    osg::ref_ptr<OpusDecoder> decoder=new OpusDecoder(block);
+    if(!decoder->valid())
+        return NULL;
+    return decoder.release();
+}
+
+OpusDecoder::OpusDecoder(const DataBlock *block)
+: StreamDecoder(), block_(block), opusfile_(0L) {
+    int error=0;
+    opusfile_=op_open_memory((const unsigned char *)block->data(),block->size(),&error);
+    if(!opusfile_)
+        return;
+
+    channels_=op_channel_count(opusfile_,-1);
+    frequency_=48000;
+    ogg_int64_t frames=op_pcm_total(opusfile_,-1);
+    frames_=frames>0 ? (unsigned long)frames : 0;
+}
+
+OpusDecoder::~OpusDecoder() {
+    if(opusfile_)
+        op_free(opusfile_);
+}
+
+long OpusDecoder::read(char *buffer,unsigned int length) {
+    // op_read counts in samples per channel, and may return less than asked
+    const unsigned int frameSize=channels_*2;
+    unsigned int count=0;
+    while(count+frameSize<=length) {
+        int amt=op_read(opusfile_,(opus_int16 *)(buffer+count),(length-count)/2,NULL);
+        if(amt==OP_HOLE)    // A gap in the data, carry on
+            continue;
+        if(amt<0)
+            return count ? (long)count : amt;
+        if(amt==0)
+            break;
+        count+=amt*frameSize;
+    }
+    return (long)count;
+}
+
+bool OpusDecoder::seek(unsigned long frame) {
+    return op_pcm_seek(opusfile_,frame)==0;
+}
+
+std::string OpusDecoder::getTag(const std::string &name) {
+    const char *value=opus_tags_query(op_tags(opusfile_,-1),name.c_str(),0);
+    return value ? std::string(value) : std::string();
+}
+
+#endif // OPENALPP_HAVE_OPUS
@@ -0,0 +1,77 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <cstddef>
+
+#include <openalpp/PCMRing.h>
+
+using namespace openalpp;
+
+
+PCMRing::PCMRing(unsigned int blocks) : mask_(0)
+{
+    resize(blocks);
+}
+
+void PCMRing::resize(unsigned int blocks)
+{
+    unsigned int n = 0;
+    if(blocks) {
+        n = 1;
+        while(n<blocks)
+            n <<= 1;
+    }
+
+    blocks_.clear();
+    blocks_.resize(n);
+    mask_ = n ? n-1 : 0;
+    write_.exchange(0);
+    read_.exchange(0);
+}
+
+PCMRing::Block *PCMRing::back()
+{
+    if(!capacity() || full())
+        return NULL;
+    return &blocks_[(unsigned int)write_ & mask_];
+}
+
+void PCMRing::push()
+{
+    // The atomic increment publishes the data written to the block
+    ++write_;
+}
+
+const PCMRing::Block *PCMRing::front() const
+{
+    if(empty())
+        return NULL;
+    return &blocks_[(unsigned int)read_ & mask_];
+}
+
+void PCMRing::pop()
+{
+    ++read_;
+}
@@ -0,0 +1,291 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <cmath>
+
+#include <openalpp/Resampler.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define OPENALPP_RESAMPLER_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define OPENALPP_RESAMPLER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OPENALPP_RESAMPLER_NEON
+#endif
+
+using namespace openalpp;
+
+static const double PI=3.14159265358979323846;
+
+/**
+* Filter one output sample: the input times the coefficients of a phase,
+* interpolated towards the next phase by frac.
+* @param taps is a multiple of 8.
+*/
+static inline float filterSample(const float *in,const float *coeff,const float *delta,
+                                 float frac,unsigned int taps)
+{
+#if defined(OPENALPP_RESAMPLER_AVX)
+    const __m256 f=_mm256_set1_ps(frac);
+    __m256 sum=_mm256_setzero_ps();
+    for(unsigned int i=0;i<taps;i+=8) {
+        __m256 c=_mm256_add_ps(_mm256_loadu_ps(coeff+i),_mm256_mul_ps(f,_mm256_loadu_ps(delta+i)));
+        sum=_mm256_add_ps(sum,_mm256_mul_ps(_mm256_loadu_ps(in+i),c));
+    }
+    __m128 s=_mm_add_ps(_mm256_castps256_ps128(sum),_mm256_extractf128_ps(sum,1));
+    s=_mm_add_ps(s,_mm_movehl_ps(s,s));
+    s=_mm_add_ss(s,_mm_shuffle_ps(s,s,1));
+    return _mm_cvtss_f32(s);
+#elif defined(OPENALPP_RESAMPLER_SSE2)
+    const __m128 f=_mm_set1_ps(frac);
+    __m128 sum0=_mm_setzero_ps(),sum1=_mm_setzero_ps();
+    for(unsigned int i=0;i<taps;i+=8) {
+        __m128 c0=_mm_add_ps(_mm_loadu_ps(coeff+i),_mm_mul_ps(f,_mm_loadu_ps(delta+i)));
+        __m128 c1=_mm_add_ps(_mm_loadu_ps(coeff+i+4),_mm_mul_ps(f,_mm_loadu_ps(delta+i+4)));
+        sum0=_mm_add_ps(sum0,_mm_mul_ps(_mm_loadu_ps(in+i),c0));
+        sum1=_mm_add_ps(sum1,_mm_mul_ps(_mm_loadu_ps(in+i+4),c1));
+    }
+    __m128 s=_mm_add_ps(sum0,sum1);
+    s=_mm_add_ps(s,_mm_movehl_ps(s,s));
+    s=_mm_add_ss(s,_mm_shuffle_ps(s,s,1));
+    return _mm_cvtss_f32(s);
+#elif defined(OPENALPP_RESAMPLER_NEON)
+    const float32x4_t f=vdupq_n_f32(frac);
+    float32x4_t sum0=vdupq_n_f32(0.0f),sum1=vdupq_n_f32(0.0f);
+    for(unsigned int i=0;i<taps;i+=8) {
+        float32x4_t c0=vmlaq_f32(vld1q_f32(coeff+i),f,vld1q_f32(delta+i));
+        float32x4_t c1=vmlaq_f32(vld1q_f32(coeff+i+4),f,vld1q_f32(delta+i+4));
+        sum0=vmlaq_f32(sum0,vld1q_f32(in+i),c0);
+        sum1=vmlaq_f32(sum1,vld1q_f32(in+i+4),c1);
+    }
+    float32x4_t s4=vaddq_f32(sum0,sum1);
+    float32x2_t s=vadd_f32(vget_low_f32(s4),vget_high_f32(s4));
+    return vget_lane_f32(vpadd_f32(s,s),0);
+#else
+    float sum=0.0f;
+    for(unsigned int i=0;i<taps;i++)
+        sum+=in[i]*(coeff[i]+frac*delta[i]);
+    return sum;
+#endif
+}
+
+/**
+* Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+*/
+static double besselI0(double x)
+{
+    double sum=1.0,term=1.0;
+    for(int k=1;k<50 && term>sum*1e-12;k++) {
+        term*=(x/(2.0*k))*(x/(2.0*k));
+        sum+=term;
+    }
+    return sum;
+}
+
+/**
+* Taps, phases, Kaiser beta and passband of the quality presets.
+*/
+static void getPreset(Resampler::Quality quality,unsigned int &taps,unsigned int &phases,
+                      double &beta,double &rolloff)
+{
+    switch(quality) {
+    case Resampler::Fast:
+        taps=8; phases=128; beta=6.0; rolloff=0.85;
+        break;
+    case Resampler::Best:
+        taps=32; phases=512; beta=10.0; rolloff=0.96;
+        break;
+    default:
+        taps=16; phases=256; beta=8.0; rolloff=0.92;
+        break;
+    }
+}
+
+static inline short clampSample(float value)
+{
+    if(value>=32767.0f)
+        return 32767;
+    if(value<=-32768.0f)
+        return -32768;
+    return (short)(value<0.0f ? value-0.5f : value+0.5f);
+}
+
+
+Resampler::Resampler(unsigned int channels,double ratio,Quality quality)
+: channels_(channels ? channels : 1), quality_(quality), ratio_(1.0), cutoff_(0.0),
+history_(channels_)
+{
+    setRatio(ratio);
+    reset();
+}
+
+void Resampler::setRatio(double ratio)
+{
+    if(ratio<0.001)
+        ratio=0.001;
+    ratio_=ratio;
+
+    unsigned int taps,phases;
+    double beta,rolloff;
+    getPreset(quality_,taps,phases,beta,rolloff);
+
+    // Lowering the rate moves the cutoff down with the new Nyquist frequency
+    double cutoff=rolloff*(ratio>1.0 ? 1.0/ratio : 1.0);
+    if(table_.empty() || fabs(cutoff-cutoff_)>cutoff_*0.01) {
+        cutoff_=cutoff;
+        buildTable();
+    }
+}
+
+void Resampler::buildTable()
+{
+    double beta,rolloff;
+    getPreset(quality_,taps_,phases_,beta,rolloff);
+
+    const double half=taps_/2;
+    const double norm=besselI0(beta);
+    std::vector<double> rows((phases_+1)*taps_);
+    for(unsigned int p=0;p<=phases_;p++) {
+        double *row=&rows[p*taps_];
+        double sum=0.0;
+        for(unsigned int k=0;k<taps_;k++) {
+            // Distance from the output position to input tap k
+            double d=(double)p/phases_+half-1.0-k;
+            double x=d/half;
+            double window=x*x<1.0 ? besselI0(beta*sqrt(1.0-x*x))/norm : 0.0;
+            double sinc=d==0.0 ? 1.0 : sin(PI*cutoff_*d)/(PI*cutoff_*d);
+            row[k]=cutoff_*sinc*window;
+            sum+=row[k];
+        }
+        // Unity gain at DC for every phase
+        if(sum!=0.0)
+            for(unsigned int k=0;k<taps_;k++)
+                row[k]/=sum;
+    }
+
+    table_.resize(phases_*2*taps_);
+    for(unsigned int p=0;p<phases_;p++)
+        for(unsigned int k=0;k<taps_;k++) {
+            table_[p*2*taps_+k]=(float)rows[p*taps_+k];
+            table_[p*2*taps_+taps_+k]=(float)(rows[(p+1)*taps_+k]-rows[p*taps_+k]);
+        }
+}
+
+unsigned long Resampler::getMaxOutput(unsigned long frames) const
+{
+    double available=(double)history_[0].size()+frames-position_;
+    if(available<0.0)
+        return 0;
+    return (unsigned long)(available/ratio_)+2;
+}
+
+void Resampler::reset()
+{
+    // Zeros before the first frame, so that the output isn't delayed
+    for(unsigned int c=0;c<channels_;c++)
+        history_[c].assign(taps_/2-1,0.0f);
+    position_=taps_/2-1;
+}
+
+unsigned long Resampler::produce(short *out,unsigned long maxframes,double end)
+{
+    const size_t size=history_[0].size();
+    unsigned long n=0;
+    while(n<maxframes && position_<end) {
+        const size_t i=(size_t)position_;
+        if(i+taps_/2>=size)
+            break;
+
+        const double phase=(position_-i)*phases_;
+        const unsigned int p=(unsigned int)phase;
+        const float frac=(float)(phase-p);
+        const float *coeff=&table_[p*2*taps_];
+        const size_t start=i+1-taps_/2;
+
+        for(unsigned int c=0;c<channels_;c++)
+            out[n*channels_+c]=clampSample(filterSample(&history_[c][start],coeff,coeff+taps_,frac,taps_));
+
+        position_+=ratio_;
+        n++;
+    }
+
+    // Drop the input that no output needs any more
+    const size_t next=(size_t)position_;
+    if(next+1>taps_/2) {
+        size_t used=next+1-taps_/2;
+        if(used>size)
+            used=size;
+        for(unsigned int c=0;c<channels_;c++)
+            history_[c].erase(history_[c].begin(),history_[c].begin()+used);
+        position_-=used;
+    }
+    return n;
+}
+
+unsigned long Resampler::process(const short *in,unsigned long frames,short *out,unsigned long maxframes)
+{
+    for(unsigned int c=0;c<channels_;c++) {
+        std::vector<float> &history=history_[c];
+        const size_t size=history.size();
+        history.resize(size+frames);
+        for(unsigned long i=0;i<frames;i++)
+            history[size+i]=in[i*channels_+c];
+    }
+    return produce(out,maxframes,1e300);
+}
+
+unsigned long Resampler::flush(short *out,unsigned long maxframes)
+{
+    // The input ends here, pad it with silence for the last taps.
+    // The margin keeps rounding of position_ from adding a frame.
+    const double end=(double)history_[0].size()-1e-6;
+    for(unsigned int c=0;c<channels_;c++)
+        history_[c].resize(history_[c].size()+taps_/2,0.0f);
+    unsigned long n=produce(out,maxframes,end);
+    reset();
+    return n;
+}
+
+void Resampler::convert(const short *in,unsigned long frames,std::vector<short> &out)
+{
+    reset();
+    out.resize((getMaxOutput(frames)+taps_)*channels_);
+    if(out.empty())
+        return;
+
+    unsigned long n=process(in,frames,&out[0],out.size()/channels_);
+    n+=flush(&out[n*channels_],out.size()/channels_-n);
+    out.resize(n*channels_);
+}
+
+void Resampler::resample(const short *in,unsigned long frames,unsigned int channels,
+                         double ratio,std::vector<short> &out,Quality quality)
+{
+    Resampler resampler(channels,ratio,quality);
+    resampler.convert(in,frames,out);
+}
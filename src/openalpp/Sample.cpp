@@ -23,63 +23,292 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <algorithm>
 #include <sstream>
+#include <fstream>
+#include <vector>
+#include <cstring>
 
 #include <openalpp/Sample.h>
+#include <openalpp/MappedFile.h>
+#include <openalpp/StreamDecoder.h>
+#include <openalpp/WaveDecoder.h>
+#include <openalpp/AudioConvert.h>
 #include <openalpp/windowsstuff.h>
 
 #include <AL/alut.h>
 
 using namespace openalpp;
 
+// The WAV decoder of AudioConvert.cpp, for ADPCM files
+void *acLoadWAV(void *data, ALuint *size, void **udata, 
+                ALushort *fmt, ALubyte *chan, ALushort *freq);
+
+/**
+* @return true if a file (starting with data) is decoded by a StreamDecoder.
+*/
+static bool isDecodedFile(const char *data,size_t size) {
+    return StreamDecoderRegistry::instance()->canDecode(data,size);
+}
+
+/**
+* @return true if a file (starting with data) is a WAV file.
+*/
+static bool isWaveFile(const char *data,size_t size) {
+    return size>=12 && !memcmp(data,"RIFF",4) && !memcmp(data+8,"WAVE",4);
+}
+
+/**
+* Decode an ADPCM WAV file with the AudioConvert code, into memory of its own.
+* @param size is set to the size of the samples.
+* @param format is set to the format of the samples.
+* @return the samples, to be free()d.
+*/
+static void *decodeADPCM(const DataBlock *block,const WaveDecoder *wave,
+                         ALuint &size,ALenum &format) throw (FileError) {
+    const unsigned int encoding=wave->getEncoding();
+    if((encoding!=MS_ADPCM_CODE && encoding!=IMA_ADPCM_CODE) ||
+        !wave->getDataOffset() || wave->isTruncated())
+        throw FileError("Sample: Unsupported or damaged WAV file");
+
+    size=(ALuint)block->size();
+    void *pcm=0L;
+    ALushort acformat=0,frequency=0;
+    ALubyte channels=0;
+    if(!acLoadWAV(const_cast<char *>(block->data()),&size,&pcm,&acformat,&channels,&frequency) || !pcm)
+        throw FileError("Sample: Couldn't decode ADPCM WAV file");
+
+    format=channels==1 ? AL_FORMAT_MONO16 : channels==2 ? AL_FORMAT_STEREO16 : 0;
+    if(!format) {
+        free(pcm);
+        throw FileError("Sample: ADPCM WAV files must be mono or stereo");
+    }
+    return pcm;
+}
+
+/**
+* Decode all of a file with a StreamDecoder.
+*/
+static void decodeAll(StreamDecoder *decoder,std::vector<char> &pcm) throw (FileError) {
+    // Decode it all in one go, the length is known for most files
+    const unsigned int frameSize=decoder->getChannels()*2;
+    if(decoder->getFrames())
+        pcm.reserve(decoder->getFrames()*frameSize);
+
+    char buffer[16384];
+    const unsigned int length=sizeof(buffer)-sizeof(buffer)%frameSize;
+    long amt;
+    while((amt=decoder->read(buffer,length))>0)
+        pcm.insert(pcm.end(),buffer,buffer+amt);
+
+    if(pcm.empty())
+        throw FileError("Sample: No sound in file");
+}
+
 Sample::Sample(const std::string& filename) throw (FileError)
 : SoundData(),filename_(filename) {
+    // Map the file into memory if possible, otherwise read all of it
+    osg::ref_ptr<DataBlock> block;
+    try {
+        block=new MappedFile(filename);
+    }
+    catch(FileError &) {
+        std::ifstream file(filename.c_str(),std::ios::in|std::ios::binary);
+        if(!file)
+            throw FileError("Sample: Couldn't open file: "+filename);
+        block=new MemoryBlock(file);
+    }
+    if(!block->size())
+        throw FileError("Sample: Empty file: "+filename);
+
+    loadFromMemory(block.get());
+}
+
+Sample::Sample(const std::string& filename,Residency residency) throw (FileError)
+: SoundData(),filename_(filename) {
+    osg::ref_ptr<DataBlock> block;
+    try {
+        block=new MappedFile(filename);
+    }
+    catch(FileError &) {
+        std::ifstream file(filename.c_str(),std::ios::in|std::ios::binary);
+        if(!file)
+            throw FileError("Sample: Couldn't open file: "+filename);
+        block=new MemoryBlock(file);
+    }
+    if(!block->size())
+        throw FileError("Sample: Empty file: "+filename);
+
+    if(residency==Compressed)
+        keepCompressed(block.get());
+    else
+        loadFromMemory(block.get());
+}
+
+Sample::Sample(const DataBlock *block,Residency residency) throw (FileError)
+: SoundData() {
+    if(!block || !block->size())
+        throw FileError("Sample: No data to load");
+
+    if(residency==Compressed)
+        keepCompressed(block);
+    else
+        loadFromMemory(block);
+}
+
+void Sample::keepCompressed(const DataBlock *block) throw (FileError) {
+    // Only formats that are decoded into the existing buffer
+    const char *data=block->data();
+    const size_t size=block->size();
+    if(!isWaveFile(data,size) && !isDecodedFile(data,std::min(size,(size_t)4096)))
+        throw FileError("Sample: Only WAV files and files with a StreamDecoder can be kept compressed");
+
+    entry_=new SampleCache::Entry(block,buffer_->getName());
+}
+
+void Sample::acquire() throw (FileError) {
+    if(entry_.valid())
+        SampleCache::instance()->acquire(entry_.get(),this);
+}
+
+void Sample::release() {
+    if(entry_.valid())
+        SampleCache::instance()->release(entry_.get());
+}
+
+void Sample::attach(ALuint sourcename) {
+    if(entry_.valid())
+        SampleCache::instance()->attach(entry_.get(),sourcename);
+}
+
+void Sample::detach(ALuint sourcename) {
+    if(entry_.valid())
+        SampleCache::instance()->detach(entry_.get(),sourcename);
+}
+
+Sample::Sample(const DataBlock *block) throw (FileError)
+: SoundData() {
+    if(!block || !block->size())
+        throw FileError("Sample: No data to load");
+    loadFromMemory(block);
+}
+
+Sample::Sample(std::istream &stream) throw (FileError)
+: SoundData() {
+    osg::ref_ptr<DataBlock> block=new MemoryBlock(stream);
+    loadFromMemory(block.get());
+}
+
+void Sample::loadFromMemory(const DataBlock *block) throw (FileError) {
+    const char *data=block->data();
+    const size_t size=block->size();
+    if(isWaveFile(data,size)) {
+        loadWave(block);
+        return;
+    }
+    if(isDecodedFile(data,std::min(size,(size_t)4096))) {
+        decode(block);
+        return;
+    }
+
+    // Some other format alut may know, e.g. .au
+
 #if OPENAL_VERSION < 2007
-    ALsizei size;
-
-    ALsizei freq;
-#  if OPENAL_VERSION < 2005
-    ALsizei bits;
-    ALboolean success;
-#  endif // OPENAL_VERSION < 2005
-    ALenum format,error;
-    ALvoid* data;
+    ALsizei bufsize,freq;
+    ALenum format;
+    ALvoid* pcm=0L;
     ALboolean loop;
 
-#  if OPENAL_VERSION < 2005
-    success=alutLoadWAV(filename.c_str(),&data,&format,&size,&bits,&freq);
-    if(success==AL_TRUE && data ) {
-#  else // OPENAL_VERSION < 2005
-    alutLoadWAVFile(const_cast<ALbyte *>(filename.c_str()),&format,&data,&size,&freq,&loop);
-    if(data) {
-#  endif // OPENAL_VERSION < 2005
-        alBufferData(buffer_->buffername_,format,data,size,freq);
-        if((error=alGetError())!=AL_FALSE)
-            throw FileError("Error buffering sound");
-        free(data);
-    } else {
-        std::ostringstream str;
-        str << "Unable to load file: " << filename << std::ends;
-        throw FileError(str.str().c_str());
-    }
+    alutLoadWAVMemory(const_cast<ALbyte *>((const ALbyte *)data),&format,&pcm,&bufsize,&freq,&loop);
+    if(!pcm)
+        throw FileError("Unable to load sound from memory");
+
+    alBufferData(buffer_->getName(),format,pcm,bufsize,freq);
+    free(pcm);
+    if(alGetError()!=AL_FALSE)
+        throw FileError("Error buffering sound");
 #else // OPENAL_VERSION < 2007
-    ALuint success = alutCreateBufferFromFile (filename.c_str());
+    ALuint success = alutCreateBufferFromFileImage(data,(ALsizei)size);
 
     if(success!=AL_NONE) {
         buffer_ = new SoundBuffer(success);
-
     } else {
         ALenum error = alutGetError ();
         const char *error_str = alutGetErrorString (error);
         std::ostringstream str;
-        str << "Error loading file: " << filename << ": " << error_str << std::ends;
+        str << "Error loading sound from memory: " << error_str << std::ends;
         throw FileError(str.str().c_str());
     }
 #endif // OPENAL_VERSION < 2007
 }
 
+void Sample::loadWave(const DataBlock *block) throw (FileError) {
+    osg::ref_ptr<WaveDecoder> wave=new WaveDecoder(block);
+
+    if(!wave->valid()) {
+        // ADPCM is decoded by the AudioConvert code
+        ALuint size;
+        ALenum format;
+        void *pcm=decodeADPCM(block,wave.get(),size,format);
+        alBufferData(buffer_->getName(),format,pcm,size,wave->getFrequency());
+        free(pcm);
+        if(alGetError()!=AL_FALSE)
+            throw FileError("Error buffering sound");
+        return;
+    }
+
+    // Samples that OpenAL takes as they are go straight from the (mapped)
+    // file into the buffer, without an intermediate copy
+    if(!wave->getFrames())
+        throw FileError("Sample: No sound in WAV file");
+
+    ALenum format=0;
+    if(!wave->isFloat()) {
+        const unsigned int bytes=wave->getBlockAlign()/wave->getChannels();
+        if(bytes==1 && wave->getChannels()==1)
+            format=AL_FORMAT_MONO8;
+        else if(bytes==1 && wave->getChannels()==2)
+            format=AL_FORMAT_STEREO8;
+#ifndef WORDS_BIGENDIAN
+        else if(bytes==2)
+            format=wave->getFormat();
+#endif
+    }
+
+    if(format) {
+        alBufferData(buffer_->getName(),format,block->data()+wave->getDataOffset(),
+            (ALsizei)wave->getDataSize(),wave->getFrequency());
+        if(alGetError()!=AL_FALSE)
+            throw FileError("Error buffering sound");
+        return;
+    }
+
+    // 24 and 32 bit, float and big endian machines: convert to 16 bits
+    decode(block);
+}
+
+void Sample::decode(const DataBlock *block) throw (FileError) {
+    osg::ref_ptr<StreamDecoder> decoder=StreamDecoderRegistry::instance()->open(block);
+    if(!decoder.valid())
+        throw FileError("Sample: File of unknown type");
+
+    const ALenum format=decoder->getFormat();
+    if(!format) {
+        std::ostringstream str;
+        str << "Sample: " << decoder->getChannels() << " channels are not supported" << std::ends;
+        throw FileError(str.str().c_str());
+    }
+
+    std::vector<char> pcm;
+    decodeAll(decoder.get(),pcm);
+
+    alBufferData(buffer_->getName(),format,&pcm[0],(ALsizei)pcm.size(),decoder->getFrequency());
+    if(alGetError()!=AL_FALSE)
+        throw FileError("Error buffering sound");
+}
+
 Sample::Sample(const Sample &sample)
-: SoundData(sample), filename_(sample.filename_) {
+: SoundData(sample), filename_(sample.filename_), entry_(sample.entry_) {
 }
 
 Sample::Sample(ALenum format,ALvoid* data,ALsizei size,ALsizei freq) throw (FileError)
@@ -91,6 +320,62 @@ Sample::Sample(ALenum format,ALvoid* data,ALsizei size,ALsizei freq) throw (File
         throw FileError("Error buffering sound");
 }
 
+void Sample::getPCM(std::vector<char> &pcm,ALenum &format,unsigned int &frequency) const
+throw (FileError) {
+    if(entry_.valid()) {
+        decodeFile(entry_->getBlock(),pcm,format,frequency);
+        return;
+    }
+    if(filename_.empty())
+        throw FileError("Sample: Only samples loaded from a file or kept Compressed can be decoded again");
+
+    osg::ref_ptr<DataBlock> block;
+    try {
+        block=new MappedFile(filename_);
+    }
+    catch(FileError &) {
+        std::ifstream file(filename_.c_str(),std::ios::in|std::ios::binary);
+        if(!file)
+            throw FileError("Sample: Couldn't open file: "+filename_);
+        block=new MemoryBlock(file);
+    }
+    decodeFile(block.get(),pcm,format,frequency);
+}
+
+void Sample::decodeFile(const DataBlock *block,std::vector<char> &pcm,
+                        ALenum &format,unsigned int &frequency) throw (FileError) {
+    pcm.clear();
+    if(!block || !block->size())
+        throw FileError("Sample: No data to decode");
+
+    const char *data=block->data();
+    const size_t size=block->size();
+    osg::ref_ptr<StreamDecoder> decoder;
+    if(isWaveFile(data,size)) {
+        osg::ref_ptr<WaveDecoder> wave=new WaveDecoder(block);
+        if(!wave->valid()) {
+            ALuint pcmsize;
+            void *adpcm=decodeADPCM(block,wave.get(),pcmsize,format);
+            pcm.assign((const char *)adpcm,(const char *)adpcm+pcmsize);
+            free(adpcm);
+            frequency=wave->getFrequency();
+            return;
+        }
+        decoder=wave;
+    }
+    else if(isDecodedFile(data,std::min(size,(size_t)4096)))
+        decoder=StreamDecoderRegistry::instance()->open(block);
+
+    if(!decoder.valid())
+        throw FileError("Sample: Only WAV files and files with a StreamDecoder can be decoded again");
+
+    format=decoder->getFormat();
+    if(!format)
+        throw FileError("Sample: Unsupported number of channels");
+    frequency=decoder->getFrequency();
+    decodeAll(decoder.get(),pcm);
+}
+
 std::string Sample::getFileName() const {
     return filename_;
 }
@@ -105,6 +390,7 @@ Sample &Sample::operator=(const Sample &sample) {
     if(this!=&sample) {
         SoundData::operator=(sample);
         filename_=sample.filename_;
+        entry_=sample.entry_;
     }
     return *this;
 }
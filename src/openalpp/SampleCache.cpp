@@ -0,0 +1,172 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+
+#include <OpenThreads/ScopedLock>
+
+#include <openalpp/SampleCache.h>
+#include <openalpp/Sample.h>
+
+using namespace openalpp;
+
+SampleCache::Entry::Entry(const DataBlock *block,ALuint buffer)
+: osg::Referenced(), block_(block), buffer_(buffer), size_(0), pins_(0) {
+}
+
+SampleCache::Entry::~Entry() {
+    if(size_)
+        SampleCache::instance()->remove(this);
+}
+
+SampleCache *SampleCache::instance() {
+    static osg::ref_ptr<SampleCache> s_sampleCache = new SampleCache;
+    return s_sampleCache.get();
+}
+
+SampleCache::SampleCache()
+: osg::Referenced(), maxSize_(64*1024*1024), size_(0) {
+}
+
+void SampleCache::setMaxSize(unsigned long bytes) {
+    maxSize_=bytes;
+    trim();
+}
+
+void SampleCache::trim() {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+
+    // Least recently used first
+    std::list<Entry *>::iterator i=entries_.end();
+    while(size_>maxSize_ && i!=entries_.begin()) {
+        --i;
+        if(evict(*i))
+            i=entries_.erase(i);
+    }
+}
+
+void SampleCache::acquire(Entry *entry,Sample *sample) throw (FileError) {
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+        entry->pins_++;
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(entry->mutex_);
+    if(entry->size_) {
+        touch(entry);
+        return;
+    }
+
+    // Buffers can only be filled when no source holds them
+    setSources(entry,0);
+    try {
+        sample->loadFromMemory(entry->block_.get());
+    }
+    catch(FileError &) {
+        setSources(entry,entry->buffer_);
+        release(entry);
+        throw;
+    }
+    setSources(entry,entry->buffer_);
+    loaded(entry);
+}
+
+void SampleCache::release(Entry *entry) {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+    if(entry->pins_)
+        entry->pins_--;
+}
+
+void SampleCache::attach(Entry *entry,ALuint sourcename) {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(entry->mutex_);
+    if(std::find(entry->sources_.begin(),entry->sources_.end(),sourcename)==entry->sources_.end())
+        entry->sources_.push_back(sourcename);
+}
+
+void SampleCache::detach(Entry *entry,ALuint sourcename) {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(entry->mutex_);
+    std::vector<ALuint>::iterator i=std::find(entry->sources_.begin(),entry->sources_.end(),sourcename);
+    if(i!=entry->sources_.end())
+        entry->sources_.erase(i);
+}
+
+void SampleCache::setSources(Entry *entry,ALuint buffer) {
+    for(unsigned int i=0;i<entry->sources_.size();i++)
+        alSourcei(entry->sources_[i],AL_BUFFER,buffer);
+}
+
+void SampleCache::loaded(Entry *entry) {
+    ALint size=0;
+    alGetBufferi(entry->buffer_,AL_SIZE,&size);
+    entry->size_=size>0 ? (unsigned long)size : 1;
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+        entries_.push_front(entry);
+        size_+=entry->size_;
+    }
+    trim();
+}
+
+void SampleCache::touch(Entry *entry) {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+    std::list<Entry *>::iterator i=std::find(entries_.begin(),entries_.end(),entry);
+    if(i!=entries_.end())
+        entries_.splice(entries_.begin(),entries_,i);
+}
+
+void SampleCache::remove(Entry *entry) {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+    std::list<Entry *>::iterator i=std::find(entries_.begin(),entries_.end(),entry);
+    if(i!=entries_.end()) {
+        size_-=entry->size_;
+        entries_.erase(i);
+    }
+}
+
+bool SampleCache::evict(Entry *entry) {
+    // An entry that is about to be played, decoded or attached is busy,
+    // try another one
+    if(entry->pins_ || entry->mutex_.trylock())
+        return false;
+
+    bool playing=false;
+    for(unsigned int i=0;i<entry->sources_.size() && !playing;i++) {
+        ALint state=AL_STOPPED;
+        alGetSourcei(entry->sources_[i],AL_SOURCE_STATE,&state);
+        playing=state==AL_PLAYING || state==AL_PAUSED;
+    }
+
+    if(!playing) {
+        setSources(entry,0);
+        alBufferData(entry->buffer_,AL_FORMAT_MONO16,NULL,0,22050);
+        setSources(entry,entry->buffer_);
+        size_-=entry->size_;
+        entry->size_=0;
+    }
+
+    entry->mutex_.unlock();
+    return !playing;
+}
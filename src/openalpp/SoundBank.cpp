@@ -0,0 +1,406 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+
+#include <openalpp/SoundBank.h>
+#include <openalpp/MappedFile.h>
+#include <openalpp/StreamDecoder.h>
+#include <openalpp/Resampler.h>
+
+#ifndef AL_LOOP_POINTS_SOFT
+#define AL_LOOP_POINTS_SOFT 0x2015
+#endif
+
+using namespace openalpp;
+
+static const char bankMagic[4]={'O','A','B','K'};
+static const unsigned int bankVersion=1;
+static const size_t headerSize=8*4;
+static const size_t indexEntrySize=16*4;
+
+static unsigned int getWord(const char *data)
+{
+    const unsigned char *p=(const unsigned char *)data;
+    return p[0] | (p[1]<<8) | (p[2]<<16) | ((unsigned int)p[3]<<24);
+}
+
+static void putWord(std::ostream &out,unsigned int word)
+{
+    const char bytes[4]={(char)word,(char)(word>>8),(char)(word>>16),(char)(word>>24)};
+    out.write(bytes,4);
+}
+
+static size_t getSize(const char *data)
+{
+    unsigned long long size=getWord(data) | ((unsigned long long)getWord(data+4)<<32);
+    return (size_t)size;
+}
+
+static void putSize(std::ostream &out,size_t size)
+{
+    putWord(out,(unsigned int)size);
+    putWord(out,(unsigned int)((unsigned long long)size>>32));
+}
+
+/**
+* Names are case insensitive, with '/' between directories.
+*/
+static std::string normalizeName(const std::string &name)
+{
+    std::string normal(name);
+    for(unsigned int i=0;i<normal.size();i++) {
+        if(normal[i]=='\\')
+            normal[i]='/';
+        else if(normal[i]>='A' && normal[i]<='Z')
+            normal[i]+='a'-'A';
+    }
+    return normal;
+}
+
+/**
+* Orders the index.
+*/
+static bool entryLess(const SoundBank::Entry &a,const SoundBank::Entry &b)
+{
+    if(a.hash!=b.hash)
+        return a.hash<b.hash;
+    return a.name<b.name;
+}
+
+
+SoundBank::SoundBank(const std::string &filename) throw (FileError)
+: block_(new MappedFile(filename))
+{
+    readIndex();
+}
+
+SoundBank::SoundBank(const DataBlock *block) throw (FileError)
+: block_(block)
+{
+    readIndex();
+}
+
+unsigned int SoundBank::hash(const std::string &name)
+{
+    // FNV-1a
+    const std::string normal=normalizeName(name);
+    unsigned int h=2166136261u;
+    for(unsigned int i=0;i<normal.size();i++) {
+        h^=(unsigned char)normal[i];
+        h*=16777619u;
+    }
+    return h;
+}
+
+void SoundBank::readIndex() throw (FileError)
+{
+    const char *data=block_->data();
+    const size_t size=block_->size();
+
+    if(size<headerSize || memcmp(data,bankMagic,4))
+        throw FileError("SoundBank: Not a sound bank");
+    if(getWord(data+4)!=bankVersion)
+        throw FileError("SoundBank: Unsupported sound bank version");
+
+    const size_t count=getWord(data+8);
+    const size_t indexOffset=getWord(data+12);
+    const size_t namesOffset=getWord(data+16);
+    const size_t namesSize=getWord(data+20);
+    if(indexOffset>size || count>(size-indexOffset)/indexEntrySize ||
+       namesOffset>size || namesSize>size-namesOffset)
+        throw FileError("SoundBank: Truncated sound bank");
+
+    entries_.resize(count);
+    for(size_t i=0;i<count;i++) {
+        const char *p=data+indexOffset+i*indexEntrySize;
+        Entry &entry=entries_[i];
+
+        entry.hash=getWord(p);
+        const size_t nameOffset=getWord(p+4);
+        const size_t nameLength=getWord(p+8);
+        if(nameOffset>namesSize || nameLength>namesSize-nameOffset)
+            throw FileError("SoundBank: Corrupt sound bank index");
+        entry.name.assign(data+namesOffset+nameOffset,nameLength);
+
+        entry.encoding=(Encoding)getWord(p+12);
+        entry.channels=getWord(p+16);
+        entry.frequency=getWord(p+20);
+        entry.loopStart=getWord(p+24);
+        entry.loopEnd=getWord(p+28);
+        entry.offset=getSize(p+32);
+        entry.size=getSize(p+40);
+        if(entry.offset>size || entry.size>size-entry.offset)
+            throw FileError("SoundBank: Truncated sound bank");
+    }
+}
+
+const SoundBank::Entry *SoundBank::find(const std::string &name) const
+{
+    Entry key;
+    key.hash=hash(name);
+    key.name=normalizeName(name);
+
+    std::vector<Entry>::const_iterator i=std::lower_bound(entries_.begin(),entries_.end(),key,entryLess);
+    if(i==entries_.end() || i->hash!=key.hash || i->name!=key.name)
+        return 0L;
+    return &*i;
+}
+
+DataBlock *SoundBank::getData(const Entry *entry) const
+{
+    return new SubBlock(block_.get(),entry->offset,entry->size);
+}
+
+Sample *SoundBank::createSample(const std::string &name,Sample::Residency residency) const
+throw (NameError,FileError)
+{
+    const Entry *entry=find(name);
+    if(!entry)
+        throw NameError("SoundBank: No sound named "+name);
+
+    osg::ref_ptr<Sample> sample;
+    if(entry->encoding==File) {
+        osg::ref_ptr<DataBlock> file=getData(entry);
+        sample=new Sample(file.get(),residency);
+    }
+    else if(entry->encoding==PCM16) {
+        ALenum format;
+        if(entry->channels==1)
+            format=AL_FORMAT_MONO16;
+        else if(entry->channels==2)
+            format=AL_FORMAT_STEREO16;
+        else
+            throw FileError("SoundBank: Unsupported number of channels in "+name);
+
+        const char *data=block_->data()+entry->offset;
+#ifdef WORDS_BIGENDIAN
+        std::vector<char> swapped(data,data+entry->size);
+        for(size_t i=0;i+1<swapped.size();i+=2)
+            std::swap(swapped[i],swapped[i+1]);
+        if(!swapped.empty())
+            data=&swapped[0];
+#endif
+        // The data is copied to the buffer, straight from the mapping
+        sample=new Sample(format,(ALvoid *)data,(ALsizei)entry->size,(ALsizei)entry->frequency);
+    }
+    else
+        throw FileError("SoundBank: Unknown encoding of "+name);
+
+#if OPENAL_VERSION >= 2005
+    // Compressed samples are refilled on play, which drops the loop points
+    if(entry->loopEnd>entry->loopStart && sample->getResidency()==Sample::Decoded &&
+       alIsExtensionPresent("AL_SOFT_loop_points")) {
+        ALint points[2]={(ALint)entry->loopStart,(ALint)entry->loopEnd};
+        alBufferiv(sample->getAlBuffer(),AL_LOOP_POINTS_SOFT,points);
+    }
+#endif
+
+    return sample.release();
+}
+
+
+bool SoundBankWriter::Sound::operator<(const Sound &other) const
+{
+    return entryLess(entry,other.entry);
+}
+
+SoundBankWriter::SoundBankWriter(unsigned int alignment)
+: alignment_(alignment ? alignment : 1), frequency_(0)
+{
+}
+
+/**
+* Get a sample position from a tag like LOOPSTART=44100.
+* @return -1 if there is no such tag.
+*/
+static long getTagFrames(StreamDecoder *decoder,const char *tag)
+{
+    const std::string value=decoder->getTag(tag);
+    if(value.empty())
+        return -1;
+    return atol(value.c_str());
+}
+
+bool SoundBankWriter::add(const std::string &name,const DataBlock *file,bool decode)
+{
+    osg::ref_ptr<const DataBlock> ref=file;
+    const char *data=file->data();
+    const size_t size=file->size();
+    const bool wave=size>=12 && !memcmp(data,"RIFF",4) && !memcmp(data+8,"WAVE",4);
+    StreamDecoderRegistry *registry=StreamDecoderRegistry::instance();
+    if(!wave && !registry->canDecode(data,std::min(size,(size_t)4096)))
+        return false;
+
+    // Loop points, as used by many games and tools
+    long loopstart=-1,loopend=-1;
+    osg::ref_ptr<StreamDecoder> decoder=registry->open(file,name);
+    if(decoder.valid()) {
+        loopstart=getTagFrames(decoder.get(),"LOOPSTART");
+        loopend=getTagFrames(decoder.get(),"LOOPEND");
+        long looplength=getTagFrames(decoder.get(),"LOOPLENGTH");
+        if(loopend<0 && looplength>0)
+            loopend=(loopstart>0 ? loopstart : 0)+looplength;
+    }
+    if(loopstart<0)
+        loopstart=0;
+    if(loopend<0)
+        loopend=0;
+
+    // Compressed WAV files have no StreamDecoder, and are stored as they are
+    const unsigned int channels=decoder.valid() ? decoder->getChannels() : 0;
+    if(decode && (channels==1 || channels==2)) {
+        std::vector<short> pcm;
+        pcm.reserve(decoder->getFrames()*channels);
+        std::vector<short> chunk(4096*channels);
+        long read;
+        while((read=decoder->read((char *)&chunk[0],chunk.size()*sizeof(short)))>0)
+            pcm.insert(pcm.end(),chunk.begin(),chunk.begin()+read/sizeof(short));
+        if(read==0 && !pcm.empty()) {
+            addPCM(name,&pcm[0],pcm.size()/channels,channels,decoder->getFrequency(),loopstart,loopend);
+            return true;
+        }
+    }
+
+    Sound sound;
+    sound.entry.hash=SoundBank::hash(name);
+    sound.entry.name=normalizeName(name);
+    sound.entry.encoding=SoundBank::File;
+    sound.entry.channels=channels;
+    sound.entry.frequency=decoder.valid() ? decoder->getFrequency() : 0;
+    sound.entry.loopStart=loopstart;
+    sound.entry.loopEnd=loopend;
+    sound.entry.offset=0;
+    sound.entry.size=size;
+    sound.data=file;
+    sounds_.push_back(sound);
+    return true;
+}
+
+void SoundBankWriter::addPCM(const std::string &name,const short *data,unsigned long frames,
+                             unsigned int channels,unsigned int frequency,
+                             unsigned long loopStart,unsigned long loopEnd)
+{
+    std::vector<short> resampled;
+    if(frequency_ && frequency && frequency!=frequency_) {
+        const double ratio=(double)frequency/frequency_;
+        Resampler::resample(data,frames,channels,ratio,resampled,Resampler::Best);
+        data=resampled.empty() ? 0L : &resampled[0];
+        frames=resampled.size()/channels;
+        loopStart=(unsigned long)(loopStart/ratio+0.5);
+        loopEnd=(unsigned long)(loopEnd/ratio+0.5);
+        frequency=frequency_;
+    }
+
+    std::vector<char> bytes(frames*channels*2);
+    for(size_t i=0;i<frames*channels;i++) {
+        bytes[i*2]=(char)data[i];
+        bytes[i*2+1]=(char)(data[i]>>8);
+    }
+
+    Sound sound;
+    sound.entry.hash=SoundBank::hash(name);
+    sound.entry.name=normalizeName(name);
+    sound.entry.encoding=SoundBank::PCM16;
+    sound.entry.channels=channels;
+    sound.entry.frequency=frequency;
+    sound.entry.loopStart=loopStart;
+    sound.entry.loopEnd=loopEnd;
+    sound.entry.offset=0;
+    sound.entry.size=bytes.size();
+    sound.data=new MemoryBlock(bytes);
+    sounds_.push_back(sound);
+}
+
+void SoundBankWriter::write(const std::string &filename) throw (FileError)
+{
+    std::sort(sounds_.begin(),sounds_.end());
+    for(size_t i=1;i<sounds_.size();i++)
+        if(sounds_[i].entry.hash==sounds_[i-1].entry.hash && sounds_[i].entry.name==sounds_[i-1].entry.name)
+            throw FileError("SoundBankWriter: Sound added twice: "+sounds_[i].entry.name);
+
+    // Layout: header, index, names, then the aligned sounds
+    const size_t indexOffset=headerSize;
+    const size_t namesOffset=indexOffset+sounds_.size()*indexEntrySize;
+    std::vector<size_t> nameOffsets(sounds_.size());
+    size_t namesSize=0;
+    for(size_t i=0;i<sounds_.size();i++) {
+        nameOffsets[i]=namesSize;
+        namesSize+=sounds_[i].entry.name.size();
+    }
+    size_t offset=namesOffset+namesSize;
+    for(size_t i=0;i<sounds_.size();i++) {
+        offset=(offset+alignment_-1)/alignment_*alignment_;
+        sounds_[i].entry.offset=offset;
+        offset+=sounds_[i].entry.size;
+    }
+
+    std::ofstream out(filename.c_str(),std::ios::out|std::ios::binary|std::ios::trunc);
+    if(!out)
+        throw FileError("SoundBankWriter: Couldn't create file: "+filename);
+
+    out.write(bankMagic,4);
+    putWord(out,bankVersion);
+    putWord(out,sounds_.size());
+    putWord(out,indexOffset);
+    putWord(out,namesOffset);
+    putWord(out,namesSize);
+    putWord(out,alignment_);
+    putWord(out,0);
+
+    for(size_t i=0;i<sounds_.size();i++) {
+        const SoundBank::Entry &entry=sounds_[i].entry;
+        putWord(out,entry.hash);
+        putWord(out,nameOffsets[i]);
+        putWord(out,entry.name.size());
+        putWord(out,entry.encoding);
+        putWord(out,entry.channels);
+        putWord(out,entry.frequency);
+        putWord(out,entry.loopStart);
+        putWord(out,entry.loopEnd);
+        putSize(out,entry.offset);
+        putSize(out,entry.size);
+        for(unsigned int r=0;r<4;r++)
+            putWord(out,0);
+    }
+
+    for(size_t i=0;i<sounds_.size();i++)
+        out.write(sounds_[i].entry.name.data(),sounds_[i].entry.name.size());
+
+    size_t position=namesOffset+namesSize;
+    const std::vector<char> padding(alignment_,0);
+    for(size_t i=0;i<sounds_.size();i++) {
+        const SoundBank::Entry &entry=sounds_[i].entry;
+        out.write(&padding[0],entry.offset-position);
+        out.write(sounds_[i].data->data(),entry.size);
+        position=entry.offset+entry.size;
+    }
+
+    if(!out)
+        throw FileError("SoundBankWriter: Couldn't write file: "+filename);
+}
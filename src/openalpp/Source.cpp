@@ -28,6 +28,21 @@
 
 using namespace openalpp;
 
+/**
+* Compressed samples keep track of the sources they are attached to, see SampleCache.
+*/
+static void attachSample(SoundData *sound,ALuint sourcename) {
+    Sample *sample=dynamic_cast<Sample *>(sound);
+    if(sample)
+        sample->attach(sourcename);
+}
+
+static void detachSample(SoundData *sound,ALuint sourcename) {
+    Sample *sample=dynamic_cast<Sample *>(sound);
+    if(sample)
+        sample->detach(sourcename);
+}
+
 Source::Source(float x, float y, float z) : SourceBase(x,y,z) {
     streaming_=false;
     sounddata_=NULL;
@@ -59,10 +74,12 @@ Source::Source( const Source &source) : SourceBase(source) {
 
     alSourcei(sourcename_,AL_BUFFER,sounddata_->getAlBuffer());
     ALCHECKERROR();
+    attachSample(sounddata_.get(),sourcename_);
 }
 
 Source::~Source() {
     stop();
+    detachSample(sounddata_.get(),sourcename_);
     sounddata_ = 0;
 }
 
@@ -75,7 +92,7 @@ void Source::setSound(const std::string& filename) {
     if (sounddata_.valid()) {
         stop();
         alSourcei(sourcename_,AL_BUFFER,0);
-
+        detachSample(sounddata_.get(),sourcename_);
     }
 
     sounddata_=new Sample(filename);
@@ -93,12 +110,14 @@ void Source::setSound( Sample *buffer ) {
         stop();
         alSourcei(sourcename_,AL_BUFFER,0);
         ALCHECKERROR();
+        detachSample(sounddata_.get(),sourcename_);
     }
 
     sounddata_=buffer;
 
     alSourcei(sourcename_,AL_BUFFER,sounddata_->getAlBuffer());
     ALCHECKERROR();
+    buffer->attach(sourcename_);
 
 }
 
@@ -127,7 +146,9 @@ void Source::play(const std::string& filename) {
 
 void Source::play( Sample *buffer) {
     setSound(buffer);
+    buffer->acquire();
     SourceBase::play();
+    buffer->release();
 }
 
 void Source::play( Stream *stream ) {
@@ -139,6 +160,21 @@ void Source::play( Stream *stream ) {
     SourceBase::play();
 }
 
+bool Source::preroll( Stream *stream, float timeout ) {
+    if(sounddata_.get()!=stream)
+        setSound(stream);
+    return preroll(timeout);
+}
+
+bool Source::preroll(float timeout) {
+    if(!streaming_ || getState()==Playing)
+        return false;
+
+    alSourcei(sourcename_,AL_LOOPING,AL_FALSE); //Streaming sources can't loop...
+    ALCHECKERROR();
+    return ((Stream *)sounddata_.get())->preroll(sourcename_,timeout);
+}
+
 void Source::setLooping(bool loop) {
     if (streaming_) {
 
@@ -151,6 +187,7 @@ void Source::setLooping(bool loop) {
 }
 
 void Source::play() {
+    Sample *sample=NULL;
 
     if(streaming_ && !isPaused()) {
         alSourcei(sourcename_,AL_LOOPING,AL_FALSE); //Streaming sources can't loop...
@@ -159,7 +196,19 @@ void Source::play() {
 
         ((Stream *)sounddata_.get())->record(sourcename_);
     }
+    else if(!streaming_ && sounddata_.valid() && !isPaused()) {
+        // Decode a Compressed sample, it is kept until it is playing
+        sample=dynamic_cast<Sample *>(sounddata_.get());
+        if(sample)
+            sample->acquire();
+    }
     SourceBase::play();
+    if(sample)
+        sample->release();
+
+    // A paused stream sleeps until it is woken up
+    if(streaming_)
+        ((Stream *)sounddata_.get())->wake(sourcename_);
 }
 
 void Source::seek(float time_s)
@@ -168,7 +217,7 @@ void Source::seek(float time_s)
     {
         /* continuing to use downcast for this to avoid 
         ** modifying SoundData for now */
-        static_cast<Stream *>(sounddata_.get())->seek(time_s);
+        static_cast<Stream *>(sounddata_.get())->seek(sourcename_,time_s);
     }
 }
 
@@ -180,6 +229,8 @@ void Source::stop() {
 
 void Source::pause() {
     SourceBase::pause();
+    if(streaming_)
+        ((Stream *)sounddata_.get())->wake(sourcename_);
 }
 
 
@@ -191,11 +242,13 @@ Source &Source::operator=(const Source &source) {
     if(this!=&source) {
         SourceBase::operator=(source);
 
+        detachSample(sounddata_.get(),sourcename_);
         streaming_=source.streaming_;
         if(streaming_)
             sounddata_=new Stream(*(Stream *)source.sounddata_.get());
         else
             sounddata_=new Sample(*(Sample *)source.sounddata_.get());
+        attachSample(sounddata_.get(),sourcename_);
     }
     return *this;
 }
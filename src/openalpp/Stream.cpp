@@ -23,6 +23,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <OpenThreads/ScopedLock>
+
 #include <openalpp/StreamUpdater.h>
 #include <openalpp/Stream.h>
 
@@ -35,7 +37,9 @@ Stream::Stream() throw (NameError) : SoundData(), isRecording_(false) {
 
 Stream::Stream(const Stream &stream) : SoundData((const SoundData &)stream) {
     buffer2_=stream.buffer2_;//->reference();
+    morebuffers_=stream.morebuffers_;
     updater_=stream.updater_;//->reference();
+    cursors_=stream.cursors_;
     isRecording_ = stream.isRecording_;
 }
 
@@ -43,7 +47,9 @@ Stream &Stream::operator=(const Stream &stream) {
     if(this!=&stream) {
         SoundData::operator=((const SoundData &)stream);
         buffer2_=stream.buffer2_;//->reference();
+        morebuffers_=stream.morebuffers_;
         updater_=stream.updater_;//->reference();
+        cursors_=stream.cursors_;
     }
     return *this;
 }
@@ -52,29 +58,161 @@ Stream::~Stream() {
     updater_ = 0L;
 }
 
+std::vector<ALuint> Stream::createBuffers(unsigned int nbuffers) throw (NameError) {
+    std::vector<ALuint> buffers;
+    buffers.push_back(getAlBuffer());
+    buffers.push_back(buffer2_->getAlBuffer());
+
+    while(buffers.size()<nbuffers) {
+        osg::ref_ptr<SoundBuffer> buffer=new SoundBuffer();
+        morebuffers_.push_back(buffer);
+        buffers.push_back(buffer->getName());
+    }
+    return buffers;
+}
+
+std::vector<ALuint> Stream::generateBuffers(unsigned int nbuffers,
+                                            std::vector<osg::ref_ptr<SoundBuffer> > &buffers) throw (NameError) {
+    std::vector<ALuint> names;
+    while(names.size()<nbuffers) {
+        osg::ref_ptr<SoundBuffer> buffer=new SoundBuffer();
+        buffers.push_back(buffer);
+        names.push_back(buffer->getName());
+    }
+    return names;
+}
+
+osg::ref_ptr<StreamUpdater> Stream::attach(ALuint sourcename,bool &added) {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(cursorMutex_);
+
+    std::map<ALuint,Cursor>::iterator it=cursors_.find(sourcename);
+    added = it==cursors_.end();
+    if(!added)
+        return it->second.updater;
+
+    // The first source streams with updater_, the others get cursors of
+    // their own so that they don't have to play in lock-step
+    Cursor cursor;
+    for(it=cursors_.begin();it!=cursors_.end();it++)
+        if(it->second.updater==updater_)
+            break;
+    if(it==cursors_.end() || !createCursor(cursor))
+        cursor.updater=updater_;
+
+    cursors_[sourcename]=cursor;
+    isRecording_ = true;
+    return cursor.updater;
+}
+
+osg::ref_ptr<StreamUpdater> Stream::getUpdater(ALuint sourcename) {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(cursorMutex_);
+    std::map<ALuint,Cursor>::iterator it=cursors_.find(sourcename);
+    return it!=cursors_.end() ? it->second.updater : updater_;
+}
+
+std::vector<osg::ref_ptr<StreamUpdater> > Stream::getUpdaters() const {
+    std::vector<osg::ref_ptr<StreamUpdater> > updaters;
+    if(updater_.valid())
+        updaters.push_back(updater_);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(cursorMutex_);
+    for(std::map<ALuint,Cursor>::const_iterator it=cursors_.begin();it!=cursors_.end();it++)
+        if(it->second.updater!=updater_)
+            updaters.push_back(it->second.updater);
+    return updaters;
+}
+
 void Stream::record(ALuint sourcename) {
     if(!updater_)
         throw FatalError("No updater thread for stream!");
-    if (!isRecording_)
+
+    bool added;
+    osg::ref_ptr<StreamUpdater> updater=attach(sourcename,added);
+
+    // The buffers are already queued, playing the source is all it takes
+    if(!added && updater->isPrerolled(sourcename))
+        return;
+
+    if(added)
         alSourcei(sourcename,AL_BUFFER,0);
 
-    updater_->addSource(sourcename);
-    isRecording_ = true;
+    updater->addSource(sourcename);
 }
 
+bool Stream::preroll(ALuint sourcename,float timeout) {
+    if(!updater_)
+        throw FatalError("No updater thread for stream!");
 
+    bool added;
+    return attach(sourcename,added)->preroll(sourcename,timeout);
+}
 
 void Stream::seek(float time_s)
 {
-    if (updater_.valid())
-    {
-        updater_->seek(time_s);
-    }
+    std::vector<osg::ref_ptr<StreamUpdater> > updaters=getUpdaters();
+    for(unsigned int i=0;i<updaters.size();i++)
+        updaters[i]->seek(time_s);
+}
+
+void Stream::seek(ALuint sourcename,float time_s)
+{
+    osg::ref_ptr<StreamUpdater> updater=getUpdater(sourcename);
+    if(updater.valid())
+        updater->seek(time_s);
 }
 
 void Stream::stop(ALuint sourcename) {
     if(!updater_)
         throw FatalError("No updater thread for stream!");
-    updater_->removeSource(sourcename);
-    isRecording_ = false;
+
+    // A cursor of its own goes away with the source, when it is released below
+    Cursor cursor;
+    bool own=false;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(cursorMutex_);
+        std::map<ALuint,Cursor>::iterator it=cursors_.find(sourcename);
+        if(it!=cursors_.end()) {
+            cursor=it->second;
+            own=cursor.updater!=updater_;
+            cursors_.erase(it);
+        } else {
+            cursor.updater=updater_;
+        }
+        isRecording_ = !cursors_.empty();
+    }
+
+    // Removed before the cursor's updater and buffers are released, rather
+    // than by the scheduler after them
+    if(own)
+        cursor.updater->removeSourceNow(sourcename);
+    else
+        cursor.updater->removeSource(sourcename);
+}
+
+void Stream::wake() {
+    std::vector<osg::ref_ptr<StreamUpdater> > updaters=getUpdaters();
+    for(unsigned int i=0;i<updaters.size();i++)
+        updaters[i]->wake();
+}
+
+void Stream::wake(ALuint sourcename) {
+    osg::ref_ptr<StreamUpdater> updater=getUpdater(sourcename);
+    if(updater.valid())
+        updater->wake();
+}
+
+unsigned int Stream::getUnderrunCount() const {
+    std::vector<osg::ref_ptr<StreamUpdater> > updaters=getUpdaters();
+    unsigned int count=0;
+    for(unsigned int i=0;i<updaters.size();i++)
+        count+=updaters[i]->getUnderrunCount();
+    return count;
+}
+
+unsigned int Stream::getRecoveryCount() const {
+    std::vector<osg::ref_ptr<StreamUpdater> > updaters=getUpdaters();
+    unsigned int count=0;
+    for(unsigned int i=0;i<updaters.size();i++)
+        count+=updaters[i]->getRecoveryCount();
+    return count;
 }
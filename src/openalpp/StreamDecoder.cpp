@@ -0,0 +1,123 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+
+#include <OpenThreads/ScopedLock>
+
+#include <openalpp/StreamDecoder.h>
+#include <openalpp/WaveDecoder.h>
+#include <openalpp/VorbisDecoder.h>
+#include <openalpp/FlacDecoder.h>
+#include <openalpp/OpusDecoder.h>
+
+using namespace openalpp;
+
+StreamDecoder::StreamDecoder()
+: osg::Referenced(), channels_(0), frequency_(0), frames_(0) {
+}
+
+StreamDecoder::~StreamDecoder() {
+}
+
+ALenum StreamDecoder::getFormat() const {
+    switch(channels_) {
+    case 1:
+        return AL_FORMAT_MONO16;
+    case 2:
+        return AL_FORMAT_STEREO16;
+    case 4:
+        return alGetEnumValue("AL_FORMAT_QUAD16");
+    case 6:
+        return alGetEnumValue("AL_FORMAT_51CHN16");
+    default:
+        return 0;
+    }
+}
+
+StreamDecoderRegistry *StreamDecoderRegistry::instance() {
+    static osg::ref_ptr<StreamDecoderRegistry> s_registry = new StreamDecoderRegistry;
+    return s_registry.get();
+}
+
+StreamDecoderRegistry::StreamDecoderRegistry() {
+    factories_.push_back(new WaveDecoderFactory);
+#ifdef OPENALPP_HAVE_FLAC
+    factories_.push_back(new FlacDecoderFactory);
+#endif
+#ifdef OPENALPP_HAVE_OPUS
+    factories_.push_back(new OpusDecoderFactory);
+#endif
+    factories_.push_back(new VorbisDecoderFactory);
+}
+
+void StreamDecoderRegistry::add(StreamDecoderFactory *factory) {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+    factories_.push_back(factory);
+}
+
+void StreamDecoderRegistry::remove(StreamDecoderFactory *factory) {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+    std::vector<osg::ref_ptr<StreamDecoderFactory> >::iterator i=
+        std::find(factories_.begin(),factories_.end(),factory);
+    if(i!=factories_.end())
+        factories_.erase(i);
+}
+
+StreamDecoder *StreamDecoderRegistry::open(const DataBlock *block,const std::string &filename) {
+    if(!block || !block->size())
+        return NULL;
+
+    const size_t probesize=std::min(block->size(),(size_t)4096);
+
+    // Try the factories that recognize the file, cheapest first
+    std::vector<osg::ref_ptr<StreamDecoderFactory> > candidates;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+        for(unsigned int i=0;i<factories_.size();i++) {
+            if(!factories_[i]->probe(block->data(),probesize))
+                continue;
+            std::vector<osg::ref_ptr<StreamDecoderFactory> >::iterator pos=candidates.begin();
+            while(pos!=candidates.end() && (*pos)->getCost()<=factories_[i]->getCost())
+                ++pos;
+            candidates.insert(pos,factories_[i]);
+        }
+    }
+
+    for(unsigned int i=0;i<candidates.size();i++) {
+        StreamDecoder *decoder=candidates[i]->open(block,filename);
+        if(decoder)
+            return decoder;
+    }
+    return NULL;
+}
+
+bool StreamDecoderRegistry::canDecode(const char *data,size_t size) {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+    for(unsigned int i=0;i<factories_.size();i++)
+        if(factories_[i]->probe(data,size))
+            return true;
+    return false;
+}
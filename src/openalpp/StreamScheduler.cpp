@@ -0,0 +1,274 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <openalpp/StreamScheduler.h>
+#include <openalpp/StreamUpdater.h>
+#include <openalpp/AudioBase.h>
+
+using namespace openalpp;
+
+
+unsigned int StreamScheduler::nthreads_ = 1;
+unsigned int StreamScheduler::ndecodethreads_ = 1;
+
+/**
+* Thread running StreamScheduler::serviceLoop() for one stage.
+*/
+class StreamScheduler::ServiceThread : public OpenThreads::Thread {
+public:
+    ServiceThread(StreamScheduler *scheduler,Stage stage) : scheduler_(scheduler), stage_(stage) {}
+
+    void run() { scheduler_->serviceLoop(stage_); }
+
+protected:
+    StreamScheduler *scheduler_;
+    Stage stage_;
+};
+
+
+StreamScheduler *StreamScheduler::instance()
+{
+    static osg::ref_ptr<StreamScheduler> s_streamScheduler = new StreamScheduler(nthreads_,ndecodethreads_);
+    return s_streamScheduler.get();
+}
+
+void StreamScheduler::setNumThreads(unsigned int n)
+{
+    nthreads_ = n ? n : 1;
+}
+
+unsigned int StreamScheduler::getNumThreads()
+{
+    return nthreads_;
+}
+
+void StreamScheduler::setNumDecodeThreads(unsigned int n)
+{
+    ndecodethreads_ = n ? n : 1;
+}
+
+unsigned int StreamScheduler::getNumDecodeThreads()
+{
+    return ndecodethreads_;
+}
+
+StreamScheduler::StreamScheduler(unsigned int nthreads,unsigned int ndecodethreads) : done_(false)
+{
+    for(unsigned int i=0;i<nthreads+ndecodethreads;i++) {
+        ServiceThread *thread = new ServiceThread(this,i<nthreads ? FEED : DECODE);
+        threads_.push_back(thread);
+        thread->start();
+    }
+}
+
+StreamScheduler::~StreamScheduler()
+{
+    mutex_.lock();
+    done_ = true;
+    condition_.broadcast();
+    mutex_.unlock();
+
+    for(unsigned int i=0;i<threads_.size();i++) {
+        threads_[i]->join();
+        delete threads_[i];
+    }
+    threads_.clear();
+}
+
+StreamScheduler::Task *StreamScheduler::find(StreamUpdater *updater,Stage stage)
+{
+    for(unsigned int i=0;i<tasks_.size();i++)
+        if(tasks_[i].updater==updater && tasks_[i].stage==stage)
+            return &tasks_[i];
+    return NULL;
+}
+
+void StreamScheduler::add(StreamUpdater *updater)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+
+    if(find(updater,FEED))
+        return;
+
+    Task task;
+    task.updater = updater;
+    task.due = osg::Timer::instance()->tick();
+    task.idle = true;
+    task.busy = false;
+    task.woken = false;
+
+    task.stage = FEED;
+    tasks_.push_back(task);
+    task.stage = DECODE;
+    tasks_.push_back(task);
+}
+
+void StreamScheduler::remove(StreamUpdater *updater)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+
+    const Stage stages[2] = { FEED, DECODE };
+    for(unsigned int s=0;s<2;s++) {
+        Task *task;
+        while((task=find(updater,stages[s])) && task->busy)
+            condition_.wait(&mutex_);
+
+        if(task)
+            tasks_.erase(tasks_.begin()+(task-&tasks_[0]));
+    }
+}
+
+void StreamScheduler::wake(StreamUpdater *updater,Stage stage)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+
+    Task *task = find(updater,stage);
+    if(!task)
+        return;
+
+    if(task->busy)
+        task->woken = true;
+
+    task->idle = false;
+    task->due = osg::Timer::instance()->tick();
+
+    // Threads of both stages wait for the same condition
+    condition_.broadcast();
+}
+
+unsigned int StreamScheduler::getNumStreams()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+    return tasks_.size()/2;
+}
+
+void StreamScheduler::serviceLoop(Stage stage)
+{
+    osg::Timer *timer = osg::Timer::instance();
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+    while(!done_) {
+        // Parked on a loopback device, render() services the updaters
+        if(AudioBase::isLoopback()) {
+            condition_.wait(&mutex_);
+            continue;
+        }
+
+        // Find the updater that needs service first
+        Task *next = NULL;
+        for(unsigned int i=0;i<tasks_.size();i++) {
+            Task &task = tasks_[i];
+            if(task.stage!=stage || task.busy || task.idle)
+                continue;
+            if(!next || task.due<next->due)
+                next = &task;
+        }
+
+        if(!next) {
+            condition_.wait(&mutex_);
+            continue;
+        }
+
+        osg::Timer_t now = timer->tick();
+        if(next->due>now) {
+            // Sleep until it is due, or until something changes
+            unsigned long ms = (unsigned long)timer->delta_m(now,next->due);
+            condition_.wait(&mutex_,ms ? ms : 1);
+            continue;
+        }
+
+        StreamUpdater *updater = next->updater;
+        next->busy = true;
+        next->woken = false;
+
+        mutex_.unlock();
+        double delay = stage==FEED ? updater->service() : updater->decode();
+        mutex_.lock();
+
+        // tasks_ may have been reallocated while unlocked
+        finish(find(updater,stage),delay);
+    }
+}
+
+void StreamScheduler::finish(Task *task,double delay)
+{
+    osg::Timer *timer = osg::Timer::instance();
+
+    task->busy = false;
+    if(task->woken) {
+        task->woken = false;
+        task->due = timer->tick();
+    } else if(delay<0.0) {
+        task->idle = true;
+    } else {
+        task->idle = false;
+        task->due = timer->tick() + (osg::Timer_t)(delay/timer->getSecondsPerTick());
+    }
+
+    // Someone may be waiting in remove(), and a new updater may be due
+    condition_.broadcast();
+}
+
+void StreamScheduler::serviceNow()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+
+    const Stage stages[2] = { DECODE, FEED };
+    for(unsigned int s=0;s<2;s++) {
+        std::vector<StreamUpdater *> updaters;
+        for(unsigned int i=0;i<tasks_.size();i++)
+            if(tasks_[i].stage==stages[s])
+                updaters.push_back(tasks_[i].updater);
+
+        for(unsigned int i=0;i<updaters.size();i++)
+            runNow(updaters[i],stages[s]);
+    }
+}
+
+void StreamScheduler::serviceNow(StreamUpdater *updater,Stage stage)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mutex_);
+    runNow(updater,stage);
+}
+
+void StreamScheduler::runNow(StreamUpdater *updater,Stage stage)
+{
+    Task *task;
+    while((task=find(updater,stage)) && task->busy)
+        condition_.wait(&mutex_);
+
+    // Removed while unlocked
+    if(!task)
+        return;
+
+    task->busy = true;
+    task->woken = false;
+
+    mutex_.unlock();
+    double delay = stage==FEED ? updater->service() : updater->decode();
+    mutex_.lock();
+
+    finish(find(updater,stage),delay);
+}
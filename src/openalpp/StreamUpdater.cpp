@@ -27,6 +27,7 @@
 // the class has been instantiated (the ogg vorbis format allows this)
 
 #include <openalpp/StreamUpdater.h>
+#include <openalpp/StreamScheduler.h>
 
 #define ENTER_CRITICAL lock(); 
 
@@ -44,18 +45,44 @@
 
 using namespace openalpp;
 
+/**
+* Unqueue all buffers of a stopped source, one at a time, as a scheduled
+* updater may have queued any number of them.
+*/
+static void unqueueAll(ALuint source) {
+    ALint nqueued;
+    alGetSourceiv(source,AL_BUFFERS_QUEUED,&nqueued);
+    while(nqueued-- > 0) {
+        ALuint dump;
+        alSourceUnqueueBuffers(source,1,&dump);
+    }
+}
+
 StreamUpdater::StreamUpdater(ALuint buffer1,ALuint buffer2,
                              ALenum format,unsigned int frequency) 
-                             : format_(format), frequency_(frequency), stoprunning_(false), sleepTime_(10)
+                             : format_(format), frequency_(frequency), stoprunning_(false), sleepTime_(10),
+                             scheduled_(false), eof_(false), bufferFrames_(0),
+                             feedGeneration_(0), decodeGeneration_(0), decodeEof_(false),
+                             underruns_(0), recoveries_(0), prerolled_(false), woken_(false)
 {
-    buffers_[0]=buffer1;
-    buffers_[1]=buffer2;
+    buffers_.push_back(buffer1);
+    buffers_.push_back(buffer2);
 
     // Start by not letting this thread stream data
     m_playEvent.reset();
 
 }
 
+StreamUpdater::StreamUpdater(const std::vector<ALuint> &buffers,
+                             ALenum format,unsigned int frequency) 
+                             : buffers_(buffers), format_(format), frequency_(frequency), stoprunning_(false), sleepTime_(10),
+                             scheduled_(false), eof_(false), bufferFrames_(0),
+                             ring_(1), feedGeneration_(0), decodeGeneration_(0), decodeEof_(false),
+                             underruns_(0), recoveries_(0), prerolled_(false), woken_(false)
+{
+    m_playEvent.reset();
+}
+
 StreamUpdater::~StreamUpdater() {
     runmutex_.lock();
     stop();
@@ -71,13 +98,7 @@ StreamUpdater::~StreamUpdater() {
     for (unsigned int i=0;i<sources_.size();i++)
     {
         alSourceStop(sources_[i]);
-        ALuint temp[2];
-        ALint nqueued;
-        alGetSourceiv(sources_[i], AL_BUFFERS_QUEUED, &nqueued);
-        if (nqueued)
-        {
-            alSourceUnqueueBuffers(sources_[i], nqueued, temp);
-        }
+        unqueueAll(sources_[i]);
     }
     sources_.clear();
     removesources_.clear();
@@ -90,6 +111,9 @@ void StreamUpdater::addSource(ALuint sourcename) {
 
     alSourceStop(sourcename);
     newsources_.push_back(sourcename);
+    wake();
+    if(scheduled_)
+        return;
     if(!sources_.size()) {
         if (!isRunning()) {
             start(); // Now when we have added a source, start the thread
@@ -104,11 +128,30 @@ void StreamUpdater::removeSource(ALuint sourcename) {
         removesources_.push_back(sourcename);
     }    
 
+    wake();
+    if(scheduled_)
+        return;
+
     // If there are no more sources, tell the thread to wait
     if (!(sources_.size()-1))
         hold();
 }
 
+void StreamUpdater::removeSourceNow(ALuint sourcename) {
+    if(!scheduled_) {
+        removeSource(sourcename);
+        return;
+    }
+
+    // Waits for service() or decode() in progress, nothing runs them after
+    unschedule();
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> scope_lock(*this);
+        removesources_.push_back(sourcename);
+    }
+    processRemovedSources();
+}
+
 void StreamUpdater::processRemovedSources()
 {
     // remove sources that are queued for removal
@@ -119,11 +162,7 @@ void StreamUpdater::processRemovedSources()
             if (removesources_.back()==sources_[i]) 
             {
                 alSourceStop(removesources_.back());
-                ALuint dump[2];
-                ALint nqueued;
-                alGetSourceiv(removesources_.back(),AL_BUFFERS_QUEUED,&nqueued);
-                if(nqueued)
-                    alSourceUnqueueBuffers(removesources_.back(),nqueued,dump);
+                unqueueAll(removesources_.back());
                 alGetError();
                 while((i+1)<sources_.size())
                     sources_[i]=sources_[i+1];
@@ -133,6 +172,8 @@ void StreamUpdater::processRemovedSources()
             removesources_.pop_back();
     }
     removesources_.clear();
+    if(!sources_.size())
+        prerolled_ = false;
 }
 
 
@@ -164,6 +205,7 @@ void StreamUpdater::processAddedSources()
                     sources_.push_back(newsources_.back());
                     alSourceStop(newsources_.back());
                     newsources_.pop_back();
+                    eof_ = false;
                 }
             }
         } 
@@ -211,16 +253,19 @@ bool StreamUpdater::update(void *buffer, unsigned int length)
         ///TODO: Pause is really not something that is very well implemented right now.
         // It only uses state of first source to make out if we are in pause state or not.
 
-        /* a hack to get the paused mode to work, wait for non paused state,
-        ** using only the first source */
+        /* wait for non paused state, using only the first source.
+        ** Source::play() wakes us up when it is resumed */
         if (state == AL_PAUSED)
         {
-            while (state == AL_PAUSED)
+            while (state == AL_PAUSED && !shouldStop())
             {
                 LEAVE_CRITICAL;
-                YieldCurrentThread();
+                waitForWake(-1.0);
                 ENTER_CRITICAL;
-                OpenThreads::Thread::microSleep(1);
+                if (!sources_.size() || removesources_.size() || newsources_.size()) {
+                    LEAVE_CRITICAL;
+                    return update(buffer,length);
+                }
                 alGetSourceiv(sources_[0], AL_SOURCE_STATE, &state);
             }
         }
@@ -252,18 +297,13 @@ bool StreamUpdater::update(void *buffer, unsigned int length)
         // start up two new buffers
         if (state == AL_INITIAL)
         {
-            ALuint dump[2];
             for(unsigned int i=0;i<sources_.size();i++) {
                 // Yeah, this sucks, but how else could the sources be kept
                 // synchronized (they have to be unless we start using different
                 // buffers for each source)...
                 alSourceStop(sources_[i]);
                 ALCHECKERROR();
-                ALint nqueued;
-                alGetSourceiv(sources_[i],AL_BUFFERS_QUEUED,&nqueued);
-                ALCHECKERROR();
-                if(nqueued)
-                    alSourceUnqueueBuffers(sources_[i],nqueued,dump);
+                unqueueAll(sources_[i]);
                 ALCHECKERROR();
             }
             unsigned int l = length*0.5;
@@ -272,9 +312,10 @@ bool StreamUpdater::update(void *buffer, unsigned int length)
             alBufferData(buffers_[1],format_,
                 (char *)buffer+l,l,frequency_);
             ALCHECKERROR();
+            updateBufferFrames();
             for(unsigned int i=0;i<sources_.size();i++) 
             {
-                alSourceQueueBuffers(sources_[i],2,buffers_);
+                alSourceQueueBuffers(sources_[i],2,&buffers_[0]);
                 ALCHECKERROR();
                 alSourcePlay(sources_[i]);  // TODO: This would be better handled by
                 ALCHECKERROR();
@@ -303,13 +344,15 @@ bool StreamUpdater::update(void *buffer, unsigned int length)
                 ALCHECKERROR();
                 for(unsigned int i=0;i<sources_.size();i++)
                     alSourceQueueBuffers(sources_[i],1,&albuffer);
-                YieldCurrentThread();
             } else {
+                // Sleep until the playing buffer is done, or something changes
+                double wait=timeToRefill();
                 LEAVE_CRITICAL;
-                YieldCurrentThread();
-                OpenThreads::Thread::microSleep(1000*10);
+                waitForWake(wait);
                 ENTER_CRITICAL;
-                // Not sure if this is necessary, but just in case...
+                if(shouldStop())
+                    break;
+                // removeSource() wakes us up, start over to remove it
                 if(removesources_.size()) {                
                     LEAVE_CRITICAL;
                     return update(buffer,length);
@@ -329,6 +372,438 @@ bool StreamUpdater::update(void *buffer, unsigned int length)
     return ret;
 }
 
+void StreamUpdater::schedule()
+{
+    scheduled_ = true;
+    StreamScheduler::instance()->add(this);
+}
+
+void StreamUpdater::unschedule()
+{
+    if(scheduled_)
+        StreamScheduler::instance()->remove(this);
+}
+
+void StreamUpdater::wake()
+{
+    if(scheduled_) {
+        StreamScheduler::instance()->wake(this);
+        // preroll() waits for the decoder itself
+        if(!(unsigned int)prerolling_)
+            return;
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(wakeMutex_);
+    woken_ = true;
+    wakeCondition_.signal();
+}
+
+void StreamUpdater::stop()
+{
+    stoprunning_ = true;
+    release();
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(wakeMutex_);
+    woken_ = true;
+    wakeCondition_.signal();
+}
+
+void StreamUpdater::waitForWake(double seconds)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(wakeMutex_);
+    if(!woken_ && !stoprunning_) {
+        if(seconds<0.0) {
+            wakeCondition_.wait(&wakeMutex_);
+        } else {
+            unsigned long ms = (unsigned long)(seconds*1000.0);
+            wakeCondition_.wait(&wakeMutex_,ms ? ms : 1);
+        }
+    }
+    woken_ = false;
+}
+
+void StreamUpdater::updateBufferFrames()
+{
+    ALint size,bits,channels;
+    alGetBufferi(buffers_[0],AL_SIZE,&size);
+    alGetBufferi(buffers_[0],AL_BITS,&bits);
+    alGetBufferi(buffers_[0],AL_CHANNELS,&channels);
+    if(bits && channels)
+        bufferFrames_ = size/(bits/8*channels);
+}
+
+void StreamUpdater::wakeDecoder()
+{
+    if(scheduled_)
+        StreamScheduler::instance()->wake(this,StreamScheduler::DECODE);
+}
+
+void StreamUpdater::seek(float time_s)
+{
+    seekTarget_.exchange(time_s>0.0f ? (unsigned int)(time_s*1000.0f) : 0);
+    ++generation_;
+
+    // Blocks decoded ahead are from before the seek. A stream that has played
+    // to its end can be restarted by seeking.
+    wakeDecoder();
+    wake();
+}
+
+bool StreamUpdater::preroll(ALuint sourcename,double timeout)
+{
+    if(!scheduled_)
+        return false;
+
+    processRemovedSources();
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> scope_lock(*this);
+        // The buffers are shared by all sources, they can't be queued ahead
+        // for one while another one plays them
+        if(sources_.size() || newsources_.size())
+            return false;
+
+        alSourceRewind(sourcename);
+        alSourcei(sourcename,AL_BUFFER,0);
+        ALCHECKERROR();
+    }
+
+    // Nothing is fed while there are no sources, so the blocks are ours
+    osg::Timer *timer = osg::Timer::instance();
+    osg::Timer_t start = timer->tick();
+    ALsizei nbuffers=0;
+
+    prerolling_.exchange(1);
+    for(;;) {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> scope_lock(*this);
+
+            unsigned int generation = generation_;
+            if(generation!=feedGeneration_) {
+                feedGeneration_ = generation;
+                eof_ = false;
+                nbuffers = 0;
+            }
+
+            while(nbuffers<(ALsizei)buffers_.size()) {
+                unsigned int length;
+                void *data=nextBlock(length);
+                if(!data)
+                    break;
+                alBufferData(buffers_[nbuffers],format_,data,length,frequency_);
+                ALCHECKERROR();
+                doneBlock();
+                nbuffers++;
+            }
+
+            if(eof_ || nbuffers==(ALsizei)buffers_.size())
+                break;
+        }
+
+        double remaining = timeout-timer->delta_s(start,timer->tick());
+        if(remaining<=0.0 || shouldStop())
+            break;
+
+        // The decoder threads are parked on a loopback device
+        if(AudioBase::isLoopback())
+            StreamScheduler::instance()->serviceNow(this,StreamScheduler::DECODE);
+        else
+            waitForWake(remaining);
+    }
+    prerolling_.exchange(0);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> scope_lock(*this);
+    if(!nbuffers)
+        return false;
+
+    updateBufferFrames();
+    alSourceQueueBuffers(sourcename,nbuffers,&buffers_[0]);
+    ALCHECKERROR();
+    sources_.push_back(sourcename);
+    prerolled_ = true;
+
+    // The feeder tops up the queue if the decoder was too slow
+    wake();
+    return true;
+}
+
+bool StreamUpdater::isPrerolled(ALuint sourcename)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> scope_lock(*this);
+    return prerolled_ && sources_.size()==1 && sources_[0]==sourcename;
+}
+
+void StreamUpdater::setDecodeAhead(unsigned int blocks)
+{
+    ring_.resize(blocks ? blocks : 1);
+}
+
+double StreamUpdater::decode()
+{
+    PCMRing::Block *block;
+    while(!shouldStop() && (block=ring_.back())) {
+        unsigned int generation = generation_;
+        if(generation!=decodeGeneration_) {
+            decodeGeneration_ = generation;
+            decodeEof_ = false;
+            seekNow((unsigned int)seekTarget_/1000.0f);
+        }
+        if(decodeEof_)
+            break;
+
+        unsigned int length;
+        void *data=readBlock(length);
+        if(!data || !length) {
+            // An empty block tells the feeder that the stream has ended
+            decodeEof_ = true;
+            block->data.clear();
+        } else {
+            block->data.assign((char *)data,(char *)data+length);
+        }
+        block->generation = generation;
+        ring_.push();
+
+        if(starving_.exchange(0))
+            wake();
+    }
+
+    return -1.0;
+}
+
+void *StreamUpdater::nextBlock(unsigned int &length)
+{
+    length = 0;
+    if(eof_)
+        return NULL;
+
+    for(;;) {
+        const PCMRing::Block *block=ring_.front();
+        if(!block) {
+            // Have the decoder wake us up, unless it got here first
+            starving_.exchange(1);
+            if(ring_.empty()) {
+                wakeDecoder();
+                return NULL;
+            }
+            starving_.exchange(0);
+            continue;
+        }
+
+        if(block->generation!=feedGeneration_) {
+            // Decoded before a seek
+            doneBlock();
+            continue;
+        }
+
+        if(block->data.empty()) {
+            doneBlock();
+            eof_ = true;
+            return NULL;
+        }
+
+        length = block->data.size();
+        return (void *)&block->data[0];
+    }
+}
+
+void StreamUpdater::doneBlock()
+{
+    ring_.pop();
+    wakeDecoder();
+}
+
+double StreamUpdater::timeToRefill()
+{
+    if(!sources_.size() || !bufferFrames_ || !frequency_)
+        return 0.01;
+
+    ALint offset=0,queued=0;
+    alGetSourcei(sources_[0],AL_SAMPLE_OFFSET,&offset);
+    alGetSourcei(sources_[0],AL_BUFFERS_QUEUED,&queued);
+    ALCHECKERROR();
+
+    // Keep at least half of the queue ahead of the play position...
+    unsigned int remaining = queued*bufferFrames_>(unsigned int)offset ? queued*bufferFrames_-offset : 0;
+    unsigned int margin = (buffers_.size()/2)*bufferFrames_;
+    unsigned int frames = remaining>margin ? remaining-margin : 0;
+
+    // ...but there is nothing to refill until the playing buffer is done
+    unsigned int current = bufferFrames_ - offset%bufferFrames_;
+    if(frames<current)
+        frames=current;
+
+    // A little late rather than early, so the buffer is reported processed
+    return (double)frames/frequency_ + 0.005;
+}
+
+/**
+* Same as update(), but never blocks. Instead of waiting for a buffer to be
+* processed, it returns the time until the queue should be refilled.
+*/
+double StreamUpdater::service()
+{
+    processRemovedSources();
+    processAddedSources();
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> scope_lock(*this);
+
+    if(!sources_.size())
+        return -1.0;
+
+    // Start over after a seek
+    bool restart=false;
+    unsigned int generation = generation_;
+    if(generation!=feedGeneration_) {
+        feedGeneration_ = generation;
+        eof_ = false;
+        restart = true;
+    }
+
+    ALint state=AL_PLAYING;
+    for(unsigned int i=0;i<sources_.size();i++) 
+    {
+        alGetSourceiv(sources_[i],AL_SOURCE_STATE,&state);
+        if(state!=AL_PLAYING)
+            break;
+    }
+
+    // Nothing to do until Source::play() resumes it and wakes us up
+    if(state==AL_PAUSED)
+        return -1.0;
+
+    if(prerolled_) {
+        ALint nqueued=0;
+        alGetSourceiv(sources_[0],AL_BUFFERS_QUEUED,&nqueued);
+        if(state!=AL_INITIAL) {
+            prerolled_ = false;
+        } else if(!restart && nqueued==(ALint)buffers_.size()) {
+            // Queued ahead, alSourcePlay() starts it
+            return -1.0;
+        } else if(!restart && nqueued) {
+            // preroll() gave up waiting for the decoder, top up the queue
+            while(nqueued<(ALint)buffers_.size()) {
+                unsigned int length;
+                void *data=nextBlock(length);
+                if(!data)
+                    break;
+                alBufferData(buffers_[nqueued],format_,data,length,frequency_);
+                ALCHECKERROR();
+                doneBlock();
+                alSourceQueueBuffers(sources_[0],1,&buffers_[nqueued]);
+                ALCHECKERROR();
+                nqueued++;
+            }
+            return -1.0;
+        }
+    }
+
+    bool underrun=false;
+    if(state==AL_STOPPED)
+    {
+        // Played to the end, nothing more to do until a seek or a new source
+        if(eof_)
+            return -1.0;
+
+        // A stopped source with buffers queued has played them all: an underrun.
+        // (New sources have no buffers queued.)
+        for(unsigned int i=0;i<sources_.size() && !underrun;i++) 
+        {
+            ALint nqueued;
+            alGetSourceiv(sources_[i], AL_BUFFERS_QUEUED, &nqueued);
+            ALCHECKERROR();
+            if(nqueued)
+                underrun=true;
+        }
+        if(underrun)
+            underruns_++;
+
+        // Start over with fresh buffers rather than replaying the old ones
+        state = AL_INITIAL;
+    }
+
+    if(state==AL_INITIAL)
+    {
+        for(unsigned int i=0;i<sources_.size();i++) {
+            // A prerolled source has to stay in the initial state
+            if(prerolled_)
+                alSourceRewind(sources_[i]);
+            else
+                alSourceStop(sources_[i]);
+            unqueueAll(sources_[i]);
+            ALCHECKERROR();
+        }
+
+        ALsizei nbuffers=0;
+        while(nbuffers<(ALsizei)buffers_.size()) {
+            unsigned int length;
+            void *data=nextBlock(length);
+            if(!data)
+                break;
+            alBufferData(buffers_[nbuffers],format_,data,length,frequency_);
+            ALCHECKERROR();
+            doneBlock();
+            nbuffers++;
+        }
+        // At the end, or woken up by the decoder when it has caught up
+        if(!nbuffers)
+            return -1.0;
+
+        // All buffers but the last one have the same size
+        updateBufferFrames();
+
+        for(unsigned int i=0;i<sources_.size();i++) 
+        {
+            alSourceQueueBuffers(sources_[i],nbuffers,&buffers_[0]);
+            ALCHECKERROR();
+        }
+        // Prerolled again after a seek, still waiting to be played
+        if(prerolled_)
+            return -1.0;
+
+        if(sources_.size()) {
+            alSourcePlayv(sources_.size(),&sources_[0]);
+            ALCHECKERROR();
+        }
+
+        if(underruns_>recoveries_)
+            recoveries_++;
+    }
+    else if(state==AL_PLAYING)
+    {
+        ALint processed=buffers_.size();
+        for(unsigned int i=0;i<sources_.size();i++) {
+            ALint p;
+            alGetSourceiv(sources_[i],AL_BUFFERS_PROCESSED,&p);
+            ALCHECKERROR();
+            if(p<processed)
+                processed=p;
+        }
+
+        while(processed-- > 0) {
+            // At the end the sources play out what is queued. If the decoder
+            // is behind, it wakes us up when it has caught up.
+            unsigned int length;
+            void *data=nextBlock(length);
+            if(!data)
+                break;
+
+            ALuint albuffer=0;
+            for(unsigned int i=0;i<sources_.size();i++) {
+                alSourceUnqueueBuffers(sources_[i],1,&albuffer);
+                ALCHECKERROR();
+            }
+
+            alBufferData(albuffer,format_,data,length,frequency_);
+            ALCHECKERROR();
+            doneBlock();
+            for(unsigned int i=0;i<sources_.size();i++)
+                alSourceQueueBuffers(sources_[i],1,&albuffer);
+            ALCHECKERROR();
+        }
+    }
+
+    return timeToRefill();
+}
+
 void StreamUpdater::cancelCleanup() {
     std::cerr << "StreamUpdater::cancelCleanup: Should probably not delete this" << std::endl;
     delete this;
@@ -0,0 +1,221 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <iostream>
+#include <cstring>
+
+#include <openalpp/VorbisDecoder.h>
+
+using namespace openalpp;
+
+//---------------------------------------------------------------------------------
+// The vorbisfile callbacks, reading from a block of memory (or a file mapped into memory)
+//---------------------------------------------------------------------------------
+struct VorbisMemory
+{
+    osg::ref_ptr<const openalpp::DataBlock> file;
+    size_t position;
+};
+
+static size_t VorbisMemoryRead(void *ptr, size_t byteSize, size_t sizeToRead, void *datasource)
+{
+    VorbisMemory* source = (VorbisMemory*)datasource;
+
+    size_t left = source->file->size() - source->position;
+    size_t count = byteSize ? sizeToRead : 0;
+    if (count*byteSize > left)
+        count = left/byteSize;
+
+    memcpy(ptr, source->file->data() + source->position, count*byteSize);
+    source->position += count*byteSize;
+
+    return count;
+}
+
+static int VorbisMemorySeek(void *datasource, ogg_int64_t offset, int whence)
+{
+    VorbisMemory* source = (VorbisMemory*)datasource;
+
+    ogg_int64_t position;
+    switch (whence)
+    {
+    case SEEK_SET: position = offset; break;
+    case SEEK_CUR: position = (ogg_int64_t)source->position + offset; break;
+    case SEEK_END: position = (ogg_int64_t)source->file->size() + offset; break;
+    default: return -1;
+    }
+    if (position < 0 || position > (ogg_int64_t)source->file->size())
+        return -1;
+
+    // Have the pages at the new position read ahead, a seek breaks the sequential pattern
+    if ((size_t)position != source->position)
+        source->file->willNeed((size_t)position, 64*1024);
+
+    source->position = (size_t)position;
+    return 0;
+}
+
+static int VorbisMemoryClose(void *datasource)
+{
+    delete (VorbisMemory*)datasource;
+    return 0;
+}
+
+static long VorbisMemoryTell(void *datasource)
+{
+    return (long)((VorbisMemory*)datasource)->position;
+}
+
+static const char *getOggVorbisErrorMessage(int e)
+{
+    switch(e) {
+    case (OV_ENOSEEK):
+        return "Bitstream is not seekable.";
+    case (OV_EINVAL):
+        return "Invalid argument value; possibly called with an OggVorbis_File structure that isn't open.";
+    case (OV_EREAD):
+        return "A read from media returned an error.";
+    case (OV_EFAULT):
+        return "Internal logic fault; indicates a bug or heap/stack corruption.";
+    case (OV_EBADLINK):
+        return "Invalid stream section supplied to libvorbisfile, or the requested link is corrupt.";
+    default:
+        return "Invalid error code specified";
+    }
+    return "";
+}
+
+bool VorbisDecoderFactory::probe(const char *data,size_t size) const {
+    // The first page holds the identification header, after the segment table
+    if(size<28 || memcmp(data,"OggS",4))
+        return false;
+    const size_t header=27+(unsigned char)data[26];
+    return size>=header+7 && !memcmp(data+header,"\x01vorbis",7);
+}
+
+StreamDecoder *VorbisDecoderFactory::open(const DataBlock *block,const std::string &filename) {
+    // Index the pages for seeking, once per file
+    osg::ref_ptr<OggPageIndex> index;
+    if(filename.empty())
+        index=new OggPageIndex(block);
+    else
+        index=OggPageIndex::get(filename,block);
+
+    osg::ref_ptr<VorbisDecoder> decoder=new VorbisDecoder(block,index.get());
+    if(!decoder->valid())
+        return NULL;
+    return decoder.release();
+}
+
+VorbisDecoder::VorbisDecoder(const DataBlock *block,OggPageIndex *index)
+: StreamDecoder(), open_(false), index_(index) {
+    ov_callbacks callbacks;
+    callbacks.read_func = VorbisMemoryRead;
+    callbacks.close_func = VorbisMemoryClose;
+    callbacks.seek_func = VorbisMemorySeek;
+    callbacks.tell_func = VorbisMemoryTell;
+
+    VorbisMemory *source = new VorbisMemory;
+    source->file = block;
+    source->position = 0;
+
+    if(ov_open_callbacks(source,&oggfile_,NULL,0,callbacks)<0) {
+        delete source;
+        return;
+    }
+    open_=true;
+
+    vorbis_info *ogginfo=ov_info(&oggfile_,-1);
+    channels_=ogginfo->channels;
+    frequency_=ogginfo->rate;
+    ogg_int64_t frames=ov_pcm_total(&oggfile_,-1);
+    frames_=frames>0 ? (unsigned long)frames : 0;
+
+    // The index only knows the first logical stream
+    if(index_.valid() && (!index_->valid() || ov_streams(&oggfile_)!=1))
+        index_=0L;
+}
+
+VorbisDecoder::~VorbisDecoder() {
+    if(open_)
+        ov_clear(&oggfile_);
+}
+
+long VorbisDecoder::read(char *buffer,unsigned int length) {
+    int stream=0;
+    for(;;) {
+        long amt=ov_read(&oggfile_,buffer,length,0,2,1,&stream);
+        if(amt!=OV_HOLE)
+            return amt;
+        // A gap in the data, carry on
+    }
+}
+
+bool VorbisDecoder::seek(unsigned long frame) {
+    if(!ov_seekable(&oggfile_))
+        return false;
+
+    if(index_.valid()) {
+        // Jump to the page before the frame, and decode up to the frame itself
+        if(!ov_raw_seek(&oggfile_,index_->findPage(frame))) {
+            ogg_int64_t pos=ov_pcm_tell(&oggfile_);
+            if(pos>=0 && pos<=(ogg_int64_t)frame && skipFrames(frame-pos))
+                return true;
+        }
+        // Fall back on bisecting
+    }
+
+    int s=ov_pcm_seek(&oggfile_,frame);
+    if(s) {
+        std::cerr << "Error seeking oggstream: " << getOggVorbisErrorMessage(s) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool VorbisDecoder::skipFrames(ogg_int64_t frames) {
+    char scratch[4096];
+    const unsigned int frameSize=channels_*2;
+
+    while(frames>0) {
+        long want=sizeof(scratch)-sizeof(scratch)%frameSize;
+        if((ogg_int64_t)want>frames*frameSize)
+            want=(long)(frames*frameSize);
+
+        long amt=read(scratch,want);
+        if(amt<=0)
+            return false;
+        frames-=amt/frameSize;
+    }
+    return true;
+}
+
+std::string VorbisDecoder::getTag(const std::string &name) {
+    vorbis_comment *comment=ov_comment(&oggfile_,-1);
+    if(!comment)
+        return std::string();
+    const char *value=vorbis_comment_query(comment,name.c_str(),0);
+    return value ? std::string(value) : std::string();
+}
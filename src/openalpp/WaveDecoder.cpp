@@ -0,0 +1,158 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <cstring>
+
+#include <openalpp/WaveDecoder.h>
+
+using namespace openalpp;
+
+static unsigned int readLE(const unsigned char *p,unsigned int bytes) {
+    unsigned int value=0;
+    for(unsigned int i=bytes;i>0;i--)
+        value=(value<<8)|p[i-1];
+    return value;
+}
+
+bool WaveDecoderFactory::probe(const char *data,size_t size) const {
+    return size>=12 && !memcmp(data,"RIFF",4) && !memcmp(data+8,"WAVE",4);
+}
+
+StreamDecoder *WaveDecoderFactory::open(const DataBlock *block,const std::string &) {
+    osg::ref_ptr<WaveDecoder> decoder=new WaveDecoder(block);
+    if(!decoder->valid())
+        return NULL;
+    return decoder.release();
+}
+
+WaveDecoder::WaveDecoder(const DataBlock *block)
+: StreamDecoder(), block_(block), dataOffset_(0), dataSize_(0), position_(0),
+bits_(0), blockAlign_(0), encoding_(0), float_(false), truncated_(false) {
+    const unsigned char *data=(const unsigned char *)block->data();
+    const size_t size=block->size();
+    if(size<12 || memcmp(data,"RIFF",4) || memcmp(data+8,"WAVE",4))
+        return;
+
+    unsigned int tag=0,channels=0,align=0,bits=0;
+    size_t offset=12;
+    while(offset+8<=size) {
+        const unsigned char *chunk=data+offset;
+        size_t length=readLE(chunk+4,4);
+        offset+=8;
+        const bool truncated=length>size-offset;
+        if(truncated)
+            length=size-offset;
+
+        if(!memcmp(chunk,"fmt ",4) && length>=16) {
+            tag=readLE(chunk+8,2);
+            channels=readLE(chunk+10,2);
+            frequency_=readLE(chunk+12,4);
+            align=readLE(chunk+20,2);
+            bits=readLE(chunk+22,2);
+            // WAVE_FORMAT_EXTENSIBLE, the real format is in the sub format GUID
+            if(tag==0xFFFE && length>=40)
+                tag=readLE(chunk+32,2);
+        } else if(!memcmp(chunk,"data",4)) {
+            dataOffset_=offset;
+            dataSize_=length;
+            truncated_=truncated;
+            break;
+        }
+
+        // Chunks are padded to an even size
+        offset+=length+(length&1);
+    }
+
+    encoding_=tag;
+    if(!dataOffset_ || !channels || !frequency_ || !align)
+        return;
+
+    // PCM or IEEE float, with whole bytes per sample
+    const unsigned int bytes=align/channels;
+    if(align%channels || bytes<1 || bytes>4)
+        return;
+    if(tag==3) {
+        if(bytes!=4)
+            return;
+        float_=true;
+    } else if(tag!=1) {
+        return;
+    }
+
+    channels_=channels;
+    bits_=bits ? bits : bytes*8;
+    blockAlign_=align;
+    dataSize_-=dataSize_%align;
+    frames_=dataSize_/align;
+}
+
+long WaveDecoder::read(char *buffer,unsigned int length) {
+    if(!valid())
+        return -1;
+
+    const unsigned int bytes=blockAlign_/channels_;
+    const size_t frameSize=channels_*2;
+    size_t frames=length/frameSize;
+    size_t left=(dataSize_-position_)/blockAlign_;
+    if(frames>left)
+        frames=left;
+    if(!frames)
+        return 0;
+
+    const unsigned char *in=(const unsigned char *)block_->data()+dataOffset_+position_;
+    const size_t samples=frames*channels_;
+    ALshort *out=(ALshort *)buffer;
+
+    if(float_) {
+        for(size_t i=0;i<samples;i++,in+=4) {
+            unsigned int u=readLE(in,4);
+            float f;
+            memcpy(&f,&u,4);
+            if(f>1.0f) f=1.0f;
+            else if(f<-1.0f) f=-1.0f;
+            out[i]=(ALshort)(f*32767.0f);
+        }
+    } else if(bytes==1) {
+        // 8 bit samples are unsigned
+        for(size_t i=0;i<samples;i++,in++)
+            out[i]=(ALshort)((in[0]-128)<<8);
+    } else {
+        // Keep the most significant 16 bits, stored last
+        for(size_t i=0;i<samples;i++,in+=bytes)
+            out[i]=(ALshort)(in[bytes-2] | (in[bytes-1]<<8));
+    }
+
+    position_+=frames*blockAlign_;
+    return (long)(frames*frameSize);
+}
+
+bool WaveDecoder::seek(unsigned long frame) {
+    if(!valid() || frame>frames_)
+        return false;
+
+    position_=frame*blockAlign_;
+    block_->willNeed(dataOffset_+position_,64*1024);
+    return true;
+}
@@ -85,6 +85,17 @@ void AudioEnvironment::init(int frequency,int refresh, bool displayInitMsgs) thr
 	getSystem( displayInitMsgs ); 
 } // AudioEnvironment::AudioEnvironment
 
+void AudioEnvironment::initLoopback(unsigned int frequency,unsigned int channels,
+									bool floating,bool displayInitMsgs) throw (InitError)
+{
+	throw InitError("Loopback rendering requires the OpenAL subsystem");
+} // AudioEnvironment::initLoopback
+
+void AudioEnvironment::render(void *buffer,unsigned int frames) throw (FatalError)
+{
+	throw FatalError("Loopback rendering requires the OpenAL subsystem");
+} // AudioEnvironment::render
+
 void AudioEnvironment::initInternals()
 {
 	//_dopplerFactor = 1.0;  // re-inited by calcFMODDopplerFactor, below
@@ -36,11 +36,19 @@ throw (NameError,InitError,FileError)
 	createStreamFromFilename(filename); // on Stream class
 } // FileStream::FileStream
 
+FileStream::FileStream(std::istream& stream,const int buffersize)
+throw (NameError,InitError,FileError) 
+: Stream(0) {
+	_FMODSound = NULL;
+
+	createStreamFromStream(stream); // on Stream class
+} // FileStream::FileStream
+
 FileStream::FileStream(const FileStream &stream)
 : Stream(0) {
 	_FMODSound = NULL;
 
-	createStreamFromFilename(stream.getFilename());
+	createStreamLike(stream);
 } // FileStream::FileStream
 
 FileStream::~FileStream() 
@@ -55,7 +63,7 @@ FileStream &FileStream::operator=(const FileStream &stream) {
 		// create a new one patterend after the provided one
 		if(_FMODSound) _FMODSound->release();
 		_FMODSound = NULL;
-		createStreamFromFilename(stream.getFilename());
+		createStreamLike(stream);
 	}
 	return *this;
 }
@@ -94,6 +102,17 @@ void FileStream::setLooping(bool loop) {
 	} // if
 }
 
+void FileStream::setLoopPoints(unsigned int start,unsigned int end) {
+	if(_FMODSound)
+	{
+		// FMOD loop ends are inclusive
+		if(!end)
+			_FMODSound->getLength(&end, FMOD_TIMEUNIT_PCM);
+		if(end > start)
+			_FMODSound->setLoopPoints(start, FMOD_TIMEUNIT_PCM, end-1, FMOD_TIMEUNIT_PCM);
+	} // if
+}
+
 std::string FileStream::getFilename() const {
 	char filenameBuffer[1024];
 	filenameBuffer[0] = 0;
@@ -23,6 +23,10 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <iterator>
+#include <istream>
+#include <cstring>
+
 #include <osgAudio/Sample.h>
 #include <osgAudio/AudioEnvironment.h>
 #include <osgAudio/SoundManager.h>
@@ -32,16 +36,37 @@ using namespace osgAudio;
 
 Sample::Sample(const std::string& filename) throw (FileError,NameError) {
 	_FMODSound = NULL;
+	_compressed = false;
 
 	createSampleFromFilename(filename);
 
 } // Sample::Sample
 
 
+Sample::Sample(const std::string& filename, bool compressed) throw (FileError,NameError) {
+	_FMODSound = NULL;
+	_compressed = compressed;
+
+	createSampleFromFilename(filename);
+
+} // Sample::Sample
+
+
+Sample::Sample(std::istream& stream) throw (FileError,NameError) {
+	_FMODSound = NULL;
+	_compressed = false;
+
+	_memory.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	createSampleFromMemory();
+
+} // Sample::Sample
+
+
 Sample::Sample(const Sample &sample) {
 	_FMODSound = NULL;
+	_compressed = false;
 
-	createSampleFromFilename(sample.getFilename());
+	createSampleLike(sample);
 } // Sample::Sample
 
 
@@ -52,7 +77,8 @@ void Sample::createSampleFromFilename(const std::string& filename ) throw (FileE
 	FMOD_RESULT createResult;
 	createResult = osgAudio::AudioEnvironment::instance()->getSystem()->
      createSound(filename.c_str(),
-	 FMOD_3D | osgAudio::AudioEnvironment::instance()->getInternalDistanceModel(),
+	 FMOD_3D | (_compressed ? FMOD_CREATECOMPRESSEDSAMPLE : 0) |
+	 osgAudio::AudioEnvironment::instance()->getInternalDistanceModel(),
 	 0, &_FMODSound);
 
 	if(createResult != FMOD_OK)
@@ -71,6 +97,44 @@ void Sample::createSampleFromFilename(const std::string& filename ) throw (FileE
 } // Sample::createSampleFromFilename
 
 
+void Sample::createSampleFromMemory() throw (FileError,NameError)
+ {
+	_FMODSound = NULL;
+
+	if(_memory.empty())
+		throw FileError("No data to load Sample from.");
+
+	FMOD_CREATESOUNDEXINFO exinfo;
+	memset(&exinfo, 0, sizeof(exinfo));
+	exinfo.cbsize = sizeof(exinfo);
+	exinfo.length = _memory.size();
+
+	FMOD_RESULT createResult;
+	createResult = osgAudio::AudioEnvironment::instance()->getSystem()->
+     createSound(&_memory[0],
+	 FMOD_OPENMEMORY | FMOD_3D | osgAudio::AudioEnvironment::instance()->getInternalDistanceModel(),
+	 &exinfo, &_FMODSound);
+
+	if(createResult != FMOD_OK)
+	{
+		throw FileError("Unknown error loading Sample from memory.");
+	} // if
+} // Sample::createSampleFromMemory
+
+
+void Sample::createSampleLike(const Sample &sample) throw (FileError,NameError)
+ {
+	_compressed = sample._compressed;
+	if(sample._memory.empty())
+		createSampleFromFilename(sample.getFilename());
+	else
+	{
+		_memory = sample._memory;
+		createSampleFromMemory();
+	} // else
+} // Sample::createSampleLike
+
+
 // <<<>>> TODO: Create a portable way of specifying the format
 /*
 Sample::Sample(ALenum format,ALvoid* data,ALsizei size,ALsizei freq) throw (FileError)
@@ -99,7 +163,7 @@ Sample &Sample::operator=(const Sample &sample) {
 		// create a new one patterend after the provided one
 		if(_FMODSound) _FMODSound->release();
 		_FMODSound = NULL;
-		createSampleFromFilename(sample.getFilename());
+		createSampleLike(sample);
 	}
 	return *this;
 }
@@ -175,6 +175,23 @@ void Source::play( Stream *stream ) {
 	play();
 }
 
+bool Source::preroll( Stream *stream, float timeout ) {
+	setSound(stream);
+	if(_FMODChannel)
+	{
+		bool isPlaying;
+		_FMODChannel->isPlaying(&isPlaying);
+		if(isPlaying) // already has a channel, play() resumes it
+			return false;
+	} // if
+	// start paused, FMOD fills the stream buffer and play() only unpauses
+	FMOD_RESULT createResult = osgAudio::AudioEnvironment::instance()->getSystem()->playSound(FMOD_CHANNEL_FREE, _Sound->getInternalSound(), true, &_FMODChannel);
+	if(createResult != FMOD_OK)
+		return false;
+	initPitchSupport();
+	return true;
+} // Source::preroll
+
 void Source::play() {
 	bool isPlaying;
 	if(_FMODChannel)
@@ -23,6 +23,10 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <iterator>
+#include <istream>
+#include <cstring>
+
 #include <osgAudio/Stream.h>
 #include <osgAudio/BackendFMOD/AudioEnvironmentFMOD.h>
 #include <osgAudio/SoundManager.h>
@@ -35,7 +39,7 @@ Stream::Stream() throw (NameError) {
 
 Stream::Stream(const Stream &stream) {
 	_FMODSound = NULL;
-	createStreamFromFilename(stream.getFilename());
+	createStreamLike(stream);
 } // Stream::Stream
 
 Stream &Stream::operator=(const Stream &stream) {
@@ -45,7 +49,7 @@ Stream &Stream::operator=(const Stream &stream) {
 		// create a new one patterned after the provided one
 		if(_FMODSound) _FMODSound->release();
 		_FMODSound = NULL;
-		createStreamFromFilename(stream.getFilename());
+		createStreamLike(stream);
 	}
 	return *this;
 } // Stream::operator=
@@ -74,6 +78,48 @@ void Stream::createStreamFromFilename(const std::string& filename ) throw (FileE
     } // if
 } // Stream::createStreamFromFilename
 
+void Stream::createStreamFromStream(std::istream& stream ) throw (FileError,NameError)
+{
+	_memory.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	createStreamFromMemory();
+} // Stream::createStreamFromStream
+
+void Stream::createStreamFromMemory() throw (FileError,NameError)
+{
+	_FMODSound = NULL;
+	_filename = "";
+
+	if(_memory.empty())
+		throw FileError("No data to open Stream from.");
+
+	FMOD_CREATESOUNDEXINFO exinfo;
+	memset(&exinfo, 0, sizeof(exinfo));
+	exinfo.cbsize = sizeof(exinfo);
+	exinfo.length = _memory.size();
+
+	FMOD_RESULT createResult;
+	createResult = osgAudio::AudioEnvironment::instance()->
+		getSystem()->createSound(&_memory[0],
+		FMOD_OPENMEMORY | FMOD_3D | osgAudio::SoundManager::instance()->getEnvironment()->getInternalDistanceModel(),
+		&exinfo, &_FMODSound);
+
+	if(createResult != FMOD_OK)
+	{
+		throw FileError("Unknown error opening Stream from memory.");
+	} // if
+} // Stream::createStreamFromMemory
+
+void Stream::createStreamLike(const Stream &stream) throw (FileError,NameError)
+{
+	if(stream._memory.empty())
+		createStreamFromFilename(stream.getFilename());
+	else
+	{
+		_memory = stream._memory;
+		createStreamFromMemory();
+	} // else
+} // Stream::createStreamLike
+
 
 Stream::~Stream() {
 	// everything done in wrapped class
@@ -87,6 +87,42 @@ void AudioEnvironment::init(int frequency,int refresh) throw (InitError)
     }
 }
 
+void AudioEnvironment::initLoopback(unsigned int frequency,unsigned int channels,
+                                    bool floating,bool displayInitMsgs) throw (InitError)
+{
+    try 
+    {
+        _openalppAudioEnvironment = new openalpp::AudioEnvironment (
+            openalpp::RenderFormat(frequency, channels, floating), displayInitMsgs);
+    }
+    catch(openalpp::InitError error)
+    {
+        throw InitError(error.what());
+    }
+}
+
+bool AudioEnvironment::isLoopback()
+{
+    return _openalppAudioEnvironment.valid() && _openalppAudioEnvironment->isLoopback();
+}
+
+unsigned int AudioEnvironment::getRenderFrameSize()
+{
+    if(!isLoopback())
+        return 0;
+    return _openalppAudioEnvironment->getRenderFormat().getFrameSize();
+}
+
+void AudioEnvironment::render(void *buffer,unsigned int frames) throw (FatalError)
+{
+    if(!_openalppAudioEnvironment.valid())
+        throw FatalError("AudioEnvironment::render: Environment not initialized");
+    try {
+    _openalppAudioEnvironment->render (buffer, frames);
+    }
+    catch(openalpp::FatalError error) { throw FatalError(error.what()); }
+}
+
 AudioEnvironment::~AudioEnvironment()
 {
     if(_openalppAudioEnvironment.valid())
@@ -40,6 +40,17 @@ throw (NameError,InitError,FileError)
     catch(openalpp::FileError error) { throw FileError(error.what()); }
 }
 
+FileStream::FileStream(std::istream& stream,const int buffersize)
+throw (NameError,InitError,FileError) 
+: Stream(0) {
+    try {
+    _openalppStream = new openalpp::FileStream (stream, buffersize);
+    }
+    catch(openalpp::NameError error) { throw NameError(error.what()); }
+    catch(openalpp::InitError error) { throw InitError(error.what()); }
+    catch(openalpp::FileError error) { throw FileError(error.what()); }
+}
+
 FileStream::FileStream(const FileStream &stream)
 : Stream(0) {
     // static cast to our derived subclass.
@@ -67,6 +78,10 @@ void FileStream::setLooping(bool loop) {
     (static_cast<openalpp::FileStream *>(_openalppStream.get()))->setLooping(loop);
 }
 
+void FileStream::setLoopPoints(unsigned int start,unsigned int end) {
+    (static_cast<openalpp::FileStream *>(_openalppStream.get()))->setLoopPoints(start,end);
+}
+
 std::string FileStream::getFilename() const {
     // static cast to our derived subclass.
     // Cast could only fail if everything were amiss,
@@ -38,6 +38,26 @@ Sample::Sample(const std::string& filename) throw (FileError,NameError) {
     catch(openalpp::FileError error) { throw FileError(error.what()); }
 }
 
+Sample::Sample(const std::string& filename, bool compressed) throw (FileError,NameError) {
+    try {
+    _openalppSample = new openalpp::Sample (filename,
+        compressed ? openalpp::Sample::Compressed : openalpp::Sample::Decoded);
+    }
+    catch(openalpp::NameError error) { throw NameError(error.what()); }
+    catch(openalpp::FileError error) { throw FileError(error.what()); }
+}
+
+Sample::Sample(std::istream& stream) throw (FileError,NameError) {
+    try {
+    _openalppSample = new openalpp::Sample (stream);
+    }
+    catch(openalpp::NameError error) { throw NameError(error.what()); }
+    catch(openalpp::FileError error) { throw FileError(error.what()); }
+}
+
+Sample::Sample(openalpp::Sample *sample) : _openalppSample(sample) {
+}
+
 Sample::Sample(const Sample &sample) {
     _openalppSample = new openalpp::Sample (*(sample.getInternalSample()));
 }
@@ -54,6 +74,10 @@ std::string Sample::getFilename() const {
     return _openalppSample->getFileName();
 }
 
+bool Sample::isCompressed() const {
+    return _openalppSample->getResidency() == openalpp::Sample::Compressed;
+}
+
 
 Sample::~Sample()
 {
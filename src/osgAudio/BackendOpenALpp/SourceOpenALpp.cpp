@@ -127,6 +127,10 @@ void Source::play( Stream *stream ) {
     _openalppSource->play(stream->getInternalStream()); // need access to internal openAL version of Stream
 }
 
+bool Source::preroll( Stream *stream, float timeout ) {
+    return _openalppSource->preroll(stream->getInternalStream(),timeout);
+}
+
 void Source::play() {
     _openalppSource->play();
 }
@@ -0,0 +1,76 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <osgAudio/PortalOccludeCallback.h>
+#include <osgAudio/SoundState.h>
+
+using namespace osgAudio;
+
+
+PortalOccludeCallback::PortalOccludeCallback(osg::Node *root) : OccludeCallback(root),
+m_graph(new SoundPropagationGraph(root)), m_direct_raycast(false)
+{
+}
+
+PortalOccludeCallback::PortalOccludeCallback() : OccludeCallback(),
+m_graph(new SoundPropagationGraph()), m_direct_raycast(false)
+{
+}
+
+void PortalOccludeCallback::apply(const osg::Matrix& listener_matrix, const osg::Vec3& sound_pos, osgAudio::SoundState* sound_state)
+{
+    m_sound_state = sound_state;
+
+    // The occluding node might have been replaced (when read from file for example)
+    if (m_graph->getRoot() != m_root.get())
+        m_graph->setRoot(m_root.get());
+
+    osg::Matrix m = listener_matrix.inverse(listener_matrix);
+
+    SoundPropagationGraph::Path path;
+    m_graph->computePath(m.getTrans(), sound_pos, path);
+
+    if (path.direct) {
+        if (m_direct_raycast) {
+            OccludeCallback::apply(listener_matrix, sound_pos, sound_state);
+            return;
+        }
+
+        if (sound_state->getOccluded()) {
+            sound_state->setOccludeScale(1.0f);
+            sound_state->setOccluded(false);
+        }
+        m_was_occluded = false;
+        return;
+    }
+
+    // Heard through the portals, or not at all
+    if (path.reachable)
+        sound_state->setPosition(path.virtual_position);
+
+    sound_state->setOccludeScale(path.attenuation);
+    sound_state->setOccluded(true);
+    m_was_occluded = true;
+}
@@ -0,0 +1,233 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <fstream>
+#include <vector>
+#include <cstring>
+
+#include <osgAudio/SoundInfo.h>
+
+using namespace osgAudio;
+
+
+namespace {
+
+    unsigned int readLE(const unsigned char *p, unsigned int bytes)
+    {
+        unsigned int value = 0;
+        for (unsigned int i = bytes; i > 0; i--)
+            value = (value << 8) | p[i-1];
+        return value;
+    }
+
+    bool readBytes(std::istream& stream, unsigned char *buffer, std::streamsize size)
+    {
+        stream.read((char *)buffer, size);
+        return stream.gcount() == size;
+    }
+
+} // namespace
+
+
+SoundInfo::SoundInfo() : m_format(UNKNOWN), m_compressed(false), m_channels(0), m_frequency(0), m_bits(0), m_frames(0)
+{
+}
+
+bool SoundInfo::read(const std::string& path)
+{
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if (!file)
+        return false;
+
+    return read(file);
+}
+
+bool SoundInfo::read(std::istream& stream)
+{
+    *this = SoundInfo();
+
+    std::istream::pos_type start = stream.tellg();
+    unsigned char magic[4];
+    if (!readBytes(stream, magic, 4))
+        return false;
+    stream.seekg(start);
+
+    bool ok = false;
+    if (!memcmp(magic, "RIFF", 4))
+        ok = readWave(stream);
+    else if (!memcmp(magic, "OggS", 4))
+        ok = readOgg(stream);
+    else if (!memcmp(magic, "fLaC", 4))
+        ok = readFlac(stream);
+
+    if (!ok)
+        *this = SoundInfo();
+    return ok;
+}
+
+bool SoundInfo::readWave(std::istream& stream)
+{
+    unsigned char header[12];
+    if (!readBytes(stream, header, 12) || memcmp(header+8, "WAVE", 4))
+        return false;
+
+    unsigned int tag = 0, align = 0, bits = 0;
+    unsigned long fact = 0;
+    bool have_fmt = false;
+
+    unsigned char chunk[8];
+    while (readBytes(stream, chunk, 8)) {
+        unsigned long size = readLE(chunk+4, 4);
+
+        if (!memcmp(chunk, "fmt ", 4) && size >= 16) {
+            unsigned char fmt[16];
+            if (!readBytes(stream, fmt, 16))
+                return false;
+            tag = readLE(fmt, 2);
+            m_channels = readLE(fmt+2, 2);
+            m_frequency = readLE(fmt+4, 4);
+            align = readLE(fmt+12, 2);
+            bits = readLE(fmt+14, 2);
+            have_fmt = true;
+            size -= 16;
+        }
+        else if (!memcmp(chunk, "fact", 4) && size >= 4) {
+            unsigned char frames[4];
+            if (!readBytes(stream, frames, 4))
+                return false;
+            fact = readLE(frames, 4);
+            size -= 4;
+        }
+        else if (!memcmp(chunk, "data", 4)) {
+            if (!have_fmt || !m_channels || !align)
+                return false;
+
+            m_format = WAVE;
+            // PCM, float and extensible are stored as they are played,
+            // anything else is compressed and decoded to 16 bits
+            if (tag == 1 || tag == 3 || tag == 0xFFFE) {
+                m_bits = bits;
+                m_frames = size/align;
+            }
+            else {
+                m_compressed = true;
+                m_bits = 16;
+                m_frames = fact;
+            }
+            return true;
+        }
+
+        // Chunks are padded to an even size
+        stream.seekg((std::streamoff)(size + (size & 1)), std::ios::cur);
+    }
+
+    return false;
+}
+
+bool SoundInfo::readOgg(std::istream& stream)
+{
+    std::istream::pos_type start = stream.tellg();
+
+    // The first page holds the identification header only
+    unsigned char page[27+255];
+    if (!readBytes(stream, page, 27))
+        return false;
+    unsigned int segments = page[26];
+    unsigned int serial = readLE(page+14, 4);
+    if (!readBytes(stream, page+27, segments))
+        return false;
+
+    unsigned char id[16];
+    if (!readBytes(stream, id, 16))
+        return false;
+
+    // Opus is decoded at 48 kHz, starting pre_skip frames into the stream
+    unsigned int pre_skip = 0;
+    if (id[0] == 1 && !memcmp(id+1, "vorbis", 6)) {
+        m_channels = id[11];
+        m_frequency = readLE(id+12, 4);
+    }
+    else if (!memcmp(id, "OpusHead", 8)) {
+        m_channels = id[9];
+        m_frequency = 48000;
+        pre_skip = readLE(id+10, 2);
+    }
+    else
+        return false;
+    m_bits = 16;
+    if (!m_channels || !m_frequency)
+        return false;
+    const Format format = id[0] == 1 ? OGG_VORBIS : OGG_OPUS;
+
+    // The granule position of the last page is the length in sample frames.
+    // Pages are at most 65307 bytes, so the last one starts within the last 64k.
+    stream.seekg(0, std::ios::end);
+    std::streamoff size = stream.tellg() - start;
+    std::streamoff window = size < 65536+27 ? size : 65536+27;
+    std::vector<unsigned char> tail((size_t)window);
+    stream.seekg(-window, std::ios::end);
+    if (!readBytes(stream, &tail[0], window))
+        return false;
+
+    m_format = format;
+    for (std::streamoff i = window-27; i >= 0; i--) {
+        const unsigned char *p = &tail[(size_t)i];
+        if (memcmp(p, "OggS", 4) || readLE(p+14, 4) != serial)
+            continue;
+
+        unsigned int low = readLE(p+6, 4), high = readLE(p+10, 4);
+        if (low == 0xFFFFFFFF && high == 0xFFFFFFFF)
+            continue;   // No packet ends on this page
+
+        m_frames = high ? 0xFFFFFFFF : low;
+        m_frames = m_frames > pre_skip ? m_frames - pre_skip : 0;
+        break;
+    }
+
+    return true;
+}
+
+bool SoundInfo::readFlac(std::istream& stream)
+{
+    // The STREAMINFO metadata block always comes first
+    unsigned char header[8+34];
+    if (!readBytes(stream, header, sizeof(header)) || (header[4] & 0x7F) != 0)
+        return false;
+
+    const unsigned char *info = header+8;
+    m_frequency = (info[10] << 12) | (info[11] << 4) | (info[12] >> 4);
+    m_channels = ((info[12] >> 1) & 0x07) + 1;
+    m_bits = 16;
+    // 36 bits of total samples, 0 if unknown
+    if (info[13] & 0x0F)
+        m_frames = 0xFFFFFFFF;
+    else
+        m_frames = ((unsigned long)info[14] << 24) | (info[15] << 16) | (info[16] << 8) | info[17];
+    if (!m_frequency)
+        return false;
+
+    m_format = FLAC;
+    return true;
+}
@@ -29,6 +29,11 @@
 #include <osgDB/FileUtils>
 
 #include <osgAudio/SoundManager.h>
+#include <osgAudio/SoundInfo.h>
+
+#ifdef ENABLE_SUBSYSTEM_OPENAL
+#include <openalpp/SoundBank.h>
+#endif // ENABLE_SUBSYSTEM_OPENAL
 
 using namespace osgAudio;
 
@@ -74,9 +79,11 @@ SoundManager::SoundManager()
     m_sound_state_FlyWeight(0),
     m_listener(0), 
     m_sound_environment(0),  
+    m_max_sample_size(2*1024*1024),
+    m_max_sample_duration(10.0f),
     m_initialized(false), 
     m_max_velocity(2),
-    m_last_tick(0),
+    m_last_time(0),
     m_first_run(true),
 #ifdef WIN32
     m_clamp_velocity(false),
@@ -100,7 +107,9 @@ void SoundManager::init(unsigned int num_soundsources, float sound_velocity, boo
     if( !m_sound_environment )
     {
         m_sound_environment = osgAudio::AudioEnvironment::instance();
-        m_sound_environment->init( displayInitMsgs );
+        // Keep an environment the application set up with initLoopback()
+        if( !m_sound_environment->isLoopback() )
+            m_sound_environment->init( displayInitMsgs );
     }
 
     if (!m_listener) {
@@ -404,7 +413,7 @@ void SoundManager::resetSource(Source *source)
     source->rewind();
 }
 
-Sample* SoundManager::getSample( const std::string& path, bool add_to_cache )
+Sample* SoundManager::getSample( const std::string& path, bool add_to_cache, bool compressed )
 {
 
     osg::ref_ptr<Sample> sample;
@@ -419,14 +428,17 @@ Sample* SoundManager::getSample( const std::string& path, bool add_to_cache )
     else {
         osg::notify(osg::INFO) << "SoundManager::getSample(): Cache miss for " << path << ". Loading from file..." << std::endl;
 
-        // Cache miss, load the file:
-        std::string new_path = osgDB::findDataFile(path);
-        if (new_path.empty()) {
-            osg::notify(osg::WARN) << "SoundManager::getSample(): Unable to find requested file: " << path << std::endl;
-            return 0;
-        }
+        sample = getBankSample(path, compressed);
+        if (!sample.valid()) {
+            // Cache miss, load the file:
+            std::string new_path = osgDB::findDataFile(path);
+            if (new_path.empty()) {
+                osg::notify(osg::WARN) << "SoundManager::getSample(): Unable to find requested file: " << path << std::endl;
+                return 0;
+            }
 
-        sample = new Sample(new_path);
+            sample = new Sample(new_path, compressed);
+        }
 
         // if the loading of the model was successful, store the sample in the cache
         // except if the user have indicated that it shouldn't be added to the cache
@@ -439,6 +451,53 @@ Sample* SoundManager::getSample( const std::string& path, bool add_to_cache )
 }
 
 
+bool SoundManager::mountSoundBank( const std::string& path )
+{
+#ifdef ENABLE_SUBSYSTEM_OPENAL
+    std::string new_path = osgDB::findDataFile(path);
+    if (new_path.empty()) {
+        osg::notify(osg::WARN) << "SoundManager::mountSoundBank(): Unable to find requested file: " << path << std::endl;
+        return false;
+    }
+
+    try {
+        openalpp::SoundBank *bank = new openalpp::SoundBank(new_path);
+        m_sound_banks.push_back(bank);
+        osg::notify(osg::INFO) << "SoundManager::mountSoundBank(): Mounted " << bank->getEntries().size()
+            << " sounds from " << path << std::endl;
+    }
+    catch(openalpp::FileError error) {
+        osg::notify(osg::WARN) << "SoundManager::mountSoundBank(): " << error.what() << std::endl;
+        return false;
+    }
+    return true;
+#else
+    osg::notify(osg::WARN) << "SoundManager::mountSoundBank(): Sound banks aren't supported by this audio subsystem" << std::endl;
+    return false;
+#endif // ENABLE_SUBSYSTEM_OPENAL
+}
+
+Sample* SoundManager::getBankSample( const std::string& path, bool compressed )
+{
+#ifdef ENABLE_SUBSYSTEM_OPENAL
+    for (unsigned int i = m_sound_banks.size(); i-- > 0; ) {
+        openalpp::SoundBank *bank = static_cast<openalpp::SoundBank *>(m_sound_banks[i].get());
+        if (!bank->find(path))
+            continue;
+
+        try {
+            return new Sample(bank->createSample(path,
+                compressed ? openalpp::Sample::Compressed : openalpp::Sample::Decoded));
+        }
+        catch(openalpp::Error error) {
+            osg::notify(osg::WARN) << "SoundManager::getSample(): Unable to load " << path << " from sound bank: " << error.what() << std::endl;
+        }
+    }
+#endif // ENABLE_SUBSYSTEM_OPENAL
+    return 0;
+}
+
+
 Stream* SoundManager::getStream( const std::string& path, bool add_to_cache )
 {
     FileStream *stream=0;
@@ -476,6 +535,54 @@ Stream* SoundManager::getStream( const std::string& path, bool add_to_cache )
     return stream;
 }
 
+osg::Referenced* SoundManager::getSound( const std::string& path, bool add_to_cache )
+{
+    // Loaded before, one way or the other
+    if (m_sample_cache.find(path) != m_sample_cache.end())
+        return getSample(path, add_to_cache);
+    if (m_stream_cache.find(path) != m_stream_cache.end())
+        return getStream(path, add_to_cache);
+
+#ifdef ENABLE_SUBSYSTEM_OPENAL
+    // Banks are made for samples
+    for (unsigned int i = m_sound_banks.size(); i-- > 0; ) {
+        if (static_cast<openalpp::SoundBank *>(m_sound_banks[i].get())->find(path))
+            return getSample(path, add_to_cache);
+    }
+#endif // ENABLE_SUBSYSTEM_OPENAL
+
+    std::string new_path = osgDB::findDataFile(path);
+    if (new_path.empty()) {
+        osg::notify(osg::WARN) << "SoundManager::getSound(): Unable to find requested file: " << path << std::endl;
+        return 0;
+    }
+
+    SoundInfo info;
+    if (!info.read(new_path)) {
+        osg::notify(osg::INFO) << "SoundManager::getSound(): Unknown format of " << path << ", loading it as a sample" << std::endl;
+        return getSample(path, add_to_cache);
+    }
+
+#ifdef ENABLE_SUBSYSTEM_FMOD
+    const bool streamable = true;
+#else
+    // FileStream decodes everything SoundInfo knows, except compressed WAV files
+    const bool streamable = !info.isCompressed();
+#endif
+
+    const bool large = info.getDecodedSize() > m_max_sample_size ||
+        info.getDuration() > m_max_sample_duration;
+
+    osg::notify(osg::INFO) << "SoundManager::getSound(): " << path << " is " << info.getDuration() << " s, "
+        << info.getDecodedSize() << " bytes decoded" << std::endl;
+
+    if (large && streamable)
+        return getStream(path, add_to_cache);
+
+    // Large files that can't be streamed are kept compressed until played
+    return getSample(path, add_to_cache, large);
+}
+
 SoundState *SoundManager::findSoundState(const std::string& id)
 {
     for (SoundStateSet::iterator it = m_sound_states.begin();
@@ -501,6 +608,11 @@ void SoundManager::setListenerDirection(const osg::Vec3& dir)
 }
 
 void SoundManager::setListenerMatrix( const osg::Matrix& matrix)
+{
+    setListenerMatrix( matrix, m_timer.time_s() );
+}
+
+void SoundManager::setListenerMatrix( const osg::Matrix& matrix, double time )
 {
 
     m_listener_matrix = matrix;
@@ -517,18 +629,15 @@ void SoundManager::setListenerMatrix( const osg::Matrix& matrix)
 
     if (m_first_run) {
         m_first_run = false;
-        m_last_tick = m_timer.tick();
+        m_last_time = time;
         m_last_pos = eye_pos;
     }
-    else {
-        osg::Timer_t curr_tick = m_timer.tick();
-
+    else if (time > m_last_time) {
         velocity = eye_pos - m_last_pos;
         m_last_pos = eye_pos;
 
-        double time = m_timer.delta_s(m_last_tick, curr_tick);
-        m_last_tick = curr_tick;
-        velocity /= time;
+        velocity /= time - m_last_time;
+        m_last_time = time;
     }
 
     const osg::Vec3& listener_direction = getListenerDirection();
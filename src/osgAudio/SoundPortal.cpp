@@ -0,0 +1,63 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <osgAudio/SoundPortal.h>
+
+using namespace osg;
+using namespace osgAudio;
+
+
+SoundPortal::SoundPortal()
+  : osg::Node(),
+    m_center(0,0,0),
+    m_transmission(1.0f)
+{
+}
+
+
+SoundPortal & SoundPortal::operator=(const SoundPortal &node)
+{
+    if (this == &node) return *this;
+
+    m_room_a = node.m_room_a;
+    m_room_b = node.m_room_b;
+    m_center = node.m_center;
+    m_transmission = node.m_transmission;
+
+    return *this;
+}
+
+
+SoundPortal::SoundPortal(const SoundPortal &copy, const osg::CopyOp &copyop)
+  : osg::Node( copy, copyop )
+{
+    *this = copy;
+}
+
+
+osg::BoundingSphere SoundPortal::computeBound() const
+{
+    return osg::BoundingSphere(m_center, 0.0f);
+}
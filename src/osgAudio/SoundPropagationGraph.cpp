@@ -0,0 +1,293 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <queue>
+#include <functional>
+#include <cfloat>
+
+#include <osg/NodeVisitor>
+#include <osg/Transform>
+#include <osg/Notify>
+
+#include <osgAudio/SoundPropagationGraph.h>
+
+using namespace osgAudio;
+
+
+namespace osgAudio {
+
+    /// Collects all SoundRoom and SoundPortal nodes, in world coordinates
+    class CollectSoundRoomsVisitor : public osg::NodeVisitor {
+    public:
+        CollectSoundRoomsVisitor(SoundPropagationGraph& graph)
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN), m_graph(graph) {}
+
+        virtual void apply(osg::Node& node)
+        {
+            SoundRoom *room = dynamic_cast<SoundRoom *>(&node);
+            SoundPortal *portal = dynamic_cast<SoundPortal *>(&node);
+
+            if (room || portal) {
+                const osg::Matrix m( osg::computeLocalToWorld( getNodePath() ) );
+
+                if (room) {
+                    osg::BoundingBox local = room->computeRoomBounds();
+                    SoundPropagationGraph::Room r;
+                    r.name = room->getName();
+                    if (local.valid())
+                        for (unsigned int i = 0; i < 8; i++)
+                            r.bounds.expandBy(local.corner(i) * m);
+                    m_graph.m_rooms.push_back(r);
+                }
+                else {
+                    SoundPropagationGraph::Portal p;
+                    p.node = portal;
+                    p.position = portal->getCenter() * m;
+                    p.rooms[0] = p.rooms[1] = 0;
+                    m_graph.m_portals.push_back(p);
+                }
+            }
+
+            traverse(node);
+        }
+
+    protected:
+        CollectSoundRoomsVisitor& operator=(const CollectSoundRoomsVisitor&) { return *this; }
+
+        SoundPropagationGraph& m_graph;
+    };
+
+} // namespace osgAudio
+
+
+SoundPropagationGraph::SoundPropagationGraph(osg::Node *root) : m_root(root), m_dirty(true),
+m_listener_room(0), m_listener_valid(false)
+{
+}
+
+void SoundPropagationGraph::build()
+{
+    m_dirty = false;
+    m_listener_valid = false;
+
+    m_rooms.clear();
+    m_portals.clear();
+
+    // Room 0 is the exterior, everything not inside any other room
+    m_rooms.push_back(Room());
+
+    if (!m_root.valid())
+        return;
+
+    CollectSoundRoomsVisitor crv(*this);
+    m_root->accept(crv);
+
+    // Connect the portals with the rooms, by name
+    for (unsigned int p = 0; p < m_portals.size(); ) {
+        const SoundPortal *node = m_portals[p].node.get();
+        const std::string names[2] = { node->getRoomA(), node->getRoomB() };
+        bool found[2] = { false, false };
+
+        for (unsigned int side = 0; side < 2; side++) {
+            if (names[side].empty()) {
+                m_portals[p].rooms[side] = 0;
+                found[side] = true;
+                continue;
+            }
+            for (unsigned int r = 1; r < m_rooms.size() && !found[side]; r++) {
+                if (m_rooms[r].name == names[side]) {
+                    m_portals[p].rooms[side] = r;
+                    found[side] = true;
+                }
+            }
+        }
+
+        if (!found[0] || !found[1] || m_portals[p].rooms[0] == m_portals[p].rooms[1]) {
+            osg::notify(osg::WARN) << "SoundPropagationGraph: Ignoring portal \"" << node->getName()
+                << "\" between \"" << names[0] << "\" and \"" << names[1] << "\"" << std::endl;
+            m_portals.erase(m_portals.begin() + p);
+            continue;
+        }
+
+        m_rooms[m_portals[p].rooms[0]].portals.push_back(p);
+        m_rooms[m_portals[p].rooms[1]].portals.push_back(p);
+        p++;
+    }
+
+    m_distance.resize(m_portals.size());
+    m_previous.resize(m_portals.size());
+    m_transmissions.assign(m_portals.size(), -1.0f);
+}
+
+unsigned int SoundPropagationGraph::findRoom(const osg::Vec3& pos) const
+{
+    unsigned int room = 0;
+    float smallest = FLT_MAX;
+
+    // Pick the smallest room, so that rooms can be nested
+    for (unsigned int r = 1; r < m_rooms.size(); r++) {
+        const osg::BoundingBox& bb = m_rooms[r].bounds;
+        if (!bb.valid() || !bb.contains(pos))
+            continue;
+
+        float volume = (bb.xMax()-bb.xMin()) * (bb.yMax()-bb.yMin()) * (bb.zMax()-bb.zMin());
+        if (volume < smallest) {
+            smallest = volume;
+            room = r;
+        }
+    }
+
+    return room;
+}
+
+float SoundPropagationGraph::getTransmission(unsigned int portal) const
+{
+    const SoundPortal *node = m_portals[portal].node.get();
+    if (!node || !node->isOpen())
+        return 0.0f;
+
+    return node->getTransmission();
+}
+
+void SoundPropagationGraph::updateListener(const osg::Vec3& listener_pos)
+{
+    // Has any portal been opened or closed since last time?
+    bool changed = false;
+    for (unsigned int p = 0; p < m_portals.size(); p++) {
+        float t = getTransmission(p);
+        if (t != m_transmissions[p]) {
+            m_transmissions[p] = t;
+            changed = true;
+        }
+    }
+
+    if (m_listener_valid && !changed && listener_pos == m_listener_pos)
+        return;
+
+    m_listener_valid = true;
+    m_listener_pos = listener_pos;
+    m_listener_room = findRoom(listener_pos);
+
+    // Dijkstra from the listener over the open portals
+    typedef std::pair<float, unsigned int> QueueEntry;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+
+    m_distance.assign(m_portals.size(), FLT_MAX);
+    m_previous.assign(m_portals.size(), -1);
+
+    const std::vector<unsigned int>& start = m_rooms[m_listener_room].portals;
+    for (unsigned int i = 0; i < start.size(); i++) {
+        unsigned int p = start[i];
+        if (m_transmissions[p] <= 0.0f)
+            continue;
+        m_distance[p] = (m_portals[p].position - listener_pos).length();
+        queue.push(QueueEntry(m_distance[p], p));
+    }
+
+    while (!queue.empty()) {
+        QueueEntry e = queue.top();
+        queue.pop();
+
+        unsigned int p = e.second;
+        if (e.first > m_distance[p])
+            continue;
+
+        // Continue into both rooms connected by the portal
+        for (unsigned int side = 0; side < 2; side++) {
+            const std::vector<unsigned int>& next = m_rooms[m_portals[p].rooms[side]].portals;
+            for (unsigned int i = 0; i < next.size(); i++) {
+                unsigned int q = next[i];
+                if (q == p || m_transmissions[q] <= 0.0f)
+                    continue;
+
+                float d = e.first + (m_portals[q].position - m_portals[p].position).length();
+                if (d < m_distance[q]) {
+                    m_distance[q] = d;
+                    m_previous[q] = p;
+                    queue.push(QueueEntry(d, q));
+                }
+            }
+        }
+    }
+}
+
+void SoundPropagationGraph::computePath(const osg::Vec3& listener_pos, const osg::Vec3& sound_pos, Path& path)
+{
+    if (m_dirty)
+        build();
+
+    updateListener(listener_pos);
+
+    path = Path();
+    path.virtual_position = sound_pos;
+
+    unsigned int room = findRoom(sound_pos);
+    if (room == m_listener_room) {
+        path.reachable = true;
+        path.distance = (sound_pos - listener_pos).length();
+        return;
+    }
+
+    path.direct = false;
+    path.attenuation = 0.0f;
+
+    // Find the cheapest portal of the emitter room
+    int last = -1;
+    float best = FLT_MAX;
+    const std::vector<unsigned int>& portals = m_rooms[room].portals;
+    for (unsigned int i = 0; i < portals.size(); i++) {
+        unsigned int q = portals[i];
+        if (m_distance[q] == FLT_MAX)
+            continue;
+
+        float d = m_distance[q] + (sound_pos - m_portals[q].position).length();
+        if (d < best) {
+            best = d;
+            last = q;
+        }
+    }
+
+    if (last < 0)
+        return;
+
+    // Walk back towards the listener, accumulating the attenuation
+    int first = last;
+    float attenuation = 1.0f;
+    for (int p = last; p >= 0; p = m_previous[p]) {
+        attenuation *= m_transmissions[p];
+        first = p;
+    }
+
+    // The sound is heard from the direction of the first portal, at the full path distance
+    osg::Vec3 dir = m_portals[first].position - listener_pos;
+    if (dir.length2() == 0.0f)
+        dir = sound_pos - listener_pos;
+    dir.normalize();
+
+    path.reachable = true;
+    path.attenuation = attenuation;
+    path.distance = best;
+    path.virtual_position = listener_pos + dir * best;
+}
@@ -0,0 +1,71 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <osg/ComputeBoundsVisitor>
+
+#include <osgAudio/SoundRoom.h>
+
+using namespace osg;
+using namespace osgAudio;
+
+
+SoundRoom::SoundRoom()
+  : osg::Group()
+{
+}
+
+
+SoundRoom & SoundRoom::operator=(const SoundRoom &node)
+{
+    if (this == &node) return *this;
+
+    m_room_bounds = node.m_room_bounds;
+
+    return *this;
+}
+
+
+SoundRoom::SoundRoom(const SoundRoom &copy, const osg::CopyOp &copyop)
+  : osg::Group( copy, copyop )
+{
+    *this = copy;
+}
+
+
+osg::BoundingBox SoundRoom::computeRoomBounds() const
+{
+    if (m_room_bounds.valid())
+        return m_room_bounds;
+
+    // No explicit volume, use the local bounds of the children
+    osg::BoundingBox bb;
+    for (unsigned int i = 0; i < getNumChildren(); i++) {
+        osg::ComputeBoundsVisitor cbv;
+        const_cast<osg::Node*>(getChild(i))->accept(cbv);
+        bb.expandBy(cbv.getBoundingBox());
+    }
+
+    return bb;
+}
@@ -140,7 +140,7 @@ void SoundRoot::update( osg::NodeVisitor* nv )
             if( getCamera() != NULL )
             {
                 osg::Matrixd m( getCamera()->getViewMatrix() );
-                osgAudio::SoundManager::instance()->setListenerMatrix( m );
+                osgAudio::SoundManager::instance()->setListenerMatrix( m, curr_time );
             }
         }
     }
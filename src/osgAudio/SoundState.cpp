@@ -316,6 +316,31 @@ void SoundState::apply()
     setAll(false);
 }
 
+void SoundState::setSound(osg::Referenced *sound)
+{
+    if (osgAudio::Stream *stream = dynamic_cast<osgAudio::Stream *>(sound))
+        setStream(stream);
+    else if (osgAudio::Sample *sample = dynamic_cast<osgAudio::Sample *>(sound))
+        setSample(sample);
+    else
+        osg::notify(osg::WARN) << "SoundState::setSound(): Neither a sample nor a stream" << std::endl;
+}
+
+bool SoundState::preroll(float timeout)
+{
+    if (!m_source.valid() || !m_stream.valid() || isPlaying())
+        return false;
+
+    // Bring the source up to date, but leave starting it to setPlay()
+    bool play = isSet(Play);
+    clear(Play);
+    apply();
+    if (play)
+        set(Play);
+
+    return m_source->preroll(m_stream.get(), timeout);
+}
+
 void SoundState::setEnable(bool flag)
 {
     if (!flag && m_source.valid())
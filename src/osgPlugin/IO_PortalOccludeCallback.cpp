@@ -0,0 +1,76 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <osgAudio/PortalOccludeCallback.h>
+
+#include <osgDB/Registry>
+#include <osgDB/Input>
+#include <osgDB/Output>
+
+using namespace osgAudio;
+using namespace osg;
+using namespace osgDB;
+
+// forward declare functions to use later.
+bool PortalOccludeCallback_readLocalData(Object& obj, Input& fr);
+bool PortalOccludeCallback_writeLocalData(const Object& obj, Output& fw);
+
+// register the read and write functions with the osgDB::Registry.
+// The occluding node and the near threshold are handled by the OccludeCallback wrapper.
+RegisterDotOsgWrapperProxy PortalOccludeCallbackProxy
+(
+ new osgAudio::PortalOccludeCallback,
+ "osgAudio::PortalOccludeCallback",
+ "Object osgAudio::OccludeCallback osgAudio::PortalOccludeCallback",
+ &PortalOccludeCallback_readLocalData,
+ &PortalOccludeCallback_writeLocalData
+ );
+
+bool PortalOccludeCallback_readLocalData(osg::Object &obj, osgDB::Input &fr)
+{
+    PortalOccludeCallback &oc = static_cast<PortalOccludeCallback&>(obj);
+
+    if (fr[0].matchWord("directRaycast")) {
+        if (fr[1].matchWord("TRUE"))
+            oc.setDirectRaycast(true);
+        else if (fr[1].matchWord("FALSE"))
+            oc.setDirectRaycast(false);
+        fr += 2;
+    } else
+        return false;
+
+    return true;
+}
+
+bool PortalOccludeCallback_writeLocalData(const Object& obj, Output& fw)
+{
+    const PortalOccludeCallback &oc = static_cast<const PortalOccludeCallback&>(obj);
+
+    fw.indent() << "directRaycast ";
+    if (oc.getDirectRaycast()) fw << "TRUE"<< std::endl;
+    else fw << "FALSE"<< std::endl;
+
+    return true;
+}
@@ -0,0 +1,82 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <osgAudio/SoundPortal.h>
+
+#include <osgDB/Registry>
+#include <osgDB/Input>
+#include <osgDB/Output>
+
+using namespace osgAudio;
+using namespace osg;
+using namespace osgDB;
+
+// forward declare functions to use later.
+bool SoundPortal_readLocalData(Object& obj, Input& fr);
+bool SoundPortal_writeLocalData(const Object& obj, Output& fw);
+
+// register the read and write functions with the osgDB::Registry.
+RegisterDotOsgWrapperProxy SoundPortalProxy
+(
+ new osgAudio::SoundPortal,
+ "osgAudio::SoundPortal",
+ "Object Node osgAudio::SoundPortal",
+ &SoundPortal_readLocalData,
+ &SoundPortal_writeLocalData
+ );
+
+bool SoundPortal_readLocalData(osg::Object &obj, osgDB::Input &fr)
+{
+    SoundPortal &portal = static_cast<SoundPortal&>(obj);
+
+    if (fr.matchSequence("rooms %s %s")) {
+        portal.setRooms(fr[1].getStr(), fr[2].getStr());
+        fr += 3;
+    } else if (fr.matchSequence("center %f %f %f")) {
+        float x, y, z;
+        fr[1].getFloat(x); fr[2].getFloat(y); fr[3].getFloat(z);
+        portal.setCenter(osg::Vec3(x, y, z));
+        fr += 4;
+    } else if (fr.matchSequence("transmission %f")) {
+        float f;
+        fr[1].getFloat(f);
+        portal.setTransmission(f);
+        fr += 2;
+    } else
+        return false;
+
+    return true;
+}
+
+bool SoundPortal_writeLocalData(const Object& obj, Output& fw)
+{
+    const SoundPortal &portal = static_cast<const SoundPortal&>(obj);
+
+    fw.indent() << "rooms \"" << portal.getRoomA() << "\" \"" << portal.getRoomB() << "\"" << std::endl;
+    fw.indent() << "center " << portal.getCenter().x() << " " << portal.getCenter().y() << " " << portal.getCenter().z() << std::endl;
+    fw.indent() << "transmission " << portal.getTransmission() << std::endl;
+
+    return true;
+}
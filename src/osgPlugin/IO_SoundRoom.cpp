@@ -0,0 +1,76 @@
+/* -*-c++-*- */
+/**
+ * osgAudio - OpenSceneGraph Audio Library
+ * (C) Copyright 2009-2012 by Kenneth Mark Bryden
+ * (programming by Chris 'Xenon' Hanson, AlphaPixel, LLC xenon at alphapixel.com)
+ * based on a fork of:
+ * Osg AL - OpenSceneGraph Audio Library
+ * Copyright (C) 2004 VRlab, Ume University
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * Please see COPYING file for special static-link exemption to LGPL.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <osgAudio/SoundRoom.h>
+
+#include <osgDB/Registry>
+#include <osgDB/Input>
+#include <osgDB/Output>
+
+using namespace osgAudio;
+using namespace osg;
+using namespace osgDB;
+
+// forward declare functions to use later.
+bool SoundRoom_readLocalData(Object& obj, Input& fr);
+bool SoundRoom_writeLocalData(const Object& obj, Output& fw);
+
+// register the read and write functions with the osgDB::Registry.
+RegisterDotOsgWrapperProxy SoundRoomProxy
+(
+ new osgAudio::SoundRoom,
+ "osgAudio::SoundRoom",
+ "Object Node Group osgAudio::SoundRoom",
+ &SoundRoom_readLocalData,
+ &SoundRoom_writeLocalData
+ );
+
+bool SoundRoom_readLocalData(osg::Object &obj, osgDB::Input &fr)
+{
+    SoundRoom &room = static_cast<SoundRoom&>(obj);
+
+    if (fr.matchSequence("roomBounds %f %f %f %f %f %f")) {
+        float f[6];
+        for (unsigned int i = 0; i < 6; i++)
+            fr[i+1].getFloat(f[i]);
+        room.setRoomBounds(osg::BoundingBox(f[0], f[1], f[2], f[3], f[4], f[5]));
+        fr += 7;
+    } else
+        return false;
+
+    return true;
+}
+
+bool SoundRoom_writeLocalData(const Object& obj, Output& fw)
+{
+    const SoundRoom &room = static_cast<const SoundRoom&>(obj);
+
+    const osg::BoundingBox& bb = room.getRoomBounds();
+    if (bb.valid())
+        fw.indent() << "roomBounds " << bb.xMin() << " " << bb.yMin() << " " << bb.zMin() << " "
+            << bb.xMax() << " " << bb.yMax() << " " << bb.zMax() << std::endl;
+
+    return true;
+}